@@ -0,0 +1,411 @@
+//
+// Benchmarks de la libreria: tiempo mediano, p99 entre muestras, GFLOP/s y GB/s por kernel.
+//
+// Cada muestra es el promedio por llamada de calls_per_sample llamadas seguidas (lo necesario
+// para que la muestra dure ~50 us). La mediana, el minimo y el p99 se toman sobre esos
+// promedios: el p99 (p99mean / p99_of_sample_mean_ns) mide la dispersion entre muestras, no la
+// latencia de cola de una llamada suelta, salvo cuando calls_per_sample es 1.
+//
+// Uso: CS2013_Tensor_Benchmark [--filter texto] [--min-time seg] [--threads n] [--json archivo]
+//   --filter    solo los benchmarks cuyo nombre contiene el texto
+//   --min-time  tiempo minimo de medicion por benchmark (por defecto 0.25 s)
+//   --threads   hilos del pool (parallel::set_num_threads)
+//   --json      escribe los resultados en JSON (use "-" para la salida estandar; la tabla
+//               pasa entonces a stderr para que stdout sea JSON valido)
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "include/Tensor.h"
+#include "include/TensorBlas.h"
+#include "include/TensorParallel.h"
+#include "include/TensorQuant.h"
+#include "include/TensorStatic.h"
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct Options {
+    std::string filter;
+    std::string json;
+    double min_time = 0.25;
+    std::size_t threads = 0;
+};
+
+struct Result {
+    std::string name;
+    std::size_t samples;
+    std::size_t inner;       // llamadas por muestra
+    double median_ns;
+    double p99_sample_mean_ns;   // p99 de los promedios por muestra
+    double min_ns;
+    double gflops;           // 0 si no aplica
+    double gbps;             // 0 si no aplica
+};
+
+// La tabla va a stdout salvo que el JSON ocupe la salida estandar.
+std::FILE* table_stream(const Options& opt) { return opt.json == "-" ? stderr : stdout; }
+
+// Evita que el compilador descarte resultados que no se usan.
+volatile double g_sink = 0;
+
+template <typename T>
+void consume(const BasicTensor<T>& t) { g_sink = g_sink + static_cast<double>(t.at(std::vector<std::size_t>(t.dims(), 0))); }
+
+class Runner {
+public:
+    explicit Runner(const Options& opt) : opt_(opt), table_(table_stream(opt)) {}
+
+    // flops y bytes son por llamada a fn (bytes = leidos + escritos).
+    void run(const std::string& name, double flops, double bytes, const std::function<void()>& fn) {
+        if (!opt_.filter.empty() && name.find(opt_.filter) == std::string::npos) return;
+
+        // Calentamiento y calibracion: cada muestra dura al menos ~50 us.
+        fn();
+        const double first = seconds(fn, 1);
+        const std::size_t inner = std::max<std::size_t>(1, static_cast<std::size_t>(50e-6 / std::max(first, 1e-9)));
+
+        std::vector<double> ns;
+        const Clock::time_point start = Clock::now();
+        while (ns.size() < 5 || (elapsed(start) < opt_.min_time && ns.size() < 10000)) {
+            ns.push_back(seconds(fn, inner) * 1e9 / static_cast<double>(inner));
+        }
+        std::sort(ns.begin(), ns.end());
+
+        Result r;
+        r.name = name;
+        r.samples = ns.size();
+        r.inner = inner;
+        r.median_ns = ns[ns.size() / 2];
+        r.p99_sample_mean_ns = ns[std::min(ns.size() - 1, static_cast<std::size_t>(std::ceil(0.99 * ns.size())) - 1)];
+        r.min_ns = ns.front();
+        r.gflops = flops > 0 ? flops / r.median_ns : 0;
+        r.gbps = bytes > 0 ? bytes / r.median_ns : 0;
+        results_.push_back(r);
+
+        std::fprintf(table_, "%-40s %12.3f %12.3f %9.2f %9.2f %7zu\n", name.c_str(), r.median_ns / 1e3,
+                     r.p99_sample_mean_ns / 1e3, r.gflops, r.gbps, r.samples);
+        std::fflush(table_);
+    }
+
+    void write_json(std::FILE* f) const {
+        std::fprintf(f, "{\n  \"library\": \"CS2013_Tensor_Library\",\n");
+        std::fprintf(f, "  \"threads\": %zu,\n", parallel::num_threads());
+#if defined(__AVX2__) && defined(__FMA__)
+        std::fprintf(f, "  \"simd\": \"avx2+fma\",\n");
+#else
+        std::fprintf(f, "  \"simd\": \"generic\",\n");
+#endif
+        std::fprintf(f, "  \"min_time_s\": %g,\n  \"results\": [\n", opt_.min_time);
+        for (std::size_t i = 0; i < results_.size(); ++i) {
+            const Result& r = results_[i];
+            std::fprintf(f, "    {\"name\": \"%s\", \"samples\": %zu, \"calls_per_sample\": %zu, "
+                            "\"median_ns\": %.1f, \"p99_of_sample_mean_ns\": %.1f, \"min_ns\": %.1f, "
+                            "\"gflops\": %.4f, \"gbps\": %.4f}%s\n",
+                         r.name.c_str(), r.samples, r.inner, r.median_ns, r.p99_sample_mean_ns, r.min_ns,
+                         r.gflops, r.gbps, i + 1 < results_.size() ? "," : "");
+        }
+        std::fprintf(f, "  ]\n}\n");
+    }
+
+private:
+    static double seconds(const std::function<void()>& fn, std::size_t n) {
+        const Clock::time_point t0 = Clock::now();
+        for (std::size_t i = 0; i < n; ++i) fn();
+        return std::chrono::duration<double>(Clock::now() - t0).count();
+    }
+
+    static double elapsed(Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    Options opt_;
+    std::FILE* table_;
+    std::vector<Result> results_;
+};
+
+std::string num(std::size_t v) { return std::to_string(v); }
+
+//
+//BENCHMARKS
+//
+
+template <typename T>
+void bench_matmul(Runner& r, const char* tname) {
+    const std::size_t square[] = {64, 128, 256, 512, 1024};
+    for (std::size_t n : square) {
+        const BasicTensor<T> a = BasicTensor<T>::random({n, n}, -1, 1), b = BasicTensor<T>::random({n, n}, -1, 1);
+        BasicTensor<T> c;
+        r.run(std::string("matmul/") + tname + "/" + num(n) + "x" + num(n) + "x" + num(n),
+              2.0 * n * n * n, 3.0 * n * n * sizeof(T), [&] { matmul(a, b, c); consume(c); });
+    }
+    // m x k x n de la red de main.cpp y formas rectangulares.
+    const std::size_t shapes[][3] = {{1000, 400, 100}, {1000, 100, 10}, {4096, 64, 4096}, {64, 4096, 64}, {1, 1024, 1024}};
+    for (const auto& s : shapes) {
+        const std::size_t m = s[0], k = s[1], n = s[2];
+        const BasicTensor<T> a = BasicTensor<T>::random({m, k}, -1, 1), b = BasicTensor<T>::random({k, n}, -1, 1);
+        BasicTensor<T> c;
+        r.run(std::string("matmul/") + tname + "/" + num(m) + "x" + num(k) + "x" + num(n),
+              2.0 * m * n * k, (m * k + k * n + m * n) * double(sizeof(T)), [&] { matmul(a, b, c); consume(c); });
+    }
+    {
+        const BasicTensor<T> a = BasicTensor<T>::random({1000, 400}, -1, 1), b = BasicTensor<T>::random({400, 100}, -1, 1);
+        const BasicTensor<T> a_t = BasicTensor<T>::random({400, 1000}, -1, 1).transpose();
+        BasicTensor<T> c;
+        r.run(std::string("matmul/") + tname + "/1000x400x100/a_transposed",
+              2.0 * 1000 * 400 * 100, (1000 * 400 + 400 * 100 + 1000 * 100) * double(sizeof(T)),
+              [&] { matmul(a_t, b, c); consume(c); });
+        const BasicTensor<T> bias = BasicTensor<T>::random({1, 100}, -1, 1);
+        ReLU relu;
+        r.run(std::string("linear/") + tname + "/1000x400x100/relu",
+              2.0 * 1000 * 400 * 100, (1000 * 400 + 400 * 100 + 1000 * 100) * double(sizeof(T)),
+              [&] { linear(a, b, bias, &relu, c); consume(c); });
+    }
+    {
+        const BasicTensor<T> a = BasicTensor<T>::random({64, 128, 64}, -1, 1), b = BasicTensor<T>::random({64, 64, 128}, -1, 1);
+        BasicTensor<T> c;
+        r.run(std::string("bmm/") + tname + "/64x(128x64x128)", 2.0 * 64 * 128 * 64 * 128,
+              64.0 * (128 * 64 * 3) * sizeof(T), [&] { bmm(a, b, c); consume(c); });
+    }
+}
+
+template <typename T>
+void bench_elementwise(Runner& r, const char* tname) {
+    const std::size_t rows = 1000, cols = 1000, n = rows * cols;
+    const BasicTensor<T> a = BasicTensor<T>::random({rows, cols}, -1, 1), b = BasicTensor<T>::random({rows, cols}, -1, 1),
+                         c = BasicTensor<T>::random({rows, cols}, -1, 1);
+    const BasicTensor<T> row = BasicTensor<T>::random({1, cols}, -1, 1), col = BasicTensor<T>::random({rows, 1}, -1, 1);
+    const double e = sizeof(T);
+    BasicTensor<T> out = BasicTensor<T>::zeros({rows, cols});
+    const std::string p = std::string("broadcast/") + tname + "/";
+
+    r.run(p + "a+b/1000x1000", n, 3 * n * e, [&] { out = a + b; consume(out); });
+    r.run(p + "a*2+b-c/1000x1000", 3.0 * n, 4 * n * e, [&] { out = a * 2.0 + b - c; consume(out); });
+    r.run(p + "a+row/1000x1000+1x1000", n, 2 * n * e, [&] { out = a + row; consume(out); });
+    r.run(p + "a+col/1000x1000+1000x1", n, 2 * n * e, [&] { out = a + col; consume(out); });
+    r.run(p + "a+=b/1000x1000", n, 3 * n * e, [&] { out += b; consume(out); });
+    {
+        const BasicTensor<T> x = BasicTensor<T>::random({64, 1, 256}, -1, 1), y = BasicTensor<T>::random({64, 256}, -1, 1);
+        BasicTensor<T> z;
+        r.run(p + "64x1x256+64x256", 64.0 * 64 * 256, 64.0 * 64 * 256 * e, [&] { z = x + y; consume(z); });
+    }
+    {
+        const BasicTensor<T> at = a.transpose();
+        r.run(p + "a.T+b/1000x1000", n, 3 * n * e, [&] { out = at + b; consume(out); });
+    }
+}
+
+template <typename T>
+void bench_apply(Runner& r, const char* tname) {
+    const std::size_t n = 1 << 20;
+    const BasicTensor<T> x = BasicTensor<T>::random({1024, 1024}, -4, 4);
+    BasicTensor<T> out;
+    ReLU relu;
+    Sigmoid sigmoid;
+    Tanh tanh_op;
+    GELU gelu;
+    SiLU silu;
+    const TensorTransform* ops[] = {&relu, &sigmoid, &tanh_op, &gelu, &silu};
+    const char* names[] = {"relu", "sigmoid", "tanh", "gelu", "silu"};
+    for (std::size_t i = 0; i < 5; ++i) {
+        const TensorTransform* op = ops[i];
+        r.run(std::string("apply/") + tname + "/" + names[i] + "/1024x1024", 0, 2.0 * n * sizeof(T),
+              [&] { x.apply(*op, out); consume(out); });
+    }
+}
+
+template <typename T>
+void bench_concat(Runner& r, const char* tname) {
+    std::vector<BasicTensor<T> > parts;
+    for (int i = 0; i < 4; ++i) parts.push_back(BasicTensor<T>::random({4096, 256}, -1, 1));
+    const double bytes = 2.0 * 4 * 4096 * 256 * sizeof(T);
+    BasicTensor<T> out0, out1;
+    r.run(std::string("concat/") + tname + "/4x(4096x256)/dim0", 0, bytes,
+          [&] { BasicTensor<T>::concat(parts, 0, out0); consume(out0); });
+    r.run(std::string("concat/") + tname + "/4x(4096x256)/dim1", 0, bytes,
+          [&] { BasicTensor<T>::concat(parts, 1, out1); consume(out1); });
+
+    std::vector<BasicTensor<T> > small;
+    for (int i = 0; i < 3; ++i) small.push_back(BasicTensor<T>::random({1000, 20, 8}, -1, 1));
+    BasicTensor<T> out2;
+    r.run(std::string("concat/") + tname + "/3x(1000x20x8)/dim2", 0, 2.0 * 3 * 1000 * 20 * 8 * sizeof(T),
+          [&] { BasicTensor<T>::concat(small, 2, out2); consume(out2); });
+}
+
+template <typename T>
+void bench_blas(Runner& r, const char* tname) {
+    const std::size_t sizes[] = {400, std::size_t(1) << 22};
+    for (std::size_t n : sizes) {
+        const BasicTensor<T> x = BasicTensor<T>::random({n}, -1, 1), y = BasicTensor<T>::random({n}, -1, 1);
+        const std::string p = std::string("dot/") + tname + "/" + num(n);
+        r.run(p + "/scalar", 2.0 * n, 2.0 * n * sizeof(T), [&] { g_sink = g_sink + blas::dot(x, y); });
+        r.run(p + "/tensor", 2.0 * n, 2.0 * n * sizeof(T), [&] { consume(dot(x, y)); });
+        r.run(std::string("nrm2/") + tname + "/" + num(n), 2.0 * n, n * double(sizeof(T)),
+              [&] { g_sink = g_sink + blas::nrm2(x); });
+    }
+}
+
+template <typename T>
+void bench_reduce(Runner& r, const char* tname) {
+    const BasicTensor<T> x = BasicTensor<T>::random({1000, 1000}, -1, 1);
+    const double bytes = 1e6 * sizeof(T);
+    const std::string p = std::string("reduce/") + tname + "/";
+    r.run(p + "sum/1000x1000/all", 1e6, bytes, [&] { g_sink = g_sink + x.sum(); });
+    r.run(p + "sum/1000x1000/dim0", 1e6, bytes, [&] { consume(x.sum(0)); });
+    r.run(p + "sum/1000x1000/dim1", 1e6, bytes, [&] { consume(x.sum(1)); });
+    r.run(p + "argmax/1000x1000/dim1", 1e6, bytes, [&] { consume(x.argmax(1)); });
+}
+
+template <typename T>
+void bench_factories(Runner& r, const char* tname) {
+    const std::vector<std::size_t> shape = {1000, 1000};
+    const double bytes = 1e6 * sizeof(T);
+    const std::string p = std::string("factory/") + tname + "/";
+    r.run(p + "zeros/1000x1000", 0, bytes, [&] { consume(BasicTensor<T>::zeros(shape)); });
+    r.run(p + "ones/1000x1000", 0, bytes, [&] { consume(BasicTensor<T>::ones(shape)); });
+    r.run(p + "random/1000x1000", 0, bytes, [&] { consume(BasicTensor<T>::random(shape, -1, 1)); });
+    r.run(p + "normal/1000x1000", 0, bytes, [&] { consume(BasicTensor<T>::normal(shape, 0, 1)); });
+    r.run(p + "arange/1000000", 0, bytes, [&] { consume(BasicTensor<T>::arange(0, 1000000)); });
+}
+
+// Un kernel propio (suma de una matriz) con cada forma de acceso a los elementos.
+template <typename T>
+void bench_access(Runner& r, const char* tname) {
+    const BasicTensor<T> x = BasicTensor<T>::random({512, 512}, -1, 1);
+    const BasicTensor<T> xt = x.transpose();
+    const double n = 512.0 * 512, bytes = n * sizeof(T);
+    const std::string p = std::string("access/") + tname + "/512x512/";
+    r.run(p + "at", n, bytes, [&] {
+        T s = 0;
+        for (std::size_t i = 0; i < 512; ++i)
+            for (std::size_t j = 0; j < 512; ++j) s += x.at(i, j);
+        g_sink = g_sink + static_cast<double>(s);
+    });
+    r.run(p + "unchecked", n, bytes, [&] {
+        T s = 0;
+        for (std::size_t i = 0; i < 512; ++i)
+            for (std::size_t j = 0; j < 512; ++j) s += x(i, j);
+        g_sink = g_sink + static_cast<double>(s);
+    });
+    r.run(p + "span", n, bytes, [&] {
+        T s = 0;
+        for (T v : x.span()) s += v;
+        g_sink = g_sink + static_cast<double>(s);
+    });
+    r.run(p + "iterator/transpose", n, bytes, [&] {
+        T s = 0;
+        for (T v : xt) s += v;
+        g_sink = g_sink + static_cast<double>(s);
+    });
+}
+
+// Tensores chicos (geometria 3x3 / 4x4): StaticTensor contra Tensor. Cada iteracion usa el
+// resultado de la anterior para que el compilador no saque el calculo del bucle.
+template <typename T, std::size_t N>
+void bench_small(Runner& r, const char* tname) {
+    const std::string p = std::string("small/") + tname + "/" + num(N) + "x" + num(N) + "/";
+    const StaticTensor<T, N, N> sb = StaticTensor<T, N, N>::full(T(1) / N);
+    StaticTensor<T, N, N> sc = StaticTensor<T, N, N>::ones();
+    const BasicTensor<T> b = sb.tensor();
+    BasicTensor<T> c = sc.tensor();
+    const double flops = 2.0 * N * N * N, bytes = 3.0 * N * N * sizeof(T);
+    r.run(p + "matmul/static", flops, bytes, [&] { sc = matmul(sc, sb); });
+    r.run(p + "matmul/tensor", flops, bytes, [&] { c = matmul(c, b); });
+    r.run(p + "add/static", double(N * N), bytes, [&] { sc = sc + sb; });
+    r.run(p + "add/tensor", double(N * N), bytes, [&] { c = c + b; });
+    g_sink = g_sink + static_cast<double>(sc[0]);
+    consume(c);
+}
+
+// Capa de main.cpp (1000x400 * 400x100 + bias, ReLU) en int8 contra linear en punto flotante.
+template <typename T>
+void bench_quant(Runner& r, const char* tname) {
+    const std::size_t m = 1000, k = 400, n = 100;
+    const std::string p = std::string("quant/") + tname + "/";
+    const BasicTensor<T> x = BasicTensor<T>::random({m, k}, 1, 20), w = BasicTensor<T>::random({k, n}, -0.5, 0.5);
+    const BasicTensor<T> b = BasicTensor<T>::random({1, n}, -0.1, 0.1);
+    ReLU relu;
+    const quant::QLinear<T> layer(w, b, &relu);
+    const quant::QTensor xq = quant::quantize(x, quant::Axis::Row);
+    const double flops = 2.0 * m * n * k;
+    BasicTensor<T> out;
+    r.run(p + "quantize/1000x400/row", double(m * k), m * k * (sizeof(T) + 1.0),
+          [&] { g_sink = g_sink + quant::quantize(x, quant::Axis::Row).at(0, 0); });
+    r.run(p + "linear/1000x400x100/relu", flops, m * k * double(sizeof(T)) + layer.weight_bytes() + m * n * double(sizeof(T)),
+          [&] { layer.forward(x, out); consume(out); });
+    r.run(p + "linear/1000x400x100/relu/prequantized", flops, double(m * k) + layer.weight_bytes() + m * n * double(sizeof(T)),
+          [&] { layer.forward(xq, out); consume(out); });
+}
+
+template <typename T>
+void bench_all(Runner& r, const char* tname) {
+    bench_matmul<T>(r, tname);
+    bench_quant<T>(r, tname);
+    bench_elementwise<T>(r, tname);
+    bench_apply<T>(r, tname);
+    bench_concat<T>(r, tname);
+    bench_blas<T>(r, tname);
+    bench_reduce<T>(r, tname);
+    bench_access<T>(r, tname);
+    bench_small<T, 3>(r, tname);
+    bench_small<T, 4>(r, tname);
+    bench_factories<T>(r, tname);
+}
+
+Options parse_args(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        const std::string a = argv[i];
+        if (i + 1 >= argc) throw std::invalid_argument("falta el valor de " + a);
+        const std::string v = argv[++i];
+        if (a == "--filter") opt.filter = v;
+        else if (a == "--json") opt.json = v;
+        else if (a == "--min-time") opt.min_time = std::atof(v.c_str());
+        else if (a == "--threads") opt.threads = static_cast<std::size_t>(std::atol(v.c_str()));
+        else throw std::invalid_argument("opcion desconocida: " + a);
+    }
+    return opt;
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    try {
+        opt = parse_args(argc, argv);
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "%s\nuso: %s [--filter texto] [--min-time seg] [--threads n] [--json archivo]\n",
+                     e.what(), argv[0]);
+        return 2;
+    }
+    if (opt.threads > 0) parallel::set_num_threads(opt.threads);
+    rng::manual_seed(0);
+
+    std::FILE* table = table_stream(opt);
+    std::fprintf(table, "threads: %zu\n", parallel::num_threads());
+    std::fprintf(table, "%-40s %12s %12s %9s %9s %7s\n", "benchmark", "median(us)", "p99mean(us)", "GFLOP/s", "GB/s", "samples");
+
+    Runner runner(opt);
+    bench_all<double>(runner, "f64");
+    bench_all<float>(runner, "f32");
+
+    if (!opt.json.empty()) {
+        std::FILE* f = opt.json == "-" ? stdout : std::fopen(opt.json.c_str(), "w");
+        if (f == nullptr) {
+            std::fprintf(stderr, "no se pudo abrir %s\n", opt.json.c_str());
+            return 1;
+        }
+        runner.write_json(f);
+        if (f != stdout) std::fclose(f);
+    }
+    return 0;
+}
@@ -4,94 +4,429 @@
 
 #ifndef CS2013_TENSOR_LIBRARY_TENSOR_H
 #define CS2013_TENSOR_LIBRARY_TENSOR_H
+#include <stdexcept>
+#include <string>
+#include <memory>
+#include <utility>
 #include <vector>
+#include "TensorAllocator.h"
+#include "TensorShape.h"
+#include "TensorRandom.h"
 #include "TensorTransform.h"
+#include "TensorExpr.h"
 
 
+//
+// BasicTensor<T>: T es el tipo de elemento (float o double).
+// Tensor es el alias de doble precision que usa el resto de la libreria.
+//
+
+template <typename T> class BasicTensor;
+
+template <typename T> BasicTensor<T> dot(const BasicTensor<T>& a, const BasicTensor<T>& b);
+template <typename T> BasicTensor<T> matmul(const BasicTensor<T>& a, const BasicTensor<T>& b);
+template <typename T> BasicTensor<T> bmm(const BasicTensor<T>& a, const BasicTensor<T>& b);
+template <typename T> BasicTensor<T> linear(const BasicTensor<T>& x, const BasicTensor<T>& w,
+                                            const BasicTensor<T>& b, const TensorTransform* act);
+
+template <typename T> BasicTensor<T>& matmul(const BasicTensor<T>& a, const BasicTensor<T>& b, BasicTensor<T>& out);
+template <typename T> BasicTensor<T>& bmm(const BasicTensor<T>& a, const BasicTensor<T>& b, BasicTensor<T>& out);
+template <typename T> BasicTensor<T>& linear(const BasicTensor<T>& x, const BasicTensor<T>& w,
+                                             const BasicTensor<T>& b, const TensorTransform* act,
+                                             BasicTensor<T>& out);
+
+// BLAS nivel 1 sobre tensores (TensorBlas.cpp): devuelven el escalar sin crear tensores.
+// Las shapes de x e y tienen que ser iguales; se recorren en orden row-major.
+namespace blas {
+template <typename T> T dot (const BasicTensor<T>& x, const BasicTensor<T>& y);
+template <typename T> T nrm2(const BasicTensor<T>& x);
+template <typename T> T asum(const BasicTensor<T>& x);
+template <typename T> void axpy(double alpha, const BasicTensor<T>& x, BasicTensor<T>& y);   // y += alpha * x
+template <typename T> void scal(double alpha, BasicTensor<T>& x);                            // x *= alpha
+}
+
+namespace graph { template <typename T> class Graph; }
+namespace quant { template <typename T> class QLinear; }
+template <typename T, std::size_t... Dims> class StaticTensor;
 
-class Tensor {
 
-    std::vector<std::size_t> shape_;
-    std::vector<std::size_t> strides_;
+template <typename T>
+class BasicTensor : public TensorExpr<BasicTensor<T> > {
+
+    TensorShape shape_;
+    TensorShape strides_;
     std::size_t size_ = 0;
-    double* data_ = nullptr;
+    // storage_ es el buffer compartido (con contador de referencias) por todas las vistas;
+    // data_ apunta al elemento (0, ..., 0) de esta vista dentro de el.
+    std::shared_ptr<T> storage_;
+    T* data_ = nullptr;
 
-    static std::size_t product(const std::vector<std::size_t>& shape);
-    void validate_shape_or_throw(const std::vector<std::size_t>& shape)const;
+    static std::size_t product(const TensorShape& shape);
+    void validate_shape_or_throw(const TensorShape& shape)const;
     void compute_strides();
+    // data_ <- size_ elementos nuevos del allocator por defecto (alineados a 64 B);
+    // release_data suelta la referencia a storage_.
+    void allocate_data();
+    void release_data();
+    // true si se puede escribir en data_ sin afectar a otra vista.
+    bool owns_buffer() const;
+    BasicTensor share_with(const TensorShape& shape,
+                           const TensorShape& strides, std::size_t offset) const;
+
+    enum class ReduceKind { Sum, Mean, Max, Min, ArgMax };
+    BasicTensor reduce_dim(std::size_t dim, bool keepdim, ReduceKind kind, const char* fn) const;
+    // Destino de las variantes con `out`: si esta vacio se reserva con `shape`; si no,
+    // su shape tiene que ser exactamente `shape` y se reutiliza su buffer.
+    void prepare_out_or_throw(const TensorShape& shape, const char* fn);
+    static TensorShape concat_shape_or_throw(const std::vector<BasicTensor>& tensors,
+                                                          std::size_t dim, const char* fn);
+    static void concat_copy(const std::vector<BasicTensor>& tensors, std::size_t dim, BasicTensor& out);
+    template <typename E> BasicTensor& assign_inplace(const E& e, const char* fn);
 
 
+    // *this como vector plano de elementos separados por inc (sin copiar si es contiguo o 1D;
+    // si no, a traves de una copia contigua guardada en tmp).
+    const T* vector_data(std::size_t& inc, BasicTensor& tmp) const;
+
     std::size_t offset(std::size_t i) const;
     std::size_t offset(std::size_t i, std::size_t j) const;
     std::size_t offset(std::size_t i, std::size_t j, std::size_t k) const;
+    std::size_t offset(const std::vector<std::size_t>& idx) const;
 
-    static std::vector<std::size_t> broadcast_shape_or_throw(
-    const std::vector<std::size_t>& a,
-    const std::vector<std::size_t>& b );
+    friend class expr::TensorLeaf<T>;
 
 public:
+    typedef T value_type;
+
+    static TensorShape broadcast_shape_or_throw(
+    const TensorShape& a,
+    const TensorShape& b );
+
     //
     //CONSTRUCTORES
     //
-    Tensor();
-    Tensor(const std::vector<std::size_t>& shape_, const std::vector<double>& values);
-    Tensor(const Tensor& other);
-    Tensor(Tensor&& other) noexcept;
-    Tensor& operator=(const Tensor& other);
-    Tensor& operator=(Tensor&& other) noexcept;
-    ~Tensor();
+    BasicTensor();
+    BasicTensor(const TensorShape& shape_, const std::vector<T>& values);
+    BasicTensor(const BasicTensor& other);
+    BasicTensor(BasicTensor&& other) noexcept;
+    BasicTensor& operator=(const BasicTensor& other);
+    BasicTensor& operator=(BasicTensor&& other) noexcept;
+    ~BasicTensor();
+
+    // Materializa una expresion (a + b, a * 2.0, ...) en un unico bucle.
+    template <typename E> BasicTensor(const TensorExpr<E>& e);
+    template <typename E> BasicTensor& operator=(const TensorExpr<E>& e);
+
+    // En el lugar: el resultado del broadcast tiene que tener la shape de *this.
+    template <typename E> BasicTensor& operator+=(const TensorExpr<E>& e);
+    template <typename E> BasicTensor& operator-=(const TensorExpr<E>& e);
+    template <typename E> BasicTensor& operator*=(const TensorExpr<E>& e);
+    BasicTensor& operator*=(double scalar);
+    // Escribe el resultado en *this sin reservar memoria: tiene que tener la shape de *this,
+    // que puede ser una vista. Igual que en +=, *this puede aparecer en la expresion.
+    template <typename E> BasicTensor& assign(const TensorExpr<E>& e);
 
 
-    const std::vector<std::size_t>& shape() const {return shape_;}
+    const TensorShape& shape() const {return shape_;}
     std::size_t dims() const {return shape_.size();}
     std::size_t numel() const {return size_;}
+    // En elementos; el elemento idx esta en data() + sum(idx[d] * strides()[d]).
+    const TensorShape& strides() const {return strides_;}
 
-    double& at(std::size_t i);
-    double& at(std::size_t i, std::size_t j);
-    double& at(std::size_t i, std::size_t j, std::size_t k);
+    T& at(std::size_t i);
+    T& at(std::size_t i, std::size_t j);
+    T& at(std::size_t i, std::size_t j, std::size_t k);
 
-    const double& at(std::size_t i) const;
-    const double& at(std::size_t i, std::size_t j) const;
-    const double& at(std::size_t i, std::size_t j, std::size_t k) const;
+    const T& at(std::size_t i) const;
+    const T& at(std::size_t i, std::size_t j) const;
+    const T& at(std::size_t i, std::size_t j, std::size_t k) const;
+
+    // Cualquier cantidad de dimensiones: idx.size() == dims().
+    T& at(const std::vector<std::size_t>& idx);
+    const T& at(const std::vector<std::size_t>& idx) const;
+
+    //
+    //ACCESO SIN VALIDAR: no revisa la cantidad de indices ni el rango (para kernels propios)
+    //
+    T& operator()(std::size_t i) { return data_[i * strides_[0]]; }
+    T& operator()(std::size_t i, std::size_t j) { return data_[i * strides_[0] + j * strides_[1]]; }
+    T& operator()(std::size_t i, std::size_t j, std::size_t k) {
+        return data_[i * strides_[0] + j * strides_[1] + k * strides_[2]];
+    }
+    const T& operator()(std::size_t i) const { return data_[i * strides_[0]]; }
+    const T& operator()(std::size_t i, std::size_t j) const { return data_[i * strides_[0] + j * strides_[1]]; }
+    const T& operator()(std::size_t i, std::size_t j, std::size_t k) const {
+        return data_[i * strides_[0] + j * strides_[1] + k * strides_[2]];
+    }
+
+    // Elemento (0, ..., 0) de la vista (nullptr si esta vacio).
+    T* data() { return data_; }
+    const T* data() const { return data_; }
+    // Los numel() elementos como arreglo contiguo row-major; si la vista no es contigua lanza
+    // std::invalid_argument (usar contiguous()).
+    iter::Span<T> span();
+    iter::Span<const T> span() const;
+
+    // Recorrido row-major de cualquier vista (iteradores de acceso aleatorio: sirven con los
+    // algoritmos de <algorithm> y, en C++17, con las politicas de ejecucion de <execution>).
+    // Siguen validos mientras viva el buffer, aunque el Tensor se mueva.
+    typedef iter::StridedIterator<T> iterator;
+    typedef iter::StridedIterator<const T> const_iterator;
+    iterator begin() { return iterator(data_, shape_, strides_, 0); }
+    iterator end() { return iterator(data_, shape_, strides_, size_); }
+    const_iterator begin() const { return const_iterator(data_, shape_, strides_, 0); }
+    const_iterator end() const { return const_iterator(data_, shape_, strides_, size_); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
 
     //
     //METODOS
     //
     void imprimir() const;
 
-    static Tensor zeros (const std::vector<std::size_t>& shape);
-    static Tensor ones  (const std::vector<std::size_t>& shape);
-    static Tensor random(const std::vector<std::size_t>& shape, double min, double max);
-    static Tensor arange(long long start, long long end);
+    static BasicTensor zeros (const TensorShape& shape);
+    static BasicTensor ones  (const TensorShape& shape);
+    // Aleatorios con rng::Generator (TensorRandom.h): misma semilla, mismo tensor bit a bit.
+    static BasicTensor random(const TensorShape& shape, T min, T max,
+                              rng::Generator& gen = rng::default_generator());    // uniforme en [min, max)
+    static BasicTensor normal(const TensorShape& shape, T mean, T stddev,
+                              rng::Generator& gen = rng::default_generator());
+    // Pesos (fan_in x fan_out) de x * W: fan_out = ultima dim, fan_in = numel / fan_out.
+    static BasicTensor xavier_uniform(const TensorShape& shape,
+                                      rng::Generator& gen = rng::default_generator());
+    static BasicTensor he_normal(const TensorShape& shape,
+                                 rng::Generator& gen = rng::default_generator());
+    static BasicTensor arange(long long start, long long end);
 
-    Tensor view(const std::vector<std::size_t>& new_shape);
-    Tensor unsqueeze(std::size_t dim);
+    //
+    //VISTAS: comparten storage_ con *this (no copian; escribir en una se ve en la otra)
+    //
+    BasicTensor view(const TensorShape& new_shape) const;   // requiere contiguo
+    BasicTensor unsqueeze(std::size_t dim) const;
+    BasicTensor slice(std::size_t dim, std::size_t begin, std::size_t end) const;
+    BasicTensor transpose(std::size_t dim0, std::size_t dim1) const;
+    BasicTensor transpose() const;                                       // ultimas dos dims
+    BasicTensor permute(const std::vector<std::size_t>& order) const;
 
-    static Tensor concat(const std::vector<Tensor>& tensors, std::size_t dim);
+    bool is_contiguous() const;
+    // *this si ya es contiguo (compartido); si no, una copia contigua.
+    BasicTensor contiguous() const;
+    bool shares_storage(const BasicTensor& other) const { return storage_ && storage_ == other.storage_; }
 
     //
-    //Friends
+    //ARCHIVOS .tensor (TensorIO.cpp; formato en TensorIO.h). Los errores de E/S y de formato
+    //lanzan std::runtime_error.
     //
+    void save(const std::string& path) const;
+    // Lee el archivo a memoria propia y verifica el checksum.
+    static BasicTensor load(const std::string& path);
+    // Mapea el archivo (MAP_PRIVATE) y usa esas paginas como storage, sin copiar: los datos se
+    // leen del disco al tocarlos. Escribir en el tensor no modifica el archivo. Sin mmap
+    // (Windows) equivale a load.
+    static BasicTensor mmap_load(const std::string& path, bool verify_checksum = false);
 
-    friend Tensor dot(const Tensor& a, const Tensor& b);
-    friend Tensor matmul(const Tensor& a, const Tensor& b);
+    static BasicTensor concat(const std::vector<BasicTensor>& tensors, std::size_t dim);
+    static BasicTensor& concat(const std::vector<BasicTensor>& tensors, std::size_t dim, BasicTensor& out);
+    // Escribe en un tensor existente con la shape del resultado, que puede ser una vista
+    // (p. ej. un slice de un buffer de batch mas grande); nunca reserva memoria.
+    static BasicTensor& concat_into(const std::vector<BasicTensor>& tensors, std::size_t dim, BasicTensor& out);
 
     //
-    //Sobrecarga de operadores
+    //Friends
     //
 
-    Tensor operator+(const Tensor& other) const;
-    Tensor operator-(const Tensor& other) const;
-    Tensor operator*(const Tensor& other) const;
-    Tensor operator*(double scalar) const;
+    template <typename U> friend BasicTensor<U> dot(const BasicTensor<U>& a, const BasicTensor<U>& b);
+    template <typename U> friend BasicTensor<U> matmul(const BasicTensor<U>& a, const BasicTensor<U>& b);
+    template <typename U> friend BasicTensor<U> bmm(const BasicTensor<U>& a, const BasicTensor<U>& b);
+    // act(x * w + b) en una sola pasada; act puede ser nullptr.
+    template <typename U> friend BasicTensor<U> linear(const BasicTensor<U>& x, const BasicTensor<U>& w,
+                                                       const BasicTensor<U>& b, const TensorTransform* act);
+
+    // Variantes que escriben en `out` (ver prepare_out_or_throw); out no puede ser una entrada.
+    template <typename U> friend BasicTensor<U>& matmul(const BasicTensor<U>& a, const BasicTensor<U>& b, BasicTensor<U>& out);
+    template <typename U> friend BasicTensor<U>& bmm(const BasicTensor<U>& a, const BasicTensor<U>& b, BasicTensor<U>& out);
+    template <typename U> friend BasicTensor<U>& linear(const BasicTensor<U>& x, const BasicTensor<U>& w,
+                                                        const BasicTensor<U>& b, const TensorTransform* act,
+                                                        BasicTensor<U>& out);
+
+    template <typename U> friend U blas::dot(const BasicTensor<U>& x, const BasicTensor<U>& y);
+    template <typename U> friend U blas::nrm2(const BasicTensor<U>& x);
+    template <typename U> friend U blas::asum(const BasicTensor<U>& x);
+    template <typename U> friend void blas::axpy(double alpha, const BasicTensor<U>& x, BasicTensor<U>& y);
+    template <typename U> friend void blas::scal(double alpha, BasicTensor<U>& x);
+
+    // Los kernels fusionados del grafo recorren los buffers directamente (TensorGraph.cpp).
+    friend class graph::Graph<T>;
+    // La salida de las capas int8 se escribe con el epilogo del kernel (TensorQuant.cpp).
+    friend class quant::QLinear<T>;
+    // Conversiones de StaticTensor (TensorStatic.h).
+    template <typename U, std::size_t... D> friend class StaticTensor;
+
+    //
+    //Sobrecarga de operadores: ver TensorExpr.h (+, -, * devuelven expresiones perezosas)
+    //
 
     //Polimorfismo
-    Tensor apply(const TensorTransform& op) const;
+    BasicTensor apply(const TensorTransform& op) const;
+    BasicTensor& apply(const TensorTransform& op, BasicTensor& out) const;
+    BasicTensor& apply_inplace(const TensorTransform& op);
+
+    //
+    //REDUCCIONES (TensorReduce.cpp)
+    //
+    // Sobre la dimension dim; con keepdim esa dimension queda con tamaño 1. Si el resultado se
+    // queda sin dimensiones (1D sin keepdim) tiene shape (1). argmax guarda los indices como T
+    // (el primero si hay empates). max/min/argmax no propagan NaN.
+    BasicTensor sum   (std::size_t dim, bool keepdim = false) const;
+    BasicTensor mean  (std::size_t dim, bool keepdim = false) const;
+    BasicTensor max   (std::size_t dim, bool keepdim = false) const;
+    BasicTensor min   (std::size_t dim, bool keepdim = false) const;
+    BasicTensor argmax(std::size_t dim, bool keepdim = false) const;
+
+    // Sobre todos los elementos; argmax() es el indice plano en orden row-major.
+    T sum() const;
+    T mean() const;
+    T max() const;
+    T min() const;
+    std::size_t argmax() const;
 
 };
 
+typedef BasicTensor<double> DoubleTensor;
+typedef BasicTensor<float>  FloatTensor;
+typedef DoubleTensor        Tensor;
+
+// Instanciadas en Tensor.cpp
+extern template class BasicTensor<float>;
+extern template class BasicTensor<double>;
+
+//
+//OPERACIONES CON EXPRESIONES: matmul(a + b, W) evalua a + b y llama a la version de Tensor
+//
+// Con dos Tensor gana la sobrecarga de arriba (no hay conversion a la base).
+//
+
+template <typename L, typename R>
+BasicTensor<typename L::value_type> matmul(const TensorExpr<L>& a, const TensorExpr<R>& b) {
+    static_assert(std::is_same<typename L::value_type, typename R::value_type>::value,
+                  "matmul: no se pueden mezclar tipos de elemento");
+    return matmul(expr::materialize(a), expr::materialize(b));
+}
+
+template <typename L, typename R>
+BasicTensor<typename L::value_type> bmm(const TensorExpr<L>& a, const TensorExpr<R>& b) {
+    static_assert(std::is_same<typename L::value_type, typename R::value_type>::value,
+                  "bmm: no se pueden mezclar tipos de elemento");
+    return bmm(expr::materialize(a), expr::materialize(b));
+}
+
+template <typename L, typename R>
+BasicTensor<typename L::value_type> dot(const TensorExpr<L>& a, const TensorExpr<R>& b) {
+    static_assert(std::is_same<typename L::value_type, typename R::value_type>::value,
+                  "dot: no se pueden mezclar tipos de elemento");
+    return dot(expr::materialize(a), expr::materialize(b));
+}
+
+template <typename X, typename W, typename B>
+BasicTensor<typename X::value_type> linear(const TensorExpr<X>& x, const TensorExpr<W>& w,
+                                           const TensorExpr<B>& b, const TensorTransform* act) {
+    static_assert(std::is_same<typename X::value_type, typename W::value_type>::value &&
+                  std::is_same<typename X::value_type, typename B::value_type>::value,
+                  "linear: no se pueden mezclar tipos de elemento");
+    return linear(expr::materialize(x), expr::materialize(w), expr::materialize(b), act);
+}
+
+
+//
+//EXPRESIONES: evaluacion en un BasicTensor
+//
+
+template <typename T>
+template <typename E>
+BasicTensor<T>::BasicTensor(const TensorExpr<E>& e) : BasicTensor() {
+    *this = e;
+}
+
+template <typename T>
+template <typename E>
+BasicTensor<T>& BasicTensor<T>::operator=(const TensorExpr<E>& e) {
+    const E& ex = e.self();
+    const TensorShape& out_shape = ex.shape();
+    TENSOR_PROFILE_SCOPE("elementwise");
+    TENSOR_PROFILE_EXPR(ex);
+
+    // Misma shape y buffer propio: se reutiliza (cada posicion se lee antes de escribirse).
+    if (!owns_buffer() || shape_ != out_shape) {
+        validate_shape_or_throw(out_shape);
+        BasicTensor r;
+        r.shape_ = out_shape;
+        r.size_ = product(out_shape);
+        r.compute_strides();
+        r.allocate_data();
+        expr::evaluate(ex, r.data_);
+        return *this = std::move(r);
+    }
+    expr::evaluate(ex, data_);
+    return *this;
+}
+
+// Cada posicion de *this se lee antes de escribirse, asi que *this puede aparecer en la
+// expresion. Si otra hoja comparte el buffer con otro layout u offset (x += x.transpose(),
+// a.slice(0, 1, 4) += a.slice(0, 0, 3)) se evalua en un temporal y se copia al final.
+// Si *this es una vista, se escribe en el buffer compartido.
+template <typename T>
+template <typename E>
+BasicTensor<T>& BasicTensor<T>::assign_inplace(const E& e, const char* fn) {
+    if (e.shape() != shape_) {
+        throw std::invalid_argument(std::string(fn) + ": el resultado debe tener la shape del tensor");
+    }
+    TENSOR_PROFILE_SCOPE(fn);
+    TENSOR_PROFILE_EXPR(e);
+    expr::Operand<T> ops[E::leaves];
+    e.collect(ops);
+    bool overlap = false;
+    for (std::size_t i = 0; i < E::leaves && !overlap; ++i) {
+        const BasicTensor& t = *ops[i].tensor;
+        overlap = shares_storage(t) && (t.data_ != data_ || t.shape_ != shape_ || t.strides_ != strides_);
+    }
+    if (!overlap) {
+        expr::evaluate(e, data_, &strides_);
+        return *this;
+    }
+    BasicTensor tmp;
+    tmp.shape_ = shape_;
+    tmp.size_ = size_;
+    tmp.compute_strides();
+    tmp.allocate_data();
+    expr::evaluate(e, tmp.data_);
+    expr::evaluate(expr::TensorLeaf<T>(tmp), data_, &strides_);
+    return *this;
+}
+
+template <typename T>
+template <typename E>
+BasicTensor<T>& BasicTensor<T>::assign(const TensorExpr<E>& e) {
+    return assign_inplace(expr::as_leaf(e), "Tensor::assign");
+}
+
+template <typename T>
+template <typename E>
+BasicTensor<T>& BasicTensor<T>::operator+=(const TensorExpr<E>& e) {
+    return assign_inplace(*this + e, "Tensor::operator+=");
+}
+
+template <typename T>
+template <typename E>
+BasicTensor<T>& BasicTensor<T>::operator-=(const TensorExpr<E>& e) {
+    return assign_inplace(*this - e, "Tensor::operator-=");
+}
 
+template <typename T>
+template <typename E>
+BasicTensor<T>& BasicTensor<T>::operator*=(const TensorExpr<E>& e) {
+    return assign_inplace(*this * e, "Tensor::operator*=");
+}
 
 
 
-#endif //CS2013_TENSOR_LIBRARY_TENSOR_H
\ No newline at end of file
+#endif //CS2013_TENSOR_LIBRARY_TENSOR_H
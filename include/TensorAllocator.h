@@ -0,0 +1,89 @@
+#ifndef CS2013_TENSOR_LIBRARY_TENSORALLOCATOR_H
+#define CS2013_TENSOR_LIBRARY_TENSORALLOCATOR_H
+#include <cstddef>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+//
+//ALLOCATORS PARA EL BUFFER DE LOS TENSORES
+//
+// Todo bloque devuelto esta alineado a TENSOR_ALIGNMENT bytes (una linea de cache, apto para
+// cargas AVX/AVX-512 alineadas). Cada Tensor recuerda el allocator que creo su buffer y lo
+// devuelve al mismo: un allocator propio tiene que vivir mas que los tensores que crea.
+//
+
+const std::size_t TENSOR_ALIGNMENT = 64;
+
+class TensorAllocator {
+public:
+    virtual void* allocate(std::size_t bytes) = 0;
+    // bytes es el mismo valor que se paso a allocate.
+    virtual void deallocate(void* p, std::size_t bytes) = 0;
+    virtual ~TensorAllocator() = default;
+};
+
+// Reserva y libera directamente (aligned malloc), sin cache.
+class AlignedAllocator : public TensorAllocator {
+public:
+    void* allocate(std::size_t bytes) override;
+    void deallocate(void* p, std::size_t bytes) override;
+};
+
+struct PoolStats {
+    std::size_t hits = 0;            // allocate servidos desde la cache
+    std::size_t misses = 0;          // allocate que tuvieron que pedir memoria al sistema
+    std::size_t bytes_in_use = 0;    // entregados y aun no devueltos (por clase de tamaño)
+    std::size_t bytes_cached = 0;    // libres dentro del pool
+    std::size_t peak_bytes = 0;      // maximo de bytes_in_use + bytes_cached
+};
+
+//
+//POOL CON CACHE POR CLASE DE TAMAÑO
+//
+// Cada peticion se redondea a una clase (multiplo de 64 B hasta 4 KiB; luego 8 clases por
+// potencia de dos, <= 12.5% de desperdicio) y los bloques devueltos quedan en la lista libre
+// de su clase. Si las shapes se repiten, tras la primera iteracion todo allocate es un pop.
+// Bloques >= huge_page_bytes se piden con mmap + MADV_HUGEPAGE (Linux; 0 lo desactiva).
+// Si la cache supera max_cached_bytes, los bloques devueltos se liberan en vez de guardarse.
+//
+
+class PoolAllocator : public TensorAllocator {
+public:
+    explicit PoolAllocator(std::size_t max_cached_bytes = std::size_t(1) << 30,
+                           std::size_t huge_page_bytes = std::size_t(2) << 20);
+    ~PoolAllocator() override;
+
+    PoolAllocator(const PoolAllocator&) = delete;
+    PoolAllocator& operator=(const PoolAllocator&) = delete;
+
+    void* allocate(std::size_t bytes) override;
+    void deallocate(void* p, std::size_t bytes) override;
+
+    // Devuelve al sistema todos los bloques libres.
+    void release_cached();
+    PoolStats stats() const;
+    void reset_stats();
+
+    static std::size_t size_class(std::size_t bytes);
+
+private:
+    void* system_allocate(std::size_t cls);
+    void system_deallocate(void* p, std::size_t cls);
+
+    const std::size_t max_cached_;
+    const std::size_t huge_page_bytes_;
+    mutable std::mutex m_;
+    std::unordered_map<std::size_t, std::vector<void*> > free_;
+    PoolStats stats_;
+};
+
+// Allocator que usan los tensores nuevos. Por defecto un PoolAllocator global;
+// set_default_allocator(nullptr) vuelve a ese pool.
+TensorAllocator& default_allocator();
+void set_default_allocator(TensorAllocator* alloc);
+
+// El PoolAllocator global (para consultar estadisticas o vaciarlo).
+PoolAllocator& default_pool();
+
+#endif //CS2013_TENSOR_LIBRARY_TENSORALLOCATOR_H
@@ -0,0 +1,147 @@
+#ifndef CS2013_TENSOR_LIBRARY_TENSORAUTOGRAD_H
+#define CS2013_TENSOR_LIBRARY_TENSORAUTOGRAD_H
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <vector>
+#include "Tensor.h"
+
+//
+//AUTOGRAD EN MODO REVERSO
+//
+// Tape<T> guarda en orden cada operacion hecha sobre Var<T> (valor + como propagar el
+// gradiente a sus entradas). backward(loss) recorre la cinta al reves acumulando dL/dx; los
+// gradientes intermedios se liberan en cuanto se propagan y solo quedan los de las hojas.
+// Las operaciones con broadcast reducen el gradiente a la shape de cada entrada (p. ej. el
+// bias (1 x n) recibe la suma por filas).
+//
+// checkpoint(inputs, fn) ejecuta un tramo sin guardar sus activaciones intermedias y lo
+// vuelve a calcular durante backward: la memoria de activaciones pasa a ser la de las
+// entradas y salidas de cada tramo, a cambio de un forward extra por tramo.
+//
+// Instanciado para float y double.
+//
+
+namespace autograd {
+
+template <typename T> class Tape;
+
+// Referencia a un valor de una Tape (la Tape tiene que vivir mientras se use).
+template <typename T>
+class Var {
+public:
+    Var() : tape_(nullptr), id_(0) {}
+
+    const BasicTensor<T>& value() const;
+    // dL/dvalue tras backward; solo se conserva en las hojas (vacio si no llego gradiente).
+    const BasicTensor<T>& grad() const;
+    const TensorShape& shape() const { return value().shape(); }
+    bool requires_grad() const;
+
+    Tape<T>* tape() const { return tape_; }
+    std::size_t id() const { return id_; }
+
+private:
+    friend class Tape<T>;
+    Var(Tape<T>* tape, std::size_t id) : tape_(tape), id_(id) {}
+
+    Tape<T>* tape_;
+    std::size_t id_;
+};
+
+template <typename T>
+class Tape {
+public:
+    // Recibe g = dL/d(valor del nodo) y acumula en las entradas con tape.accumulate.
+    typedef std::function<void(Tape& tape, const BasicTensor<T>& g)> BackwardFn;
+    // Tramo para checkpoint: solo puede usar las Var que recibe (de la Tape que recibe).
+    typedef std::function<Var<T>(Tape& tape, const std::vector<Var<T> >& inputs)> Segment;
+
+    Tape() {}
+    Tape(const Tape&) = delete;
+    Tape& operator=(const Tape&) = delete;
+
+    // Entrada o parametro. Si value es contiguo se comparte su buffer (no se copia), asi que
+    // no hay que modificarlo mientras la cinta lo use.
+    Var<T> leaf(const BasicTensor<T>& value, bool requires_grad = true);
+    Var<T> constant(const BasicTensor<T>& value) { return leaf(value, false); }
+
+    // fn(tape, inputs) se ejecuta sin guardar sus activaciones intermedias; durante backward
+    // se ejecuta otra vez (tiene que ser determinista) para obtener los gradientes.
+    Var<T> checkpoint(const std::vector<Var<T> >& inputs, const Segment& fn);
+
+    // out tiene que tener un solo elemento (semilla 1).
+    void backward(const Var<T>& out);
+    void backward(const Var<T>& out, const BasicTensor<T>& grad_out);
+
+    // Borra los gradientes acumulados en las hojas.
+    void zero_grad();
+    // Borra toda la cinta (las Var existentes dejan de ser validas).
+    void clear();
+
+    std::size_t size() const { return nodes_.size(); }
+    // Bytes de los valores calculados que guarda la cinta (sin contar las hojas).
+    std::size_t activation_bytes() const;
+
+    // Para implementar operaciones: agrega un nodo con su valor. fn solo se guarda si alguna
+    // entrada requiere gradiente.
+    Var<T> record(BasicTensor<T>&& value, const std::vector<Var<T> >& inputs, BackwardFn fn);
+    // Suma g al gradiente de v (si v requiere gradiente). g pasa a ser de la cinta: no puede
+    // compartir buffer con nada que se siga modificando.
+    void accumulate(const Var<T>& v, BasicTensor<T>&& g);
+
+    const BasicTensor<T>& value(std::size_t id) const { return nodes_[id].value; }
+    const BasicTensor<T>& grad(std::size_t id) const { return nodes_[id].grad; }
+    bool requires_grad(std::size_t id) const { return nodes_[id].requires_grad; }
+
+private:
+    struct Node {
+        BasicTensor<T> value;
+        BasicTensor<T> grad;
+        bool requires_grad;
+        bool leaf;
+        BackwardFn backward;
+    };
+
+    void check_var_or_throw(const Var<T>& v, const char* fn) const;
+
+    std::deque<Node> nodes_;   // deque: value()/grad() siguen validos al agregar nodos
+};
+
+template <typename T>
+const BasicTensor<T>& Var<T>::value() const { return tape_->value(id_); }
+
+template <typename T>
+const BasicTensor<T>& Var<T>::grad() const { return tape_->grad(id_); }
+
+template <typename T>
+bool Var<T>::requires_grad() const { return tape_->requires_grad(id_); }
+
+//
+//OPERACIONES
+//
+// Mismas reglas de shapes que las de BasicTensor; las entradas tienen que ser de la misma Tape.
+//
+
+template <typename T> Var<T> matmul(const Var<T>& a, const Var<T>& b);
+template <typename T> Var<T> operator+(const Var<T>& a, const Var<T>& b);
+template <typename T> Var<T> operator-(const Var<T>& a, const Var<T>& b);
+template <typename T> Var<T> operator*(const Var<T>& a, const Var<T>& b);
+template <typename T> Var<T> operator*(const Var<T>& a, double scalar);
+
+// Derivada disponible para ReLU, Sigmoid y Tanh.
+template <typename T> Var<T> apply(const Var<T>& a, const TensorTransform& op);
+template <typename T> Var<T> relu(const Var<T>& a);
+template <typename T> Var<T> sigmoid(const Var<T>& a);
+
+template <typename T> Var<T> view(const Var<T>& a, const std::vector<std::size_t>& shape);
+template <typename T> Var<T> unsqueeze(const Var<T>& a, std::size_t dim);
+template <typename T> Var<T> concat(const std::vector<Var<T> >& parts, std::size_t dim);
+
+// Suma / promedio de todos los elementos; shape (1).
+template <typename T> Var<T> sum(const Var<T>& a);
+template <typename T> Var<T> mean(const Var<T>& a);
+
+}
+
+#endif //CS2013_TENSOR_LIBRARY_TENSORAUTOGRAD_H
@@ -0,0 +1,43 @@
+#ifndef CS2013_TENSOR_LIBRARY_TENSORBLAS_H
+#define CS2013_TENSOR_LIBRARY_TENSORBLAS_H
+#include <cstddef>
+
+//
+//BLAS NIVEL 1 sobre punteros (inc = distancia entre elementos consecutivos)
+//
+// Con inc == 1 se usan varios acumuladores SIMD; con otro inc, un bucle escalar.
+// A partir de n >= parallel_min_elems() el vector se parte en trozos de tamaño fijo que se
+// reparten en el pool de parallel::. Los parciales de dot/nrm2/asum se combinan siempre en el
+// mismo orden: el resultado no depende de la cantidad de hilos.
+// Las sobrecargas sobre BasicTensor (devuelven el escalar, sin crear tensores) estan en Tensor.h.
+// Instanciado para float y double.
+//
+
+namespace blas {
+
+void set_parallel_min_elems(std::size_t n);
+std::size_t parallel_min_elems();
+
+// sum(x[i] * y[i])
+template <typename T>
+T dot(std::size_t n, const T* x, std::size_t incx, const T* y, std::size_t incy);
+
+// y <- alpha * x + y
+template <typename T>
+void axpy(std::size_t n, T alpha, const T* x, std::size_t incx, T* y, std::size_t incy);
+
+// x <- alpha * x
+template <typename T>
+void scal(std::size_t n, T alpha, T* x, std::size_t incx);
+
+// sqrt(sum(x[i]^2)), reescalando si la suma directa desborda o pierde precision.
+template <typename T>
+T nrm2(std::size_t n, const T* x, std::size_t incx);
+
+// sum(|x[i]|)
+template <typename T>
+T asum(std::size_t n, const T* x, std::size_t incx);
+
+}
+
+#endif //CS2013_TENSOR_LIBRARY_TENSORBLAS_H
@@ -0,0 +1,314 @@
+#ifndef CS2013_TENSOR_LIBRARY_TENSOREXPR_H
+#define CS2013_TENSOR_LIBRARY_TENSOREXPR_H
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+#include "TensorIter.h"
+#include "TensorProfiler.h"
+
+//
+//EXPRESIONES PEREZOSAS (expression templates)
+//
+// a * 2.0 + b - c no crea temporales: los operadores construyen un arbol de tipos
+// y el resultado se calcula en un unico bucle al asignarlo a un Tensor.
+//
+// Los Tensor se guardan por referencia dentro de la expresion: no guardes una expresion
+// con `auto` mas alla de la sentencia en la que se crean sus operandos temporales.
+//
+// Una expresion se puede usar donde se espera un Tensor: eval() la calcula, y apply, sum y
+// mean (como matmul, bmm, dot y linear en Tensor.h) la evaluan antes de operar.
+//
+
+template <typename T> class BasicTensor;
+class TensorTransform;
+
+template <typename E>
+struct TensorExpr {
+    const E& self() const { return static_cast<const E&>(*this); }
+
+    // auto: E esta incompleto cuando BasicTensor hereda de TensorExpr<BasicTensor>.
+    auto eval() const { return BasicTensor<typename E::value_type>(self()); }
+    auto apply(const TensorTransform& op) const { return eval().apply(op); }
+    auto sum(std::size_t dim, bool keepdim = false) const { return eval().sum(dim, keepdim); }
+    auto mean(std::size_t dim, bool keepdim = false) const { return eval().mean(dim, keepdim); }
+    auto sum() const { return eval().sum(); }
+    auto mean() const { return eval().mean(); }
+};
+
+namespace expr {
+
+// Descripcion de una hoja (tensor) para el bucle de evaluacion.
+template <typename T>
+struct Operand {
+    const T* data;
+    const TensorShape* shape;
+    const TensorShape* strides;
+    const BasicTensor<T>* tensor;     // para detectar alias con el destino
+};
+
+struct AddOp { template <typename T> static T apply(T a, T b) { return a + b; } };
+struct SubOp { template <typename T> static T apply(T a, T b) { return a - b; } };
+struct MulOp { template <typename T> static T apply(T a, T b) { return a * b; } };
+
+TensorShape broadcast_shape(const TensorShape& a,
+                                         const TensorShape& b);
+
+//
+//HOJA: referencia a un Tensor
+//
+
+template <typename T>
+class TensorLeaf : public TensorExpr<TensorLeaf<T> > {
+public:
+    typedef T value_type;
+    static const std::size_t leaves = 1;
+    static const std::size_t ops = 0;       // operaciones por elemento (para el profiler)
+
+    explicit TensorLeaf(const BasicTensor<T>& t) : t_(t) {}
+
+    const TensorShape& shape() const { return t_.shape_; }
+
+    void collect(Operand<T>* ops) const {
+        ops[0].data = t_.data_;
+        ops[0].shape = &t_.shape_;
+        ops[0].strides = &t_.strides_;
+        ops[0].tensor = &t_;
+    }
+
+    template <std::size_t I>
+    T eval(const T* const* p, std::size_t j) const { return p[I][j]; }
+
+private:
+    const BasicTensor<T>& t_;
+};
+
+//
+//NODOS
+//
+
+template <typename Op, typename L, typename R>
+class BinaryExpr : public TensorExpr<BinaryExpr<Op, L, R> > {
+public:
+    typedef typename L::value_type value_type;
+    static const std::size_t leaves = L::leaves + R::leaves;
+    static const std::size_t ops = L::ops + R::ops + 1;
+
+    BinaryExpr(const L& l, const R& r)
+        : l_(l), r_(r), shape_(broadcast_shape(l.shape(), r.shape())) {
+        static_assert(std::is_same<typename L::value_type, typename R::value_type>::value,
+                      "Tensor: no se pueden mezclar tipos de elemento en una expresion");
+    }
+
+    const TensorShape& shape() const { return shape_; }
+
+    void collect(Operand<value_type>* ops) const {
+        l_.collect(ops);
+        r_.collect(ops + L::leaves);
+    }
+
+    template <std::size_t I>
+    value_type eval(const value_type* const* p, std::size_t j) const {
+        return Op::apply(l_.template eval<I>(p, j), r_.template eval<I + L::leaves>(p, j));
+    }
+
+private:
+    L l_;
+    R r_;
+    TensorShape shape_;
+};
+
+template <typename E>
+class ScaleExpr : public TensorExpr<ScaleExpr<E> > {
+public:
+    typedef typename E::value_type value_type;
+    static const std::size_t leaves = E::leaves;
+    static const std::size_t ops = E::ops + 1;
+
+    ScaleExpr(const E& e, value_type scalar) : e_(e), scalar_(scalar) {}
+
+    const TensorShape& shape() const { return e_.shape(); }
+    void collect(Operand<value_type>* ops) const { e_.collect(ops); }
+
+    template <std::size_t I>
+    value_type eval(const value_type* const* p, std::size_t j) const {
+        return e_.template eval<I>(p, j) * scalar_;
+    }
+
+private:
+    E e_;
+    value_type scalar_;
+};
+
+// Un BasicTensor entra al arbol como TensorLeaf; las subexpresiones se copian por valor.
+template <typename E> struct leaf_of { typedef E type; };
+template <typename T> struct leaf_of<BasicTensor<T> > { typedef TensorLeaf<T> type; };
+
+template <typename E>
+const E& as_leaf(const TensorExpr<E>& e) { return e.self(); }
+
+template <typename T>
+TensorLeaf<T> as_leaf(const TensorExpr<BasicTensor<T> >& t) { return TensorLeaf<T>(t.self()); }
+
+// Argumento de matmul & co.: un Tensor pasa por referencia y una expresion se evalua.
+template <typename T>
+const BasicTensor<T>& materialize(const TensorExpr<BasicTensor<T> >& t) { return t.self(); }
+
+template <typename E>
+BasicTensor<typename E::value_type> materialize(const TensorExpr<E>& e) { return e.eval(); }
+
+//
+//PROFILER: shapes de las hojas, shape de salida y FLOPs (ops por elemento) de una expresion
+//
+
+#ifdef TENSOR_PROFILE
+template <typename E>
+void profile(profiler::Scope& s, const E& e) {
+    Operand<typename E::value_type> ops[E::leaves];
+    e.collect(ops);
+    for (std::size_t i = 0; i < E::leaves; ++i) s.input(*ops[i].shape);
+    std::size_t numel = 1;
+    for (std::size_t d = 0; d < e.shape().size(); ++d) numel *= e.shape()[d];
+    s.output(e.shape());
+    s.flops(static_cast<double>(E::ops * numel));
+}
+#define TENSOR_PROFILE_EXPR(e) ::expr::profile(tensor_profile_scope_, e)
+#else
+#define TENSOR_PROFILE_EXPR(e) ((void)0)
+#endif
+
+//
+//EVALUACION: out (shape = e.shape(); contiguo o con out_strides) <- e
+//
+// El recorrido lo planifica iter::make_plan (salida + hojas). Si en la dimension interna
+// todos los operandos son contiguos, cada fila es un bucle lineal p[i][j] que el compilador
+// vectoriza. Si no, la fila se procesa por bloques: las hojas con broadcast (stride 0) o con
+// stride se copian a un buffer contiguo y la salida con stride se escribe desde otro.
+//
+
+template <typename E>
+inline void eval_row(const E& e, const typename E::value_type* const* p,
+                     typename E::value_type* o, std::size_t n) {
+    for (std::size_t j = 0; j < n; ++j) o[j] = e.template eval<0>(p, j);
+}
+
+// Plan de e con la salida como operando 0 (out_strides nullptr: salida contigua). Sirve para
+// varias evaluaciones mientras las hojas conserven shape y strides (Graph lo guarda por nodo).
+template <typename E>
+iter::Plan plan_of(const E& e, const TensorShape* out_strides = nullptr) {
+    const std::size_t N = E::leaves;
+    const TensorShape& shape = e.shape();
+
+    Operand<typename E::value_type> ops[N];
+    e.collect(ops);
+
+    TensorShape dense;
+    if (out_strides == nullptr) {
+        dense.assign(shape.size(), 1);
+        for (std::size_t d = shape.size(); d-- > 1;) dense[d - 1] = dense[d] * shape[d];
+        out_strides = &dense;
+    }
+
+    const TensorShape* shapes[N + 1];
+    const TensorShape* strides[N + 1];
+    shapes[0] = &shape;
+    strides[0] = out_strides;
+    for (std::size_t i = 0; i < N; ++i) {
+        shapes[i + 1] = ops[i].shape;
+        strides[i + 1] = ops[i].strides;
+    }
+    return iter::make_plan(shape, N + 1, shapes, strides);
+}
+
+template <typename E>
+void evaluate(const E& e, typename E::value_type* out, const iter::Plan& plan) {
+    typedef typename E::value_type T;
+    const std::size_t N = E::leaves;
+
+    Operand<T> ops[N];
+    e.collect(ops);
+    const std::size_t cols = plan.cols();
+
+    bool direct = true;
+    for (std::size_t i = 0; i <= N && cols > 1; ++i)
+        if (plan.inner_stride(i) != 1) direct = false;
+
+    const T* p[N];
+    if (direct) {
+        iter::for_each_row(plan, [&](const std::size_t* off) {
+            T* o = out + off[0];
+            for (std::size_t i = 0; i < N; ++i) p[i] = ops[i].data + off[i + 1];
+            eval_row(e, p, o, cols);
+        });
+        return;
+    }
+
+    const std::size_t BLOCK = 256;
+    T buf[N + 1][BLOCK];
+    iter::for_each_row(plan, [&](const std::size_t* off) {
+        for (std::size_t c0 = 0; c0 < cols; c0 += BLOCK) {
+            const std::size_t nb = std::min(BLOCK, cols - c0);
+            for (std::size_t i = 0; i < N; ++i) {
+                const std::size_t s = plan.inner_stride(i + 1);
+                const T* src = ops[i].data + off[i + 1] + c0 * s;
+                if (s == 1) {
+                    p[i] = src;
+                } else if (s == 0) {
+                    std::fill(buf[i + 1], buf[i + 1] + nb, *src);
+                    p[i] = buf[i + 1];
+                } else {
+                    for (std::size_t j = 0; j < nb; ++j) buf[i + 1][j] = src[j * s];
+                    p[i] = buf[i + 1];
+                }
+            }
+            const std::size_t os = plan.inner_stride(0);
+            T* dst = out + off[0] + c0 * os;
+            T* o = (os == 1) ? dst : buf[0];
+            eval_row(e, p, o, nb);
+            if (os != 1)
+                for (std::size_t j = 0; j < nb; ++j) dst[j * os] = buf[0][j];
+        }
+    });
+}
+
+template <typename E>
+void evaluate(const E& e, typename E::value_type* out,
+              const TensorShape* out_strides = nullptr) {
+    evaluate(e, out, plan_of(e, out_strides));
+}
+
+}
+
+//
+//OPERADORES (element-wise con broadcast)
+//
+
+template <typename L, typename R>
+expr::BinaryExpr<expr::AddOp, typename expr::leaf_of<L>::type, typename expr::leaf_of<R>::type>
+operator+(const TensorExpr<L>& l, const TensorExpr<R>& r) {
+    typedef expr::BinaryExpr<expr::AddOp, typename expr::leaf_of<L>::type, typename expr::leaf_of<R>::type> Node;
+    return Node(expr::as_leaf(l), expr::as_leaf(r));
+}
+
+template <typename L, typename R>
+expr::BinaryExpr<expr::SubOp, typename expr::leaf_of<L>::type, typename expr::leaf_of<R>::type>
+operator-(const TensorExpr<L>& l, const TensorExpr<R>& r) {
+    typedef expr::BinaryExpr<expr::SubOp, typename expr::leaf_of<L>::type, typename expr::leaf_of<R>::type> Node;
+    return Node(expr::as_leaf(l), expr::as_leaf(r));
+}
+
+template <typename L, typename R>
+expr::BinaryExpr<expr::MulOp, typename expr::leaf_of<L>::type, typename expr::leaf_of<R>::type>
+operator*(const TensorExpr<L>& l, const TensorExpr<R>& r) {
+    typedef expr::BinaryExpr<expr::MulOp, typename expr::leaf_of<L>::type, typename expr::leaf_of<R>::type> Node;
+    return Node(expr::as_leaf(l), expr::as_leaf(r));
+}
+
+template <typename E>
+expr::ScaleExpr<typename expr::leaf_of<E>::type>
+operator*(const TensorExpr<E>& e, double scalar) {
+    typedef expr::ScaleExpr<typename expr::leaf_of<E>::type> Node;
+    return Node(expr::as_leaf(e), static_cast<typename Node::value_type>(scalar));
+}
+
+#endif //CS2013_TENSOR_LIBRARY_TENSOREXPR_H
@@ -0,0 +1,49 @@
+#ifndef CS2013_TENSOR_LIBRARY_TENSORGEMM_H
+#define CS2013_TENSOR_LIBRARY_TENSORGEMM_H
+#include <cstddef>
+
+class TensorTransform;
+
+//
+//GEMM: C(m x n) = A(m x k) * B(k x n)
+//
+// A y B se leen con strides arbitrarios (rs = stride de fila, cs = stride de columna),
+// C se escribe row-major con stride de fila ldc.
+// Si el producto es grande, C se parte en tiles 2D que se reparten en el pool de parallel::.
+// Instanciado para float y double.
+//
+
+namespace gemm {
+
+struct BlockSizes {
+    std::size_t mc;   // filas de A por bloque (residente en L2)
+    std::size_t kc;   // profundidad del panel (micro-paneles en L1)
+    std::size_t nc;   // columnas de B por bloque (residente en L3)
+};
+
+template <typename T>
+const BlockSizes& block_sizes();
+
+// Productos con m*n*k por debajo de este umbral se calculan en un solo hilo.
+void set_parallel_threshold(std::size_t flops);
+std::size_t parallel_threshold();
+
+// Se aplica a cada tile de C al terminar su ultimo panel k, mientras sigue en L1:
+// c[i][j] = act(c[i][j] + bias[j * bias_stride]). bias y act pueden ser nulos.
+template <typename T>
+struct Epilogue {
+    const T* bias = nullptr;
+    std::size_t bias_stride = 1;
+    const TensorTransform* act = nullptr;
+};
+
+template <typename T>
+void gemm(std::size_t m, std::size_t n, std::size_t k,
+          const T* a, std::size_t rsa, std::size_t csa,
+          const T* b, std::size_t rsb, std::size_t csb,
+          T* c, std::size_t ldc,
+          const Epilogue<T>* ep = nullptr);
+
+}
+
+#endif //CS2013_TENSOR_LIBRARY_TENSORGEMM_H
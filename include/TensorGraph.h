@@ -0,0 +1,219 @@
+#ifndef CS2013_TENSOR_LIBRARY_TENSORGRAPH_H
+#define CS2013_TENSOR_LIBRARY_TENSORGRAPH_H
+#include <cstddef>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "Tensor.h"
+
+//
+//GRAFO DE CALCULO CON PLAN DE MEMORIA ESTATICO
+//
+// Las operaciones sobre graph::Value<T> no calculan nada: agregan un nodo (con su shape ya
+// validada) al Graph. compile() hace el analisis de vida de cada intermedio y los asigna a
+// un conjunto minimo de slots de una arena reservada una sola vez:
+//   - un slot se libera despues del ultimo uso de su valor (y de las vistas sobre el);
+//   - las operaciones elemento a elemento (+, -, *, * escalar, apply) escriben sobre el slot
+//     de una entrada que muere en ese nodo, si tiene la misma shape;
+//   - view/unsqueeze no ocupan slot: son vistas del valor de origen.
+// Antes del plan, la pasada de fusion junta las cadenas de operaciones elemento a elemento
+// (un nodo cuyo unico uso es otra operacion elemento a elemento con su misma shape) en un
+// solo kernel: se recorre la salida una vez, por bloques, y los intermedios quedan en
+// buffers de un bloque en vez de ocupar un slot de la arena.
+// run() vuelve a ejecutar el grafo con entradas nuevas usando las variantes `out` de las
+// operaciones, sin pedir memoria al allocator ni al heap: los recorridos (iter::Plan) de cada
+// nodo elemento a elemento se arman en el primer run() tras compile() y se reutilizan. Los
+// resultados son vistas de la arena: se sobrescriben en el siguiente run().
+//
+// Los constantes (pesos) y las TensorTransform se guardan por referencia / buffer compartido.
+// Instanciado para float y double.
+//
+
+namespace graph {
+
+template <typename T> class Graph;
+
+template <typename T>
+class Value {
+public:
+    Value() : graph_(nullptr), id_(0) {}
+
+    const std::vector<std::size_t>& shape() const;
+    // Mismos nombres que en BasicTensor, para poder escribir el forward una sola vez.
+    Value apply(const TensorTransform& op) const;
+    Value view(const std::vector<std::size_t>& shape) const;
+    Value unsqueeze(std::size_t dim) const;
+
+    Graph<T>* graph() const { return graph_; }
+    std::size_t id() const { return id_; }
+
+private:
+    friend class Graph<T>;
+    Value(Graph<T>* graph, std::size_t id) : graph_(graph), id_(id) {}
+
+    Graph<T>* graph_;
+    std::size_t id_;
+};
+
+template <typename T>
+class Graph {
+public:
+    Graph() {}
+    Graph(const Graph&) = delete;
+    Graph& operator=(const Graph&) = delete;
+
+    //
+    //CONSTRUCCION
+    //
+    Value<T> input(const std::vector<std::size_t>& shape);
+    // Comparte el buffer de t (si no es contiguo se copia una vez).
+    Value<T> constant(const BasicTensor<T>& t);
+    void output(const Value<T>& v);
+
+    Value<T> matmul(const Value<T>& a, const Value<T>& b);
+    Value<T> linear(const Value<T>& x, const Value<T>& w, const Value<T>& b, const TensorTransform* act);
+    Value<T> add(const Value<T>& a, const Value<T>& b);
+    Value<T> sub(const Value<T>& a, const Value<T>& b);
+    Value<T> mul(const Value<T>& a, const Value<T>& b);
+    Value<T> scale(const Value<T>& a, double scalar);
+    Value<T> apply(const Value<T>& a, const TensorTransform& op);
+    Value<T> view(const Value<T>& a, const std::vector<std::size_t>& shape);
+    Value<T> unsqueeze(const Value<T>& a, std::size_t dim);
+    Value<T> concat(const std::vector<Value<T> >& parts, std::size_t dim);
+
+    const std::vector<std::size_t>& shape(const Value<T>& v) const;
+
+    //
+    //PLAN Y EJECUCION
+    //
+    // Fusiona, asigna los slots y reserva la arena. run() lo llama si el grafo cambio.
+    void compile();
+    // Activa/desactiva la fusion de operaciones elemento a elemento (activa por defecto).
+    void set_fusion(bool on) { fusion_ = on; compiled_ = false; }
+    // inputs en el orden de input(); cada uno con la shape declarada (si no es contiguo se copia).
+    void run(const std::vector<BasicTensor<T> >& inputs);
+    // Una entrada y una salida.
+    const BasicTensor<T>& run(const BasicTensor<T>& input);
+    // Salida i (orden de output()) del ultimo run().
+    const BasicTensor<T>& output(std::size_t i = 0) const;
+
+    std::size_t num_nodes() const { return nodes_.size(); }
+    std::size_t num_slots() const { return slot_elems_.size(); }
+    // Kernels que ejecuta run() (nodos menos entradas, constantes, vistas y nodos fusionados).
+    std::size_t num_kernels() const;
+    // Bytes de la arena y bytes que reservaria la ejecucion inmediata (uno por intermedio).
+    std::size_t arena_bytes() const;
+    std::size_t naive_bytes() const;
+    // Un nodo por linea con su shape y su slot.
+    void print(std::ostream& os) const;
+
+private:
+    enum class Op { Input, Constant, MatMul, Linear, Add, Sub, Mul, Scale, Apply, View, Unsqueeze, Concat };
+
+    struct Node {
+        Op op;
+        std::vector<std::size_t> inputs;
+        std::vector<std::size_t> shape;
+        std::size_t numel = 0;
+        const TensorTransform* transform = nullptr;   // Apply, Linear (puede ser nullptr)
+        double scalar = 0;                            // Scale
+        std::size_t dim = 0;                          // Unsqueeze, Concat
+    };
+
+    Value<T> add_node(Node n);
+    void check_value_or_throw(const Value<T>& v, const char* fn) const;
+    Value<T> elementwise(Op op, const Value<T>& a, const Value<T>& b, const char* fn);
+    static bool is_alias(Op op) { return op == Op::View || op == Op::Unsqueeze; }
+    static bool is_elementwise(Op op) {
+        return op == Op::Add || op == Op::Sub || op == Op::Mul || op == Op::Scale || op == Op::Apply;
+    }
+    // Paso de un kernel fusionado: arg[k] es una entrada externa o el resultado de un paso previo.
+    struct Step {
+        Op op;
+        std::size_t arg[2];
+        bool from_step[2];
+        double scalar;
+        const TensorTransform* transform;
+    };
+    struct Fused {
+        std::vector<std::size_t> inputs;    // nodos externos
+        std::vector<Step> steps;            // el ultimo escribe la salida
+        iter::Plan plan;                    // se arma en el primer run() tras compile()
+    };
+
+    void fuse();
+    std::size_t emit(Fused& f, std::size_t id, std::size_t root, bool& from_step);
+    const std::vector<std::size_t>& args(std::size_t i) const;
+    void plan();
+    void execute(std::size_t i);
+    template <typename E> void run_elementwise(std::size_t i, const E& e);
+    void run_fused(Fused& f, BasicTensor<T>& out);
+
+    std::vector<Node> nodes_;
+    std::vector<std::size_t> inputs_, outputs_;
+    std::vector<BasicTensor<T> > constants_;      // por nodo (vacio si no es Constant)
+
+    bool compiled_ = false;
+    bool fusion_ = true;
+    std::vector<bool> absorbed_;                  // calculado dentro del kernel de otro nodo
+    std::vector<long> fused_of_;                  // indice en fused_ (-1: sin fusion)
+    std::vector<Fused> fused_;
+    std::vector<T> fused_buf_;                    // bloques de entradas e intermedios
+    std::vector<const T*> fused_ptr_;
+    std::vector<long> slot_of_;                   // -1: sin slot (entrada, constante o vista)
+    std::vector<std::size_t> slot_elems_;
+    std::vector<BasicTensor<T> > arena_;          // un buffer 1D por slot
+    std::vector<BasicTensor<T> > values_;         // valor de cada nodo (vista de la arena o entrada)
+    std::vector<BasicTensor<T> > concat_parts_;   // reutilizado por los Concat
+    std::vector<iter::Plan> plans_;               // recorrido de +, -, * y * escalar sin fusion
+    std::vector<BasicTensor<T> > single_input_;   // entrada de run(const BasicTensor&)
+};
+
+template <typename T>
+Graph<T>& graph_of_or_throw(const Value<T>& v, const char* fn) {
+    if (v.graph() == nullptr) throw std::invalid_argument(std::string(fn) + ": Value sin Graph");
+    return *v.graph();
+}
+
+template <typename T>
+const std::vector<std::size_t>& Value<T>::shape() const { return graph_of_or_throw(*this, "graph::Value::shape").shape(*this); }
+
+template <typename T>
+Value<T> Value<T>::apply(const TensorTransform& op) const { return graph_of_or_throw(*this, "graph::apply").apply(*this, op); }
+
+template <typename T>
+Value<T> Value<T>::view(const std::vector<std::size_t>& shape) const { return graph_of_or_throw(*this, "graph::view").view(*this, shape); }
+
+template <typename T>
+Value<T> Value<T>::unsqueeze(std::size_t dim) const { return graph_of_or_throw(*this, "graph::unsqueeze").unsqueeze(*this, dim); }
+
+template <typename T>
+Value<T> matmul(const Value<T>& a, const Value<T>& b) { return graph_of_or_throw(a, "graph::matmul").matmul(a, b); }
+
+template <typename T>
+Value<T> linear(const Value<T>& x, const Value<T>& w, const Value<T>& b, const TensorTransform* act) {
+    return graph_of_or_throw(x, "graph::linear").linear(x, w, b, act);
+}
+
+template <typename T>
+Value<T> operator+(const Value<T>& a, const Value<T>& b) { return graph_of_or_throw(a, "graph::operator+").add(a, b); }
+
+template <typename T>
+Value<T> operator-(const Value<T>& a, const Value<T>& b) { return graph_of_or_throw(a, "graph::operator-").sub(a, b); }
+
+template <typename T>
+Value<T> operator*(const Value<T>& a, const Value<T>& b) { return graph_of_or_throw(a, "graph::operator*").mul(a, b); }
+
+template <typename T>
+Value<T> operator*(const Value<T>& a, double scalar) { return graph_of_or_throw(a, "graph::operator*").scale(a, scalar); }
+
+template <typename T>
+Value<T> concat(const std::vector<Value<T> >& parts, std::size_t dim) {
+    if (parts.empty()) throw std::invalid_argument("graph::concat: parts esta vacio");
+    return graph_of_or_throw(parts[0], "graph::concat").concat(parts, dim);
+}
+
+}
+
+#endif //CS2013_TENSOR_LIBRARY_TENSORGRAPH_H
@@ -0,0 +1,67 @@
+#ifndef CS2013_TENSOR_LIBRARY_TENSORIO_H
+#define CS2013_TENSOR_LIBRARY_TENSORIO_H
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//
+//FORMATO BINARIO DE TENSORES (.tensor), version 1
+//
+// Todo en little-endian:
+//   0  char[8]   magic "CS2013TN"
+//   8  uint32    version (1)
+//   12 uint32    dtype (DType)
+//   16 uint32    rank (1..kMaxDims)
+//   20 uint32    alignment: data_offset es multiplo de este valor (TENSOR_ALIGNMENT); potencia
+//                de 2, como mucho 4096
+//   24 uint64    data_offset: bytes desde el inicio del archivo hasta los datos
+//   32 uint64    data_bytes
+//   40 uint64    checksum de los datos (io::checksum)
+//   48 uint64[rank] shape, uint64[rank] strides (en elementos), ceros hasta data_offset
+//
+// save escribe los datos contiguos (strides row-major); al cargar se acepta cualquier stride
+// que no se salga de data_bytes. Como data_offset esta alineado, mmap_load puede usar la
+// pagina mapeada directamente como storage del tensor.
+//
+
+namespace io {
+
+enum DType : std::uint32_t {
+    Float32 = 1,
+    Float64 = 2
+};
+
+template <typename T> struct dtype_of;
+template <> struct dtype_of<float>  { static const DType value = Float32; };
+template <> struct dtype_of<double> { static const DType value = Float64; };
+
+const std::uint32_t FORMAT_VERSION = 1;
+const std::size_t HEADER_FIXED_BYTES = 48;
+
+// FNV-1a de 64 bits sobre palabras de 64 bits en 4 carriles independientes (para que no
+// limite la velocidad de lectura), combinados al final junto con los bytes sobrantes.
+// Checksum lo calcula por partes (mismo resultado que una sola llamada a checksum).
+class Checksum {
+public:
+    Checksum();
+    void update(const void* data, std::size_t bytes);
+    std::uint64_t value() const;
+
+private:
+    std::uint64_t h_[4];
+    unsigned char pending_[32];
+    std::size_t npending_;
+    std::uint64_t total_;
+};
+
+std::uint64_t checksum(const void* data, std::size_t bytes);
+
+// Cabecera completa (hasta data_offset, con relleno) lista para escribir antes de los datos.
+std::vector<unsigned char> encode_header(DType dtype,
+                                         const std::vector<std::size_t>& shape,
+                                         const std::vector<std::size_t>& strides,
+                                         std::uint64_t data_bytes, std::uint64_t checksum);
+
+}
+
+#endif //CS2013_TENSOR_LIBRARY_TENSORIO_H
@@ -0,0 +1,194 @@
+#ifndef CS2013_TENSOR_LIBRARY_TENSORITER_H
+#define CS2013_TENSOR_LIBRARY_TENSORITER_H
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+#include "TensorShape.h"
+
+//
+//RECORRIDO N-DIMENSIONAL CON STRIDES
+//
+// Un Plan describe un bucle sobre `shape` con varios operandos (salida y entradas), cada uno
+// con sus strides. make_plan alinea los rangos a la derecha (broadcast), pone stride 0 en las
+// dimensiones con broadcast, descarta las dimensiones de tamaño 1 y fusiona dimensiones
+// adyacentes que son contiguas entre si en todos los operandos. Asi (1000x100) + (1000x100)
+// queda en una sola fila de 100000 y (1000x100) + (1x100) en 1000 filas de 100 contiguas.
+//
+// for_each_row recorre las filas (ultima dimension) actualizando los offsets de forma
+// incremental: el bucle interno lo escribe el llamador y no hace aritmetica de indices.
+//
+
+namespace iter {
+
+// Operandos cuyos strides guarda un Plan dentro del objeto; con mas, los restantes van al heap.
+const std::size_t kPlanInlineOps = 8;
+
+struct Plan {
+    std::size_t nops = 0;
+    TensorShape shape;                  // dimensiones tras fusionar; la ultima son las columnas
+
+    std::size_t ndim() const { return shape.size(); }
+    std::size_t cols() const { return shape.empty() ? 1 : shape.back(); }
+    std::size_t rows() const;
+    // ndim() strides del operando op, en elementos (0 = broadcast).
+    const TensorShape& strides(std::size_t op) const {
+        return op < kPlanInlineOps ? inline_strides[op] : extra_strides[op - kPlanInlineOps];
+    }
+    TensorShape& strides(std::size_t op) {
+        return op < kPlanInlineOps ? inline_strides[op] : extra_strides[op - kPlanInlineOps];
+    }
+    std::size_t inner_stride(std::size_t op) const {
+        return shape.empty() ? 0 : strides(op).back();
+    }
+
+    TensorShape inline_strides[kPlanInlineOps];
+    std::vector<TensorShape> extra_strides;   // operandos kPlanInlineOps.. (casi siempre vacio)
+};
+
+// shapes[i] tiene que ser compatible por broadcast con `shape` (rango <= shape.size()).
+// Sin heap salvo con mas de kPlanInlineOps operandos.
+Plan make_plan(const TensorShape& shape, std::size_t nops,
+               const TensorShape* const* shapes,
+               const TensorShape* const* strides);
+
+// fn(offsets): offsets[i] es el offset (en elementos) del inicio de la fila para el operando i.
+// Los offsets e indices viven en la pila (hasta kPlanInlineOps operandos).
+template <typename F>
+void for_each_row(const Plan& plan, F&& fn) {
+    const std::size_t n = plan.nops;
+    const std::size_t D = plan.ndim();
+    std::size_t off_inline[kPlanInlineOps] = {};
+    std::vector<std::size_t> off_heap;
+    std::size_t* off = off_inline;
+    if (n > kPlanInlineOps) {
+        off_heap.assign(n, 0);
+        off = off_heap.data();
+    }
+    if (D <= 1) {
+        fn(static_cast<const std::size_t*>(off));
+        return;
+    }
+    std::size_t idx[kMaxDims] = {};
+    const std::size_t rows = plan.rows();
+    for (std::size_t r = 0; r < rows; ++r) {
+        fn(static_cast<const std::size_t*>(off));
+        for (std::size_t d = D - 1; d-- > 0;) {
+            for (std::size_t i = 0; i < n; ++i) off[i] += plan.strides(i)[d];
+            if (++idx[d] < plan.shape[d]) break;
+            for (std::size_t i = 0; i < n; ++i) off[i] -= plan.strides(i)[d] * plan.shape[d];
+            idx[d] = 0;
+        }
+    }
+}
+
+//
+//ACCESO DIRECTO: Span (contiguo) y StridedIterator (cualquier vista)
+//
+
+template <typename T>
+class Span {
+public:
+    Span() : data_(nullptr), size_(0) {}
+    Span(T* data, std::size_t size) : data_(data), size_(size) {}
+
+    T* data() const { return data_; }
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    T& operator[](std::size_t i) const { return data_[i]; }
+    T* begin() const { return data_; }
+    T* end() const { return data_ + size_; }
+
+private:
+    T* data_;
+    std::size_t size_;
+};
+
+// Recorre los elementos de una vista en orden row-major. Copia la shape y los strides (no
+// depende del Tensor, solo del buffer). ++ suma el stride interno y solo al cambiar de fila
+// recalcula el offset; +=, -, [] lo recalculan desde el indice plano.
+template <typename T>
+class StridedIterator {
+public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef typename std::remove_const<T>::type value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef T* pointer;
+    typedef T& reference;
+
+    StridedIterator() : data_(nullptr), i_(0), off_(0), col_(0) {}
+    StridedIterator(T* data, const TensorShape& shape, const TensorShape& strides, std::size_t i)
+        : data_(data), shape_(shape), strides_(strides), i_(i), off_(0), col_(0) { seek(); }
+    // iterator -> const_iterator
+    template <typename U, typename = typename std::enable_if<std::is_same<const U, T>::value>::type>
+    StridedIterator(const StridedIterator<U>& o)
+        : data_(o.data_), shape_(o.shape_), strides_(o.strides_), i_(o.i_), off_(o.off_), col_(o.col_) {}
+
+    reference operator*() const { return data_[off_]; }
+    pointer operator->() const { return data_ + off_; }
+    reference operator[](difference_type n) const { return *(*this + n); }
+
+    StridedIterator& operator++() {
+        ++i_;
+        if (++col_ < cols()) off_ += strides_.back();
+        else seek();
+        return *this;
+    }
+    StridedIterator& operator--() {
+        --i_;
+        if (col_ > 0) {
+            --col_;
+            off_ -= strides_.back();
+        } else {
+            seek();
+        }
+        return *this;
+    }
+    StridedIterator operator++(int) { StridedIterator r(*this); ++*this; return r; }
+    StridedIterator operator--(int) { StridedIterator r(*this); --*this; return r; }
+    StridedIterator& operator+=(difference_type n) {
+        i_ = static_cast<std::size_t>(static_cast<difference_type>(i_) + n);
+        seek();
+        return *this;
+    }
+    StridedIterator& operator-=(difference_type n) { return *this += -n; }
+    StridedIterator operator+(difference_type n) const { StridedIterator r(*this); return r += n; }
+    StridedIterator operator-(difference_type n) const { StridedIterator r(*this); return r += -n; }
+    friend StridedIterator operator+(difference_type n, const StridedIterator& it) { return it + n; }
+    difference_type operator-(const StridedIterator& o) const {
+        return static_cast<difference_type>(i_) - static_cast<difference_type>(o.i_);
+    }
+
+    bool operator==(const StridedIterator& o) const { return i_ == o.i_; }
+    bool operator!=(const StridedIterator& o) const { return i_ != o.i_; }
+    bool operator<(const StridedIterator& o) const { return i_ < o.i_; }
+    bool operator>(const StridedIterator& o) const { return i_ > o.i_; }
+    bool operator<=(const StridedIterator& o) const { return i_ <= o.i_; }
+    bool operator>=(const StridedIterator& o) const { return i_ >= o.i_; }
+
+private:
+    template <typename U> friend class StridedIterator;
+
+    std::size_t cols() const { return shape_.empty() ? 1 : shape_.back(); }
+    // off_ y col_ a partir de i_.
+    void seek() {
+        std::size_t rest = i_;
+        off_ = 0;
+        for (std::size_t d = shape_.size(); d-- > 0;) {
+            off_ += (rest % shape_[d]) * strides_[d];
+            rest /= shape_[d];
+        }
+        col_ = shape_.empty() ? 0 : i_ % shape_.back();
+    }
+
+    T* data_;
+    TensorShape shape_;
+    TensorShape strides_;
+    std::size_t i_;
+    std::size_t off_;
+    std::size_t col_;
+};
+
+}
+
+#endif //CS2013_TENSOR_LIBRARY_TENSORITER_H
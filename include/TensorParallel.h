@@ -0,0 +1,28 @@
+#ifndef CS2013_TENSOR_LIBRARY_TENSORPARALLEL_H
+#define CS2013_TENSOR_LIBRARY_TENSORPARALLEL_H
+#include <cstddef>
+#include <functional>
+
+//
+//POOL DE HILOS DE LA LIBRERIA
+//
+// Por defecto usa TENSOR_NUM_THREADS (variable de entorno) o std::thread::hardware_concurrency().
+// Las llamadas anidadas a parallel_for se ejecutan en serie dentro del hilo que las invoca.
+//
+
+namespace parallel {
+
+std::size_t num_threads();
+
+// 0 vuelve al valor por defecto. Los parallel_for ya en curso terminan con el pool anterior.
+void set_num_threads(std::size_t n);
+
+bool in_parallel_region();
+
+// Divide [begin, end) en trozos de al menos `grain` elementos y llama fn(b, e) por trozo.
+void parallel_for(std::size_t begin, std::size_t end, std::size_t grain,
+                  const std::function<void(std::size_t, std::size_t)>& fn);
+
+}
+
+#endif //CS2013_TENSOR_LIBRARY_TENSORPARALLEL_H
@@ -0,0 +1,108 @@
+#ifndef CS2013_TENSOR_LIBRARY_TENSORPROFILER_H
+#define CS2013_TENSOR_LIBRARY_TENSORPROFILER_H
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+//
+//PROFILER POR OPERACION
+//
+// Solo existe si se compila con TENSOR_PROFILE (opcion de CMake TENSOR_ENABLE_PROFILER).
+// Sin esa macro, los TENSOR_PROFILE_* no generan codigo ni evaluan sus argumentos.
+//
+// Cada operacion instrumentada (matmul, linear, bmm, dot, apply, concat, reducciones,
+// creadores y la evaluacion de expresiones) abre un Scope que registra nombre, shapes de
+// entrada y salida, duracion, FLOPs y bytes reservados por el allocator mientras dura (incluye
+// las operaciones anidadas). Los eventos se guardan en memoria hasta reset(); summary()
+// los agrupa por nombre y write_chrome_trace() los exporta al formato trace_event de Chrome
+// (chrome://tracing o https://ui.perfetto.dev).
+//
+
+namespace profiler {
+
+struct Event {
+    std::string name;
+    std::string inputs;          // p. ej. "(1000, 400) (400, 100)"
+    std::string output;
+    std::uint64_t start_ns;      // desde reset()
+    std::uint64_t dur_ns;
+    std::uint64_t self_ns;       // dur_ns menos el de las operaciones anidadas
+    double flops;
+    std::size_t bytes;           // reservados durante la operacion
+    unsigned thread;             // 0 = primer hilo que registro un evento
+    unsigned depth;              // 0 = operacion de nivel superior
+};
+
+struct OpStats {
+    std::string name;
+    std::size_t calls = 0;
+    std::uint64_t total_ns = 0;
+    std::uint64_t self_ns = 0;
+    std::uint64_t min_ns = 0;
+    std::uint64_t max_ns = 0;
+    double flops = 0;
+    std::size_t bytes = 0;
+};
+
+// true si la libreria se compilo con TENSOR_PROFILE.
+bool compiled_in();
+
+// Permite pausar el registro en tiempo de ejecucion (por defecto activo).
+void set_enabled(bool on);
+bool enabled();
+
+// Borra los eventos y reinicia el origen de tiempos.
+void reset();
+
+std::vector<Event> events();
+// Una entrada por nombre, ordenadas por self_ns descendente.
+std::vector<OpStats> summary();
+void print_summary(std::ostream& os);
+
+std::string chrome_trace_json();
+void write_chrome_trace(const std::string& path);
+
+// Lo llama el allocator de los tensores; suma a las operaciones abiertas en este hilo.
+void record_allocation(std::size_t bytes);
+
+class Scope {
+public:
+    explicit Scope(const char* name);
+    ~Scope();
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+    void input(const std::vector<std::size_t>& shape);
+    void output(const std::vector<std::size_t>& shape);
+    void flops(double n);
+
+private:
+    const char* name_;
+    bool active_;
+    Scope* parent_;
+    std::uint64_t start_ns_;
+    std::uint64_t child_ns_;
+    std::size_t bytes_;
+    double flops_;
+    std::string inputs_, output_;
+};
+
+}
+
+#ifdef TENSOR_PROFILE
+#define TENSOR_PROFILE_SCOPE(name)   ::profiler::Scope tensor_profile_scope_(name)
+#define TENSOR_PROFILE_INPUT(shape)  tensor_profile_scope_.input(shape)
+#define TENSOR_PROFILE_OUTPUT(shape) tensor_profile_scope_.output(shape)
+#define TENSOR_PROFILE_FLOPS(n)      tensor_profile_scope_.flops(static_cast<double>(n))
+#define TENSOR_PROFILE_ALLOC(bytes)  ::profiler::record_allocation(bytes)
+#else
+#define TENSOR_PROFILE_SCOPE(name)   ((void)0)
+#define TENSOR_PROFILE_INPUT(shape)  ((void)0)
+#define TENSOR_PROFILE_OUTPUT(shape) ((void)0)
+#define TENSOR_PROFILE_FLOPS(n)      ((void)0)
+#define TENSOR_PROFILE_ALLOC(bytes)  ((void)0)
+#endif
+
+#endif //CS2013_TENSOR_LIBRARY_TENSORPROFILER_H
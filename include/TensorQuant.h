@@ -0,0 +1,121 @@
+#ifndef CS2013_TENSOR_LIBRARY_TENSORQUANT_H
+#define CS2013_TENSOR_LIBRARY_TENSORQUANT_H
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Tensor.h"
+
+//
+//INFERENCIA CUANTIZADA INT8
+//
+// Un QTensor guarda una matriz 2D en int8 con escala y zero point por fila, por columna o
+// unicos: valor real = scale * (q - zero_point). quantize() usa el rango [min, max] de cada
+// grupo (asimetrico, q en [-128, 127]) o [-max|x|, max|x|] (simetrico, zero point 0, q en
+// [-127, 127]); el error por elemento queda acotado por scale / 2.
+//
+// QLinear es una capa x * W + b preparada una vez: W se cuantiza simetrico por columna (un
+// canal de salida por columna) y se empaqueta para el kernel int8 x int8 -> int32. En cada
+// forward las filas de x se cuantizan al vuelo (asimetrico por fila) y el epilogo corrige los
+// zero points, vuelve a punto flotante, suma el bias y aplica la activacion sobre cada tile;
+// forward_quantized() ademas recuantiza la salida a int8 para encadenar capas.
+// El acumulador es int32: k (= filas de W) no puede pasar de 65536.
+// Instanciado para float y double.
+//
+
+namespace quant {
+
+// Granularidad de escala / zero point.
+enum class Axis { Tensor, Row, Column };
+
+class QTensor {
+public:
+    QTensor() : axis_(Axis::Tensor), rows_(0), cols_(0) {}
+    // rows x cols en cero, con escala 1 y zero point 0 en cada grupo de axis.
+    QTensor(std::size_t rows, std::size_t cols, Axis axis);
+
+    std::size_t rows() const { return rows_; }
+    std::size_t cols() const { return cols_; }
+    std::size_t numel() const { return data_.size(); }
+    TensorShape shape() const { return TensorShape{rows_, cols_}; }
+    Axis axis() const { return axis_; }
+
+    // Row-major, rows x cols.
+    std::int8_t* data() { return data_.data(); }
+    const std::int8_t* data() const { return data_.data(); }
+    // Un valor por grupo: 1 (Tensor), rows (Row) o cols (Column).
+    std::vector<float>& scales() { return scales_; }
+    const std::vector<float>& scales() const { return scales_; }
+    std::vector<std::int32_t>& zero_points() { return zero_points_; }
+    const std::vector<std::int32_t>& zero_points() const { return zero_points_; }
+
+    // Grupo al que pertenece el elemento (i, j).
+    std::size_t group(std::size_t i, std::size_t j) const {
+        return axis_ == Axis::Row ? i : (axis_ == Axis::Column ? j : 0);
+    }
+    // Con validacion de indices (std::out_of_range).
+    std::int8_t at(std::size_t i, std::size_t j) const;
+    // Datos mas escalas y zero points.
+    std::size_t bytes() const;
+
+private:
+    Axis axis_;
+    std::size_t rows_, cols_;
+    std::vector<std::int8_t> data_;
+    std::vector<float> scales_;
+    std::vector<std::int32_t> zero_points_;
+};
+
+// x tiene que ser 2D (contiguo o vista).
+template <typename T> QTensor quantize(const BasicTensor<T>& x, Axis axis = Axis::Tensor, bool symmetric = false);
+template <typename T> BasicTensor<T> dequantize(const QTensor& q);
+
+// C(m x n) = A(m x k) * B(k x n) en int32, sin escalas ni zero points. A y B row-major con
+// stride de fila lda / ldb; C con stride ldc.
+void gemm_s8(std::size_t m, std::size_t n, std::size_t k,
+             const std::int8_t* a, std::size_t lda,
+             const std::int8_t* b, std::size_t ldb,
+             std::int32_t* c, std::size_t ldc);
+
+template <typename T>
+class QLinear {
+public:
+    // w: (in x out) en punto flotante; se cuantiza simetrico por columna.
+    // b: (out) o (1 x out). act puede ser nullptr; se guarda por referencia.
+    QLinear(const BasicTensor<T>& w, const BasicTensor<T>& b, const TensorTransform* act = nullptr);
+    // w ya cuantizado (Axis::Column o Axis::Tensor, cualquier zero point); sin bias.
+    explicit QLinear(const QTensor& w, const TensorTransform* act = nullptr);
+    QLinear(const QTensor& w, const BasicTensor<T>& b, const TensorTransform* act = nullptr);
+
+    std::size_t in_features() const { return k_; }
+    std::size_t out_features() const { return n_; }
+    // Memoria de la capa: pesos empaquetados, escalas, zero points, sumas por columna y bias.
+    std::size_t weight_bytes() const;
+
+    // x: (m x in). Devuelve (m x out) = act(x * W + b).
+    BasicTensor<T> forward(const BasicTensor<T>& x) const;
+    BasicTensor<T>& forward(const BasicTensor<T>& x, BasicTensor<T>& out) const;
+    // x ya cuantizado (Axis::Row o Axis::Tensor).
+    BasicTensor<T>& forward(const QTensor& x, BasicTensor<T>& out) const;
+    // Igual que forward pero la salida se recuantiza con una escala y zero point fijos
+    // (calibrados de antemano), lista para la siguiente QLinear.
+    QTensor forward_quantized(const QTensor& x, float out_scale, std::int32_t out_zero) const;
+
+private:
+    void init(const QTensor& w, const BasicTensor<T>* b);
+
+    std::size_t k_ = 0, n_ = 0;
+    std::size_t pairs_ = 0, panels_ = 0;          // ceil(k / 2), ceil(n / 8)
+    std::vector<std::int8_t> packed_;            // panels_ x pairs_ x 16
+    std::vector<T> col_scale_;
+    std::vector<std::int32_t> col_zero_;         // vacio: todos los zero points de W son 0
+    std::vector<std::int32_t> col_sum_;          // sum_k W[k][j] (en int8)
+    std::vector<T> bias_;                        // vacio: sin bias
+    const TensorTransform* act_ = nullptr;
+};
+
+// (m x k) x (k x n) dequantizado: a por fila o tensor, b por columna o tensor.
+template <typename T> BasicTensor<T> matmul(const QTensor& a, const QTensor& b);
+
+}
+
+#endif //CS2013_TENSOR_LIBRARY_TENSORQUANT_H
@@ -0,0 +1,53 @@
+#ifndef CS2013_TENSOR_LIBRARY_TENSORRANDOM_H
+#define CS2013_TENSOR_LIBRARY_TENSORRANDOM_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+//
+//NUMEROS ALEATORIOS (Philox4x32-10, basado en contador)
+//
+// Cada bloque de 4 palabras de 32 bits es una funcion pura de (seed, stream, contador), asi que
+// un tensor se puede llenar por trozos en paralelo y el resultado es el mismo bit a bit con
+// cualquier cantidad de hilos. Cada llenado reserva un rango de contadores con un incremento
+// atomico: un Generator se puede usar desde varios hilos a la vez (el orden entre llamadas
+// concurrentes es el orden en que reservan).
+// Un double consume 2 palabras y un float 1; normal usa Box-Muller sobre pares de uniformes.
+//
+
+namespace rng {
+
+// out = Philox4x32-10(clave = key, contador = (counter, stream)).
+void philox4x32(std::uint64_t key, std::uint64_t counter, std::uint64_t stream, std::uint32_t out[4]);
+
+class Generator {
+public:
+    explicit Generator(std::uint64_t seed = 0, std::uint64_t stream = 0);
+    Generator(const Generator& other);
+    Generator& operator=(const Generator& other);
+
+    // Reinicia la secuencia (offset = 0).
+    void manual_seed(std::uint64_t seed, std::uint64_t stream = 0);
+
+    std::uint64_t seed() const { return seed_; }
+    std::uint64_t stream() const { return stream_; }
+    // Bloques consumidos desde el ultimo manual_seed.
+    std::uint64_t offset() const { return offset_.load(); }
+
+    // out[0..n) uniforme en [lo, hi) / normal(mean, stddev). Instanciados para float y double.
+    template <typename T> void uniform(T* out, std::size_t n, T lo, T hi);
+    template <typename T> void normal(T* out, std::size_t n, T mean, T stddev);
+
+private:
+    std::uint64_t seed_;
+    std::uint64_t stream_;
+    std::atomic<std::uint64_t> offset_;
+};
+
+// Generador que usan Tensor::random, normal, xavier_uniform y he_normal por defecto.
+Generator& default_generator();
+void manual_seed(std::uint64_t seed);
+
+}
+
+#endif //CS2013_TENSOR_LIBRARY_TENSORRANDOM_H
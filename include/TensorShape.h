@@ -0,0 +1,104 @@
+#ifndef CS2013_TENSOR_LIBRARY_TENSORSHAPE_H
+#define CS2013_TENSOR_LIBRARY_TENSORSHAPE_H
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <stdexcept>
+#include <vector>
+
+//
+//SHAPE / STRIDES EN LINEA
+//
+// TensorShape guarda hasta kMaxDims valores dentro del objeto (sin heap): mover o copiar un
+// Tensor, consultar su shape o armar la de una expresion no reserva memoria. Tiene la
+// interfaz de std::vector que usa la libreria y se convierte en ambos sentidos, asi que el
+// codigo que pasa std::vector<std::size_t> sigue funcionando.
+//
+
+const std::size_t kMaxDims = 8;
+
+class TensorShape {
+public:
+    typedef std::size_t value_type;
+    typedef std::size_t* iterator;
+    typedef const std::size_t* const_iterator;
+
+    TensorShape() : n_(0), v_() {}
+    TensorShape(std::initializer_list<std::size_t> dims) : n_(0), v_() {
+        check_rank_or_throw(dims.size());
+        for (std::size_t d : dims) v_[n_++] = d;
+    }
+    TensorShape(const std::vector<std::size_t>& dims) : n_(0), v_() {
+        check_rank_or_throw(dims.size());
+        for (std::size_t d = 0; d < dims.size(); ++d) v_[n_++] = dims[d];
+    }
+    explicit TensorShape(std::size_t n) : n_(0), v_() { assign(n, 0); }
+    TensorShape(std::size_t n, std::size_t value) : n_(0), v_() { assign(n, value); }
+
+    operator std::vector<std::size_t>() const { return std::vector<std::size_t>(begin(), end()); }
+
+    std::size_t size() const { return n_; }
+    bool empty() const { return n_ == 0; }
+
+    std::size_t& operator[](std::size_t d) { return v_[d]; }
+    const std::size_t& operator[](std::size_t d) const { return v_[d]; }
+    std::size_t& front() { return v_[0]; }
+    const std::size_t& front() const { return v_[0]; }
+    std::size_t& back() { return v_[n_ - 1]; }
+    const std::size_t& back() const { return v_[n_ - 1]; }
+
+    std::size_t* data() { return v_; }
+    const std::size_t* data() const { return v_; }
+    iterator begin() { return v_; }
+    iterator end() { return v_ + n_; }
+    const_iterator begin() const { return v_; }
+    const_iterator end() const { return v_ + n_; }
+
+    void clear() { n_ = 0; }
+    void reserve(std::size_t n) const { check_rank_or_throw(n); }
+    void assign(std::size_t n, std::size_t value) {
+        check_rank_or_throw(n);
+        n_ = n;
+        std::fill(v_, v_ + n_, value);
+    }
+    void resize(std::size_t n, std::size_t value = 0) {
+        check_rank_or_throw(n);
+        for (std::size_t d = n_; d < n; ++d) v_[d] = value;
+        n_ = n;
+    }
+    void push_back(std::size_t value) {
+        check_rank_or_throw(n_ + 1);
+        v_[n_++] = value;
+    }
+    void pop_back() { --n_; }
+    iterator insert(const_iterator pos, std::size_t value) {
+        check_rank_or_throw(n_ + 1);
+        const std::size_t at = static_cast<std::size_t>(pos - v_);
+        for (std::size_t d = n_; d > at; --d) v_[d] = v_[d - 1];
+        v_[at] = value;
+        ++n_;
+        return v_ + at;
+    }
+    iterator erase(const_iterator pos) {
+        const std::size_t at = static_cast<std::size_t>(pos - v_);
+        for (std::size_t d = at; d + 1 < n_; ++d) v_[d] = v_[d + 1];
+        --n_;
+        return v_ + at;
+    }
+
+private:
+    static void check_rank_or_throw(std::size_t n) {
+        if (n > kMaxDims) throw std::invalid_argument("TensorShape: mas de 8 dimensiones");
+    }
+
+    std::size_t n_;
+    std::size_t v_[kMaxDims];
+};
+
+inline bool operator==(const TensorShape& a, const TensorShape& b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+}
+
+inline bool operator!=(const TensorShape& a, const TensorShape& b) { return !(a == b); }
+
+#endif //CS2013_TENSOR_LIBRARY_TENSORSHAPE_H
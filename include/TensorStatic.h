@@ -0,0 +1,308 @@
+#ifndef CS2013_TENSOR_LIBRARY_TENSORSTATIC_H
+#define CS2013_TENSOR_LIBRARY_TENSORSTATIC_H
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <initializer_list>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include "Tensor.h"
+
+//
+//TENSORES DE SHAPE FIJA: StaticTensor<T, Dims...>
+//
+// La shape y los strides son constantes de compilacion y los elementos viven dentro del
+// objeto (en la pila si es una variable local): crear, copiar o indexar un 3x3 no toca el
+// heap ni calcula strides. Pensado para tensores chicos (geometria 3x3 / 4x4, bias 1x10):
+// las operaciones elemento a elemento y matmul se desenrollan por completo hasta
+// fixed::kUnrollLimit elementos; por encima quedan como bucles de largo constante.
+//
+// No hay broadcast: las operaciones binarias piden la misma shape en los tipos. Para usarlos
+// con Tensor: StaticTensor(tensor) (valida la shape), tensor() y copy_to(out).
+//
+// Todo esta en el header (la shape es parte del tipo, no se puede instanciar en un .cpp).
+//
+
+namespace fixed {
+
+const std::size_t kUnrollLimit = 64;
+
+template <std::size_t... Dims> struct product;
+template <> struct product<> { static const std::size_t value = 1; };
+template <std::size_t D, std::size_t... Rest>
+struct product<D, Rest...> { static const std::size_t value = D * product<Rest...>::value; };
+
+template <typename F, std::size_t... I>
+inline void unrolled(F& f, std::index_sequence<I...>) {
+    const int expand[] = {0, (f(static_cast<std::size_t>(I)), 0)...};
+    (void)expand;
+}
+
+template <typename F>
+inline void looped(F& f, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) f(i);
+}
+
+template <std::size_t N, typename F>
+inline void for_n(F&& f, std::true_type) { unrolled(f, std::make_index_sequence<N>()); }
+
+template <std::size_t N, typename F>
+inline void for_n(F&& f, std::false_type) { looped(f, N); }
+
+// f(0), ..., f(N - 1); desenrollado si N <= kUnrollLimit.
+template <std::size_t N, typename F>
+inline void for_n(F&& f) {
+    for_n<N>(f, std::integral_constant<bool, (N <= kUnrollLimit)>());
+}
+
+}
+
+template <typename T, std::size_t... Dims>
+class StaticTensor {
+    static_assert(sizeof...(Dims) >= 1, "StaticTensor: al menos 1 dimension");
+    static_assert(fixed::product<Dims...>::value > 0, "StaticTensor: ninguna dimension puede ser 0");
+    static_assert(std::is_floating_point<T>::value, "StaticTensor: T tiene que ser float o double");
+
+public:
+    typedef T value_type;
+    static const std::size_t rank = sizeof...(Dims);
+    static const std::size_t count = fixed::product<Dims...>::value;
+
+    static constexpr std::array<std::size_t, sizeof...(Dims)> shape() { return {{Dims...}}; }
+    static constexpr std::size_t dims() { return rank; }
+    static constexpr std::size_t numel() { return count; }
+    static constexpr std::size_t dim(std::size_t d) { return shape()[d]; }
+    // Row-major, en elementos.
+    static constexpr std::size_t stride(std::size_t d) {
+        std::size_t s = 1;
+        for (std::size_t k = d + 1; k < rank; ++k) s *= dim(k);
+        return s;
+    }
+
+    //
+    //CONSTRUCTORES
+    //
+    // Ceros.
+    StaticTensor() : data_() {}
+    // values.size() tiene que ser numel() (row-major).
+    StaticTensor(std::initializer_list<T> values) {
+        if (values.size() != count) {
+            throw std::invalid_argument("StaticTensor: values size does not match shape product");
+        }
+        std::copy(values.begin(), values.end(), data_);
+    }
+    // Copia t (contiguo o vista); su shape tiene que ser (Dims...).
+    explicit StaticTensor(const BasicTensor<T>& t);
+
+    static StaticTensor zeros() { return StaticTensor(); }
+    static StaticTensor ones() { return full(T(1)); }
+    static StaticTensor full(T value) {
+        StaticTensor r;
+        fixed::for_n<count>([&](std::size_t i) { r.data_[i] = value; });
+        return r;
+    }
+
+    //
+    //ACCESO
+    //
+    // Sin validar (el indice se arma con los strides constantes).
+    template <typename... I>
+    T& operator()(I... idx) { return data_[offset(idx...)]; }
+    template <typename... I>
+    const T& operator()(I... idx) const { return data_[offset(idx...)]; }
+
+    // Valida cada indice como Tensor::at.
+    template <typename... I>
+    T& at(I... idx) { return data_[checked_offset(idx...)]; }
+    template <typename... I>
+    const T& at(I... idx) const { return data_[checked_offset(idx...)]; }
+
+    // Indice plano row-major, sin validar.
+    T& operator[](std::size_t i) { return data_[i]; }
+    const T& operator[](std::size_t i) const { return data_[i]; }
+
+    T* data() { return data_; }
+    const T* data() const { return data_; }
+    T* begin() { return data_; }
+    T* end() { return data_ + count; }
+    const T* begin() const { return data_; }
+    const T* end() const { return data_ + count; }
+
+    //
+    //CONVERSION A Tensor
+    //
+    BasicTensor<T> tensor() const;
+    // out tiene que tener shape (Dims...); puede ser una vista. No reserva memoria.
+    void copy_to(BasicTensor<T>& out) const;
+
+    //
+    //OPERACIONES (elemento a elemento, desenrolladas)
+    //
+    StaticTensor& operator+=(const StaticTensor& o) {
+        fixed::for_n<count>([&](std::size_t i) { data_[i] += o.data_[i]; });
+        return *this;
+    }
+    StaticTensor& operator-=(const StaticTensor& o) {
+        fixed::for_n<count>([&](std::size_t i) { data_[i] -= o.data_[i]; });
+        return *this;
+    }
+    StaticTensor& operator*=(const StaticTensor& o) {
+        fixed::for_n<count>([&](std::size_t i) { data_[i] *= o.data_[i]; });
+        return *this;
+    }
+    StaticTensor& operator*=(double scalar) {
+        const T s = static_cast<T>(scalar);
+        fixed::for_n<count>([&](std::size_t i) { data_[i] *= s; });
+        return *this;
+    }
+
+    // Mismo kernel vectorizado que Tensor::apply (una llamada virtual por tensor).
+    StaticTensor apply(const TensorTransform& op) const {
+        StaticTensor r;
+        op.apply(data_, r.data_, count);
+        return r;
+    }
+
+    T sum() const {
+        T s = T(0);
+        fixed::for_n<count>([&](std::size_t i) { s += data_[i]; });
+        return s;
+    }
+
+private:
+    template <typename... I>
+    static std::size_t offset(I... idx) {
+        static_assert(sizeof...(I) == rank, "StaticTensor: cantidad de indices distinta de dims()");
+        const std::size_t i[] = {static_cast<std::size_t>(idx)...};
+        std::size_t off = 0;
+        for (std::size_t d = 0; d < rank; ++d) off += i[d] * stride(d);
+        return off;
+    }
+
+    template <typename... I>
+    static std::size_t checked_offset(I... idx) {
+        static_assert(sizeof...(I) == rank, "StaticTensor: cantidad de indices distinta de dims()");
+        const std::size_t i[] = {static_cast<std::size_t>(idx)...};
+        for (std::size_t d = 0; d < rank; ++d) {
+            if (i[d] >= dim(d)) throw std::out_of_range("StaticTensor: index out of range");
+        }
+        return offset(idx...);
+    }
+
+    // Compara con shape() dimension a dimension, sin construir otra shape.
+    static bool same_shape(const TensorShape& s) {
+        if (s.size() != rank) return false;
+        for (std::size_t d = 0; d < rank; ++d)
+            if (s[d] != dim(d)) return false;
+        return true;
+    }
+
+    T data_[count];
+};
+
+//
+//CONVERSION
+//
+
+template <typename T, std::size_t... Dims>
+StaticTensor<T, Dims...>::StaticTensor(const BasicTensor<T>& t) {
+    if (!same_shape(t.shape_)) {
+        throw std::invalid_argument("StaticTensor: la shape del Tensor no coincide con la del tipo");
+    }
+    if (t.is_contiguous()) {
+        std::copy(t.data_, t.data_ + count, data_);
+        return;
+    }
+    fixed::for_n<count>([&](std::size_t f) {
+        std::size_t off = 0;
+        for (std::size_t d = 0; d < rank; ++d) off += (f / stride(d) % dim(d)) * t.strides_[d];
+        data_[f] = t.data_[off];
+    });
+}
+
+template <typename T, std::size_t... Dims>
+BasicTensor<T> StaticTensor<T, Dims...>::tensor() const {
+    BasicTensor<T> r;
+    r.shape_ = TensorShape{Dims...};
+    r.size_ = count;
+    r.compute_strides();
+    r.allocate_data();
+    std::copy(data_, data_ + count, r.data_);
+    return r;
+}
+
+template <typename T, std::size_t... Dims>
+void StaticTensor<T, Dims...>::copy_to(BasicTensor<T>& out) const {
+    if (!same_shape(out.shape_)) {
+        throw std::invalid_argument("StaticTensor::copy_to: out debe tener la shape del StaticTensor");
+    }
+    if (out.is_contiguous()) {
+        std::copy(data_, data_ + count, out.data_);
+        return;
+    }
+    fixed::for_n<count>([&](std::size_t f) {
+        std::size_t off = 0;
+        for (std::size_t d = 0; d < rank; ++d) off += (f / stride(d) % dim(d)) * out.strides_[d];
+        out.data_[off] = data_[f];
+    });
+}
+
+//
+//OPERADORES
+//
+
+template <typename T, std::size_t... Dims>
+StaticTensor<T, Dims...> operator+(StaticTensor<T, Dims...> a, const StaticTensor<T, Dims...>& b) { return a += b; }
+
+template <typename T, std::size_t... Dims>
+StaticTensor<T, Dims...> operator-(StaticTensor<T, Dims...> a, const StaticTensor<T, Dims...>& b) { return a -= b; }
+
+template <typename T, std::size_t... Dims>
+StaticTensor<T, Dims...> operator*(StaticTensor<T, Dims...> a, const StaticTensor<T, Dims...>& b) { return a *= b; }
+
+template <typename T, std::size_t... Dims>
+StaticTensor<T, Dims...> operator*(StaticTensor<T, Dims...> a, double scalar) { return a *= scalar; }
+
+// Producto punto de dos vectores: devuelve el escalar (sin tensor de 1 elemento).
+template <typename T, std::size_t N>
+T dot(const StaticTensor<T, N>& a, const StaticTensor<T, N>& b) {
+    T s = T(0);
+    fixed::for_n<N>([&](std::size_t i) { s += a[i] * b[i]; });
+    return s;
+}
+
+// (M x K) x (K x N), desenrollado en (i, j) y en k.
+template <typename T, std::size_t M, std::size_t K, std::size_t N>
+StaticTensor<T, M, N> matmul(const StaticTensor<T, M, K>& a, const StaticTensor<T, K, N>& b) {
+    StaticTensor<T, M, N> r;
+    fixed::for_n<M * N>([&](std::size_t ij) {
+        const std::size_t i = ij / N, j = ij % N;
+        T acc = T(0);
+        fixed::for_n<K>([&](std::size_t k) { acc += a[i * K + k] * b[k * N + j]; });
+        r[ij] = acc;
+    });
+    return r;
+}
+
+// (M x K) x (K): matriz por vector.
+template <typename T, std::size_t M, std::size_t K>
+StaticTensor<T, M> matmul(const StaticTensor<T, M, K>& a, const StaticTensor<T, K>& x) {
+    StaticTensor<T, M> r;
+    fixed::for_n<M>([&](std::size_t i) {
+        T acc = T(0);
+        fixed::for_n<K>([&](std::size_t k) { acc += a[i * K + k] * x[k]; });
+        r[i] = acc;
+    });
+    return r;
+}
+
+template <typename T, std::size_t M, std::size_t N>
+StaticTensor<T, N, M> transpose(const StaticTensor<T, M, N>& a) {
+    StaticTensor<T, N, M> r;
+    fixed::for_n<M * N>([&](std::size_t ij) { r[(ij % N) * M + ij / N] = a[ij]; });
+    return r;
+}
+
+#endif //CS2013_TENSOR_LIBRARY_TENSORSTATIC_H
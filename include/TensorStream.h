@@ -0,0 +1,157 @@
+#ifndef CS2013_TENSOR_LIBRARY_TENSORSTREAM_H
+#define CS2013_TENSOR_LIBRARY_TENSORSTREAM_H
+#include <cstddef>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+#include "Tensor.h"
+#include "TensorIO.h"
+
+//
+//INFERENCIA POR TROZOS DE FILAS (streaming)
+//
+// StreamingPipeline lee filas de un RowSource de a chunk_rows, pasa cada trozo por sus etapas
+// (linear, apply, ...) y entrega el resultado a un RowSink. La memoria no depende de la
+// cantidad total de filas: cada etapa escribe siempre en el mismo buffer (chunk_rows x columnas)
+// y la entrada usa dos buffers, de modo que un hilo lector llena el siguiente trozo mientras
+// se calcula el actual. Instanciado para float y double.
+//
+
+namespace stream {
+
+//
+//FUENTES
+//
+
+template <typename T>
+class RowSource {
+public:
+    virtual ~RowSource() {}
+    virtual std::size_t cols() const = 0;
+    // Copia hasta max_rows filas siguientes en dst (row-major, cols() por fila).
+    // Devuelve las filas copiadas; 0 cuando no quedan.
+    virtual std::size_t read(T* dst, std::size_t max_rows) = 0;
+};
+
+// Filas generadas por fn(primera_fila, filas, dst).
+template <typename T>
+class GeneratorSource : public RowSource<T> {
+public:
+    typedef std::function<void(std::size_t, std::size_t, T*)> Fn;
+    GeneratorSource(std::size_t rows, std::size_t cols, Fn fn);
+    std::size_t cols() const override { return cols_; }
+    std::size_t read(T* dst, std::size_t max_rows) override;
+
+private:
+    std::size_t rows_, cols_, next_ = 0;
+    Fn fn_;
+};
+
+// Archivo .tensor con mmap_load: la dimension 0 son las filas y el resto se aplana en columnas.
+// Solo las paginas de los trozos leidos pasan por memoria (y el sistema puede descartarlas).
+template <typename T>
+class TensorFileSource : public RowSource<T> {
+public:
+    explicit TensorFileSource(const std::string& path);
+    std::size_t rows() const { return rows_; }
+    std::size_t cols() const override { return cols_; }
+    std::size_t read(T* dst, std::size_t max_rows) override;
+
+private:
+    BasicTensor<T> data_;
+    std::size_t rows_, cols_, next_ = 0;
+};
+
+//
+//DESTINOS
+//
+
+template <typename T>
+class RowSink {
+public:
+    virtual ~RowSink() {}
+    // rows: (filas del trozo x columnas de salida). Solo es valido durante la llamada.
+    virtual void write(const BasicTensor<T>& rows) = 0;
+    // Se llama una vez al terminar run().
+    virtual void finish() {}
+};
+
+// fn(primera_fila, filas) por cada trozo.
+template <typename T>
+class CallbackSink : public RowSink<T> {
+public:
+    typedef std::function<void(std::size_t, const BasicTensor<T>&)> Fn;
+    explicit CallbackSink(Fn fn) : fn_(fn) {}
+    void write(const BasicTensor<T>& rows) override;
+
+private:
+    Fn fn_;
+    std::size_t next_ = 0;
+};
+
+// Escribe un .tensor de shape (filas, cols) a medida que llegan los trozos; finish() completa
+// la cabecera (filas y checksum). El archivo se puede abrir luego con load / mmap_load.
+template <typename T>
+class TensorFileSink : public RowSink<T> {
+public:
+    TensorFileSink(const std::string& path, std::size_t cols);
+    ~TensorFileSink() override;
+    void write(const BasicTensor<T>& rows) override;
+    void finish() override;
+    std::size_t rows() const { return rows_; }
+
+private:
+    std::string path_;
+    std::FILE* f_;
+    std::size_t cols_, rows_ = 0;
+    io::Checksum checksum_;
+};
+
+//
+//PIPELINE
+//
+
+template <typename T>
+class StreamingPipeline {
+public:
+    // Etapa generica: out ya tiene shape (filas, out_cols) y es contiguo; se escribe en el.
+    typedef std::function<void(const BasicTensor<T>& in, BasicTensor<T>& out)> StageFn;
+
+    explicit StreamingPipeline(std::size_t chunk_rows = 4096, bool read_ahead = true);
+
+    // act(x * w + b) con w (in x out); act puede ser nullptr. w, b y act se guardan por
+    // referencia y tienen que vivir mientras se use el pipeline.
+    StreamingPipeline& linear(const BasicTensor<T>& w, const BasicTensor<T>& b,
+                              const TensorTransform* act = nullptr);
+    StreamingPipeline& apply(const TensorTransform& op);
+    StreamingPipeline& stage(std::size_t out_cols, StageFn fn);
+
+    std::size_t chunk_rows() const { return chunk_rows_; }
+    // Columnas que tiene que tener la entrada / que produce la ultima etapa; 0 mientras no se
+    // sepan (pipeline que empieza con apply: se toman de la fuente en run()).
+    std::size_t in_cols() const;
+    std::size_t out_cols() const;
+
+    // Procesa toda la fuente y devuelve la cantidad de filas. Llama a sink.finish() al final.
+    std::size_t run(RowSource<T>& source, RowSink<T>& sink);
+
+private:
+    struct Stage {
+        std::size_t out_cols;   // 0: las mismas que la entrada (apply sin columnas conocidas)
+        StageFn fn;
+    };
+
+    void prepare_buffers(std::size_t cols);
+    void process(const BasicTensor<T>& in, std::size_t rows, RowSink<T>& sink);
+
+    std::size_t chunk_rows_;
+    bool read_ahead_;
+    std::size_t in_cols_ = 0;
+    std::vector<Stage> stages_;
+    std::vector<BasicTensor<T> > buffers_;   // salida de cada etapa (chunk_rows x out_cols), en run()
+};
+
+}
+
+#endif //CS2013_TENSOR_LIBRARY_TENSORSTREAM_H
@@ -5,10 +5,17 @@
 #ifndef CS2013_TENSOR_LIBRARY_TENSORTRANSFORM_H
 #define CS2013_TENSOR_LIBRARY_TENSORTRANSFORM_H
 #include <cmath>
+#include <cstddef>
 
 class TensorTransform {
 public:
     virtual double apply(double x) const = 0;
+    // Aplica la transformacion a n valores contiguos (in y out pueden ser el mismo buffer).
+    // Por defecto llama a apply(x) por elemento; las transformaciones de la libreria la
+    // sobreescriben con kernels vectorizados (ver TensorTransform.cpp).
+    virtual void apply(const double* in, double* out, std::size_t n) const;
+    // Lo mismo para FloatTensor; por defecto pasa cada valor por apply(double).
+    virtual void apply(const float* in, float* out, std::size_t n) const;
     virtual ~TensorTransform() = default;
 };
 
@@ -17,6 +24,8 @@ public:
     double apply(double x) const override {
         return (x > 0.0) ? x : 0.0;
     }
+    void apply(const double* in, double* out, std::size_t n) const override;
+    void apply(const float* in, float* out, std::size_t n) const override;
 };
 
 class Sigmoid : public TensorTransform {
@@ -24,8 +33,40 @@ public:
     double apply(double x) const override {
         return 1.0 / (1.0 + std::exp(-x));
     }
+    void apply(const double* in, double* out, std::size_t n) const override;
+    void apply(const float* in, float* out, std::size_t n) const override;
+};
+
+class Tanh : public TensorTransform {
+public:
+    double apply(double x) const override {
+        return std::tanh(x);
+    }
+    void apply(const double* in, double* out, std::size_t n) const override;
+    void apply(const float* in, float* out, std::size_t n) const override;
+};
+
+// Aproximacion tanh: 0.5 x (1 + tanh(sqrt(2/pi) (x + 0.044715 x^3)))
+class GELU : public TensorTransform {
+public:
+    double apply(double x) const override {
+        const double u = 0.7978845608028654 * (x + 0.044715 * x * x * x);
+        return 0.5 * x * (1.0 + std::tanh(u));
+    }
+    void apply(const double* in, double* out, std::size_t n) const override;
+    void apply(const float* in, float* out, std::size_t n) const override;
+};
+
+// x * sigmoid(x)
+class SiLU : public TensorTransform {
+public:
+    double apply(double x) const override {
+        return x / (1.0 + std::exp(-x));
+    }
+    void apply(const double* in, double* out, std::size_t n) const override;
+    void apply(const float* in, float* out, std::size_t n) const override;
 };
 
 
 
-#endif //CS2013_TENSOR_LIBRARY_TENSORTRANSFORM_H
\ No newline at end of file
+#endif //CS2013_TENSOR_LIBRARY_TENSORTRANSFORM_H
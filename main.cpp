@@ -5,8 +5,8 @@
 #include <iostream>
 #include <vector>
 #include <stdexcept>
-#include <cstdlib>
 #include "include/Tensor.h"
+#include "include/TensorProfiler.h"
 
 static std::vector<std::size_t> shape2(std::size_t a, std::size_t b) {
     std::vector<std::size_t> s;
@@ -25,7 +25,7 @@ static std::vector<std::size_t> shape3(std::size_t a, std::size_t b, std::size_t
 
 static void print_shape(const Tensor& t, const char* name) {
     std::cout << name << " shape: (";
-    const std::vector<std::size_t>& sh = t.shape();
+    const TensorShape& sh = t.shape();
     for (std::size_t i = 0; i < sh.size(); ++i) {
         std::cout << sh[i];
         if (i + 1 < sh.size()) std::cout << ", ";
@@ -42,7 +42,7 @@ static void print_row_prefix(const Tensor& t, std::size_t row, std::size_t k, co
 }
 
 int main() {
-    std::srand(0);
+    rng::manual_seed(0);
 
     ReLU relu;
     Sigmoid sigmoid;
@@ -107,6 +107,12 @@ int main() {
 
     print_row_prefix(Y, 0, 10, "Y");
 
+    // Con -DTENSOR_ENABLE_PROFILER=ON: tiempos por operacion y traza para chrome://tracing.
+    if (profiler::compiled_in()) {
+        profiler::print_summary(std::cout);
+        profiler::write_chrome_trace("trace.json");
+    }
+
     return 0;
 
 }
@@ -3,22 +3,120 @@
 //
 
 #include "../include/Tensor.h"
+#include "../include/TensorAllocator.h"
+#include "../include/TensorGemm.h"
+#include "../include/TensorIter.h"
+#include "../include/TensorParallel.h"
+#include "../include/TensorProfiler.h"
+#include <algorithm>
 #include <iostream>
 #include <utility>
-#include <cstdlib>
+#include <cmath>
+#include <cstring>
 #include <stdexcept>
+#include <string>
 
 
 //
 //Constructor VACIO
 //
-Tensor::Tensor() : shape_(), strides_(), size_(0), data_(nullptr) {}
+template <typename T>
+BasicTensor<T>::BasicTensor() : shape_(), strides_(), size_(0), storage_(), data_(nullptr) {}
+
+//
+//MEMORIA: el buffer se pide al allocator por defecto y se devuelve al mismo
+// cuando muere la ultima vista que lo usa
+//
+
+namespace {
+
+struct AllocatorDeleter {
+    TensorAllocator* alloc;
+    std::size_t bytes;
+    void operator()(void* p) const { alloc->deallocate(p, bytes); }
+};
+
+// dst <- src elemento a elemento, ambos con strides arbitrarios.
+template <typename T>
+void copy_strided(const T* src, const TensorShape& src_strides,
+                  T* dst, const TensorShape& dst_strides,
+                  const TensorShape& shape) {
+    const TensorShape* shapes[2] = {&shape, &shape};
+    const TensorShape* strides[2] = {&dst_strides, &src_strides};
+    const iter::Plan plan = iter::make_plan(shape, 2, shapes, strides);
+    const std::size_t cols = plan.cols();
+    const std::size_t ds = plan.inner_stride(0), ss = plan.inner_stride(1);
+    iter::for_each_row(plan, [&](const std::size_t* off) {
+        T* o = dst + off[0];
+        const T* in = src + off[1];
+        if ((ss == 1 && ds == 1) || cols == 1) {
+            for (std::size_t j = 0; j < cols; ++j) o[j] = in[j];
+        } else {
+            for (std::size_t j = 0; j < cols; ++j) o[j * ds] = in[j * ss];
+        }
+    });
+}
+
+}
+
+template <typename T>
+void BasicTensor<T>::allocate_data() {
+    TensorAllocator* alloc = &default_allocator();
+    const std::size_t bytes = size_ * sizeof(T);
+    data_ = static_cast<T*>(alloc->allocate(bytes));
+    TENSOR_PROFILE_ALLOC(bytes);
+    AllocatorDeleter del;
+    del.alloc = alloc;
+    del.bytes = bytes;
+    storage_ = std::shared_ptr<T>(data_, del);
+}
+
+template <typename T>
+void BasicTensor<T>::release_data() {
+    storage_.reset();
+    data_ = nullptr;
+}
+
+template <typename T>
+bool BasicTensor<T>::owns_buffer() const {
+    return data_ != nullptr && storage_.use_count() == 1 && is_contiguous();
+}
+
+template <typename T>
+BasicTensor<T> BasicTensor<T>::share_with(const TensorShape& shape,
+                                          const TensorShape& strides,
+                                          std::size_t offset) const {
+    BasicTensor<T> out;
+    out.shape_ = shape;
+    out.strides_ = strides;
+    out.size_ = product(shape);
+    out.storage_ = storage_;
+    out.data_ = data_ + offset;
+    return out;
+}
+
+template <typename T>
+void BasicTensor<T>::prepare_out_or_throw(const TensorShape& shape, const char* fn) {
+    if (data_ != nullptr) {
+        if (shape_ != shape)
+            throw std::invalid_argument(std::string(fn) + ": out tiene una shape distinta a la del resultado");
+        if (!is_contiguous())
+            throw std::invalid_argument(std::string(fn) + ": out tiene que ser contiguo");
+        return;
+    }
+    validate_shape_or_throw(shape);
+    shape_ = shape;
+    size_ = product(shape);
+    compute_strides();
+    allocate_data();
+}
 
 //
 //PRODuCTO DE VECTORES
 //
 
-std::size_t Tensor::product(const std::vector<std::size_t> &shape) {
+template <typename T>
+std::size_t BasicTensor<T>::product(const TensorShape &shape) {
     std::size_t p=1;
     for (std::size_t x :shape) p*=x;
     return p;
@@ -27,15 +125,17 @@ std::size_t Tensor::product(const std::vector<std::size_t> &shape) {
 //
 //VALIDACION DEl VECTOR
 //
-void Tensor::validate_shape_or_throw(const std::vector<std::size_t> &shape) const {
-    if (shape.empty() || shape.size() > 3)
-        throw std::invalid_argument("Tensor: shape tiene que tener de 1 a 3 dimensiones");
+template <typename T>
+void BasicTensor<T>::validate_shape_or_throw(const TensorShape &shape) const {
+    if (shape.empty())
+        throw std::invalid_argument("Tensor: shape tiene que tener al menos 1 dimension");
     for (std::size_t d :shape) {
-        if (d==0) throw std::invalid_argument("Tensor: Las dimensiones de shape deben ser mayores a 0 < x y menores que x<3");
+        if (d==0) throw std::invalid_argument("Tensor: Las dimensiones de shape deben ser mayores a 0");
     }
 }
 
-void Tensor::compute_strides() {
+template <typename T>
+void BasicTensor<T>::compute_strides() {
     strides_.assign(shape_.size(), 1);
 
     for (int i = static_cast<int>(shape_.size()) - 2; i >= 0; --i) {
@@ -48,7 +148,8 @@ void Tensor::compute_strides() {
 //CONSTRUCTOR PRINCIPAL
 //
 
-Tensor::Tensor(const std::vector<std::size_t>& shape, const std::vector<double>& values)
+template <typename T>
+BasicTensor<T>::BasicTensor(const TensorShape& shape, const std::vector<T>& values)
     : shape_(shape) {
 
     validate_shape_or_throw(shape_);
@@ -60,7 +161,7 @@ Tensor::Tensor(const std::vector<std::size_t>& shape, const std::vector<double>&
 
     compute_strides();
 
-    data_ = new double[size_];
+    allocate_data();
     for (std::size_t i = 0; i < size_; ++i)
         data_[i] = values[i];
 
@@ -70,66 +171,78 @@ Tensor::Tensor(const std::vector<std::size_t>& shape, const std::vector<double>&
 // DESTRUCTOR
 //
 
-Tensor::~Tensor() {
-    delete[] data_;
+template <typename T>
+BasicTensor<T>::~BasicTensor() {
+    release_data();
 }
 
 //
 //CONSTRUCTOR DE COPIA
 //
 
-Tensor::Tensor(const Tensor& other)
+// Copia profunda: el resultado es contiguo y tiene su propio buffer aunque other sea una vista.
+template <typename T>
+BasicTensor<T>::BasicTensor(const BasicTensor<T>& other)
     : shape_(other.shape_),
-      strides_(other.strides_),
+      strides_(),
       size_(other.size_),
+      storage_(),
       data_(nullptr) {
 
+    compute_strides();
     if (size_ > 0) {
-        data_ = new double[size_];
-        for (std::size_t i = 0; i < size_; ++i) {
-            data_[i] = other.data_[i];
-        }
+        TENSOR_PROFILE_SCOPE("Tensor::copy");
+        TENSOR_PROFILE_INPUT(shape_);
+        allocate_data();
+        copy_strided(other.data_, other.strides_, data_, strides_, shape_);
     }
 }
 
 
-Tensor& Tensor::operator=(const Tensor& other) {
+template <typename T>
+BasicTensor<T>& BasicTensor<T>::operator=(const BasicTensor<T>& other) {
     if (this == &other) return *this;
 
-    delete[] data_;
+    // Mismo numero de elementos y buffer propio: se reutiliza.
+    if (size_ != other.size_ || !owns_buffer() || shares_storage(other)) {
+        release_data();
+    }
 
     shape_ = other.shape_;
-    strides_ = other.strides_;
     size_ = other.size_;
+    compute_strides();
 
-    data_ = nullptr;
     if (size_ > 0) {
-        data_ = new double[size_];
-        for (std::size_t i = 0; i < size_; ++i) {
-            data_[i] = other.data_[i];
-        }
+        TENSOR_PROFILE_SCOPE("Tensor::copy");
+        TENSOR_PROFILE_INPUT(shape_);
+        if (data_ == nullptr) allocate_data();
+        copy_strided(other.data_, other.strides_, data_, strides_, shape_);
     }
     return *this;
 }
 
-Tensor::Tensor(Tensor&& other) noexcept
+template <typename T>
+BasicTensor<T>::BasicTensor(BasicTensor<T>&& other) noexcept
     : shape_(std::move(other.shape_)),
       strides_(std::move(other.strides_)),
       size_(other.size_),
+      storage_(std::move(other.storage_)),
       data_(other.data_) {
 
     other.size_ = 0;
     other.data_ = nullptr;
 }
 
-Tensor& Tensor::operator=(Tensor&& other) noexcept {
+template <typename T>
+BasicTensor<T>& BasicTensor<T>::operator=(BasicTensor<T>&& other) noexcept {
     if (this == &other) return *this;
 
-    delete[] data_;
+    release_data();
 
     shape_ = std::move(other.shape_);
     strides_ = std::move(other.strides_);
     size_ = other.size_;
+    storage_ = std::move(other.storage_);
     data_ = other.data_;
 
     other.size_ = 0;
@@ -138,17 +251,19 @@ Tensor& Tensor::operator=(Tensor&& other) noexcept {
     return *this;
 }
 
-std::size_t Tensor::offset(std::size_t i) const {
+template <typename T>
+std::size_t BasicTensor<T>::offset(std::size_t i) const {
     if (shape_.size() != 1) {
         throw std::invalid_argument("Tensor: expected 1D");
     }
     if (i >= shape_[0]) {
         throw std::out_of_range("Tensor: index out of range");
     }
-    return i;
+    return i * strides_[0];
 }
 
-std::size_t Tensor::offset(std::size_t i, std::size_t j) const {
+template <typename T>
+std::size_t BasicTensor<T>::offset(std::size_t i, std::size_t j) const {
     if (shape_.size() != 2) {
         throw std::invalid_argument("Tensor: expected 2D");
     }
@@ -158,7 +273,8 @@ std::size_t Tensor::offset(std::size_t i, std::size_t j) const {
     return i * strides_[0] + j * strides_[1];
 }
 
-std::size_t Tensor::offset(std::size_t i, std::size_t j, std::size_t k) const {
+template <typename T>
+std::size_t BasicTensor<T>::offset(std::size_t i, std::size_t j, std::size_t k) const {
     if (shape_.size() != 3) {
         throw std::invalid_argument("Tensor: expected 3D");
     }
@@ -168,27 +284,58 @@ std::size_t Tensor::offset(std::size_t i, std::size_t j, std::size_t k) const {
     return i * strides_[0] + j * strides_[1] + k * strides_[2];
 }
 
-double& Tensor::at(std::size_t i) {
+template <typename T>
+std::size_t BasicTensor<T>::offset(const std::vector<std::size_t>& idx) const {
+    if (idx.size() != shape_.size()) {
+        throw std::invalid_argument("Tensor: la cantidad de indices debe ser igual a dims()");
+    }
+    std::size_t off = 0;
+    for (std::size_t d = 0; d < idx.size(); ++d) {
+        if (idx[d] >= shape_[d]) {
+            throw std::out_of_range("Tensor: index out of range");
+        }
+        off += idx[d] * strides_[d];
+    }
+    return off;
+}
+
+template <typename T>
+T& BasicTensor<T>::at(const std::vector<std::size_t>& idx) {
+    return data_[offset(idx)];
+}
+
+template <typename T>
+const T& BasicTensor<T>::at(const std::vector<std::size_t>& idx) const {
+    return data_[offset(idx)];
+}
+
+template <typename T>
+T& BasicTensor<T>::at(std::size_t i) {
     return data_[offset(i)];
 }
 
-double& Tensor::at(std::size_t i, std::size_t j) {
+template <typename T>
+T& BasicTensor<T>::at(std::size_t i, std::size_t j) {
     return data_[offset(i, j)];
 }
 
-double& Tensor::at(std::size_t i, std::size_t j, std::size_t k) {
+template <typename T>
+T& BasicTensor<T>::at(std::size_t i, std::size_t j, std::size_t k) {
     return data_[offset(i, j, k)];
 }
 
-const double& Tensor::at(std::size_t i) const {
+template <typename T>
+const T& BasicTensor<T>::at(std::size_t i) const {
     return data_[offset(i)];
 }
 
-const double& Tensor::at(std::size_t i, std::size_t j) const {
+template <typename T>
+const T& BasicTensor<T>::at(std::size_t i, std::size_t j) const {
     return data_[offset(i, j)];
 }
 
-const double& Tensor::at(std::size_t i, std::size_t j, std::size_t k) const {
+template <typename T>
+const T& BasicTensor<T>::at(std::size_t i, std::size_t j, std::size_t k) const {
     return data_[offset(i, j, k)];
 }
 
@@ -197,67 +344,108 @@ const double& Tensor::at(std::size_t i, std::size_t j, std::size_t k) const {
 //MATRICES AUTOMATICAS
 //
 
-Tensor Tensor::zeros(const std::vector<std::size_t>& shape) {
+template <typename T>
+BasicTensor<T> BasicTensor<T>::zeros(const TensorShape& shape) {
+    TENSOR_PROFILE_SCOPE("Tensor::zeros");
+    TENSOR_PROFILE_OUTPUT(shape);
 
-    Tensor t;
+    BasicTensor<T> t;
     t.validate_shape_or_throw(shape);
     t.shape_ = shape;
     t.size_ = product(shape);
     t.compute_strides();
 
-    t.data_ = new double[t.size_];
+    t.allocate_data();
     for (std::size_t i = 0; i < t.size_; ++i) t.data_[i] = 0.0;
 
     return t;
 }
 
-Tensor Tensor::ones(const std::vector<std::size_t> &shape) {
+template <typename T>
+BasicTensor<T> BasicTensor<T>::ones(const TensorShape &shape) {
+    TENSOR_PROFILE_SCOPE("Tensor::ones");
+    TENSOR_PROFILE_OUTPUT(shape);
 
-    Tensor t;
+    BasicTensor<T> t;
     t.validate_shape_or_throw(shape);
     t.shape_ = shape;
     t.size_ = product(shape);
     t.compute_strides();
 
-    t.data_ = new double [t.size_];
+    t.allocate_data();
     for (std::size_t i= 0; i < t.size_; i++) t.data_[i] = 1;
 
     return t;
 }
 
-Tensor Tensor::random(const std::vector<std::size_t> &shape, double min, double max) {
+template <typename T>
+BasicTensor<T> BasicTensor<T>::random(const TensorShape &shape, T min, T max,
+                                      rng::Generator& gen) {
     if (!(min<max))
         throw std::invalid_argument("Tensor::random: min debe ser < max");
-    Tensor t;
-    t.validate_shape_or_throw(shape);
-    t.shape_ = shape;
-    t.size_ = product(shape);
-    t.compute_strides();
+    TENSOR_PROFILE_SCOPE("Tensor::random");
+    TENSOR_PROFILE_OUTPUT(shape);
+    BasicTensor<T> t;
+    t.prepare_out_or_throw(shape, "Tensor::random");
+    gen.uniform(t.data_, t.size_, min, max);
+    return t;
+}
 
-    t.data_ = new double[t.size_];
-    for (std::size_t i= 0; i < t.size_;i++) {
-        double u = (double)rand() / (double)RAND_MAX;
-        t.data_[i] = min + (max -min) * u;
-    }
+template <typename T>
+BasicTensor<T> BasicTensor<T>::normal(const TensorShape &shape, T mean, T stddev,
+                                      rng::Generator& gen) {
+    if (!(stddev >= 0))
+        throw std::invalid_argument("Tensor::normal: stddev debe ser >= 0");
+    TENSOR_PROFILE_SCOPE("Tensor::normal");
+    TENSOR_PROFILE_OUTPUT(shape);
+    BasicTensor<T> t;
+    t.prepare_out_or_throw(shape, "Tensor::normal");
+    gen.normal(t.data_, t.size_, mean, stddev);
+    return t;
+}
+
+template <typename T>
+BasicTensor<T> BasicTensor<T>::xavier_uniform(const TensorShape &shape, rng::Generator& gen) {
+    TENSOR_PROFILE_SCOPE("Tensor::xavier_uniform");
+    TENSOR_PROFILE_OUTPUT(shape);
+    BasicTensor<T> t;
+    t.prepare_out_or_throw(shape, "Tensor::xavier_uniform");
+    const double fan_out = static_cast<double>(shape.back());
+    const double fan_in = static_cast<double>(t.size_) / fan_out;
+    const T a = static_cast<T>(std::sqrt(6.0 / (fan_in + fan_out)));
+    gen.uniform(t.data_, t.size_, -a, a);
+    return t;
+}
 
+template <typename T>
+BasicTensor<T> BasicTensor<T>::he_normal(const TensorShape &shape, rng::Generator& gen) {
+    TENSOR_PROFILE_SCOPE("Tensor::he_normal");
+    TENSOR_PROFILE_OUTPUT(shape);
+    BasicTensor<T> t;
+    t.prepare_out_or_throw(shape, "Tensor::he_normal");
+    const double fan_in = static_cast<double>(t.size_) / static_cast<double>(shape.back());
+    gen.normal(t.data_, t.size_, T(0), static_cast<T>(std::sqrt(2.0 / fan_in)));
     return t;
 }
 
-Tensor Tensor::arange(long long start, long long end) {
+template <typename T>
+BasicTensor<T> BasicTensor<T>::arange(long long start, long long end) {
     if (end <= start)
         throw std::invalid_argument("Tensor::arange: end debe ser > start.");
 
     std::size_t n =(std::size_t)(end-start);
-    Tensor t;
+    TENSOR_PROFILE_SCOPE("Tensor::arange");
+    TENSOR_PROFILE_OUTPUT(TensorShape(1, n));
+    BasicTensor<T> t;
     t.shape_.clear();
     t.shape_.push_back(n);
     t.validate_shape_or_throw(t.shape_);
     t.size_ = n;
     t.compute_strides();
 
-    t.data_ = new double[n];
+    t.allocate_data();
     for (std::size_t i = 0; i < n; ++i) {
-        t.data_[i] = (double)(start + (long long)i);
+        t.data_[i] = static_cast<T>(start + (long long)i);
     }
     return t;
 }
@@ -266,221 +454,32 @@ Tensor Tensor::arange(long long start, long long end) {
 //IMPLEMENTACION DE SOBRE CARGA
 //
 
-std::vector<std::size_t> Tensor::broadcast_shape_or_throw(const std::vector<std::size_t> &a, const std::vector<std::size_t> &b) {
+template <typename T>
+TensorShape BasicTensor<T>::broadcast_shape_or_throw(const TensorShape &a, const TensorShape &b) {
 
-    if (a.size() != b.size())
-        throw std::invalid_argument("Tensor: dimensiones incompatibles(diferente cantidad de dimensiones)");
+    // Las shapes se alinean por la derecha; a la de menos dimensiones se le anteponen 1s.
+    const std::size_t D = (a.size() > b.size()) ? a.size() : b.size();
+    TensorShape out(D);
 
-    std::vector<std::size_t> out;
-    out.reserve(a.size());
-
-    for (std::size_t d =0; d < a.size(); d++) {
-        const std::size_t ad = a[d];
-        const std::size_t bd = b[d];
+    for (std::size_t d = 0; d < D; d++) {
+        const std::size_t ad = (d + a.size() >= D) ? a[d + a.size() - D] : 1;
+        const std::size_t bd = (d + b.size() >= D) ? b[d + b.size() - D] : 1;
 
         if (ad==bd)
-            out.push_back(ad);
+            out[d] = ad;
         else if (ad==1)
-            out.push_back(bd);
+            out[d] = bd;
         else if (bd==1)
-            out.push_back(ad);
+            out[d] = ad;
         else
             throw std::invalid_argument("Tensor: shape incompatible para broadcast");
     }
     return out;
 }
 
-Tensor Tensor::operator*(double scalar) const {
-    Tensor r;
-    r.shape_ = shape_;
-    r.strides_ = strides_;
-    r.size_ = size_;
-
-    if (r.size_>0) {
-        r.data_ = new double[r.size_];
-        for (std::size_t i=0; i < r.size_; i++)
-            r.data_[i]=data_[i] *scalar;
-    }
-    return r;
-}
-
-Tensor Tensor::operator+(const Tensor &other) const {
-    std::vector<std::size_t> out_shape = broadcast_shape_or_throw(shape_, other.shape_);
-    Tensor r;
-    r.validate_shape_or_throw(out_shape);
-    r.shape_ = out_shape;
-    r.size_ = product(out_shape);
-    r.compute_strides();
-    r.data_ = new double [r.size_];
-
-    if (dims()==1) {
-        for (std::size_t i= 0; i < out_shape[0]; i++) {
-            std::size_t ia = (shape_[0] == 1 ? 0 : i);
-            std::size_t ib = (other.shape_[0]== 1 ? 0 : i);
-            r.data_[i]= data_[ia] + other.data_[ib];
-        }
-        return r;
-    }
-
-    if (dims()==2) {
-        const std::size_t R = out_shape[0], C = out_shape[1];
-        for (std::size_t i = 0; i < R; i++) {
-            std::size_t ia = (shape_[0] == 1 ? 0 : i);
-            std::size_t ib = (other.shape_[0]== 1 ? 0 : i);
-            for (std::size_t j=0; j < C; j++) {
-                std::size_t ja = (shape_[1] == 1 ? 0 : j);
-                std::size_t jb = (other.shape_[1] == 1 ? 0 : j);
-
-                std::size_t oa  = ia *strides_[0] + ja * strides_[1];
-                std::size_t ob = ib * other.strides_[0]+jb *other.strides_[1];
-                std::size_t orr = i * r.strides_[0] +j *r.strides_[1];
-
-                r.data_[orr] = data_[oa] + other.data_[ob];
-            }
-        }
-        return r;
-    }
-
-    const std::size_t A = out_shape[0], B = out_shape[1], C = out_shape[2];
-    for (std::size_t i = 0; i < A; ++i) {
-        std::size_t ia = (shape_[0] == 1 ? 0 : i);
-        std::size_t ib = (other.shape_[0] == 1 ? 0 : i);
-        for (std::size_t j = 0; j < B; ++j) {
-            std::size_t ja = (shape_[1] == 1 ? 0 : j);
-            std::size_t jb = (other.shape_[1] == 1 ? 0 : j);
-            for (std::size_t k = 0; k < C; ++k) {
-                std::size_t ka = (shape_[2] == 1 ? 0 : k);
-                std::size_t kb = (other.shape_[2] == 1 ? 0 : k);
-
-                std::size_t oa = ia * strides_[0] + ja * strides_[1] + ka * strides_[2];
-                std::size_t ob = ib * other.strides_[0] + jb * other.strides_[1] + kb * other.strides_[2];
-                std::size_t orr = i * r.strides_[0] + j * r.strides_[1] + k * r.strides_[2];
-
-                r.data_[orr] = data_[oa] + other.data_[ob];
-            }
-        }
-    }
-    return r;
-}
-
-Tensor Tensor::operator-(const Tensor &other) const {
-    std::vector<std::size_t> out_shape = broadcast_shape_or_throw(shape_, other.shape_);
-
-    Tensor r;
-    r.validate_shape_or_throw(out_shape);
-    r.shape_ = out_shape;
-    r.size_ = product(out_shape);
-    r.compute_strides();
-    r.data_ = new double[r.size_];
-
-    if (dims() == 1) {
-        for (std::size_t i = 0; i < out_shape[0]; ++i) {
-            std::size_t ia = (shape_[0] == 1 ? 0 : i);
-            std::size_t ib = (other.shape_[0] == 1 ? 0 : i);
-            r.data_[i] = data_[ia] - other.data_[ib];
-        }
-        return r;
-    }
-
-    if (dims() == 2) {
-        const std::size_t R = out_shape[0], C = out_shape[1];
-        for (std::size_t i = 0; i < R; ++i) {
-            std::size_t ia = (shape_[0] == 1 ? 0 : i);
-            std::size_t ib = (other.shape_[0] == 1 ? 0 : i);
-            for (std::size_t j = 0; j < C; ++j) {
-                std::size_t ja = (shape_[1] == 1 ? 0 : j);
-                std::size_t jb = (other.shape_[1] == 1 ? 0 : j);
-
-                std::size_t oa = ia * strides_[0] + ja * strides_[1];
-                std::size_t ob = ib * other.strides_[0] + jb * other.strides_[1];
-                std::size_t orr = i * r.strides_[0] + j * r.strides_[1];
-
-                r.data_[orr] = data_[oa] - other.data_[ob];
-            }
-        }
-        return r;
-    }
-
-    const std::size_t A = out_shape[0], B = out_shape[1], C = out_shape[2];
-    for (std::size_t i = 0; i < A; ++i) {
-        std::size_t ia = (shape_[0] == 1 ? 0 : i);
-        std::size_t ib = (other.shape_[0] == 1 ? 0 : i);
-        for (std::size_t j = 0; j < B; ++j) {
-            std::size_t ja = (shape_[1] == 1 ? 0 : j);
-            std::size_t jb = (other.shape_[1] == 1 ? 0 : j);
-            for (std::size_t k = 0; k < C; ++k) {
-                std::size_t ka = (shape_[2] == 1 ? 0 : k);
-                std::size_t kb = (other.shape_[2] == 1 ? 0 : k);
-
-                std::size_t oa = ia * strides_[0] + ja * strides_[1] + ka * strides_[2];
-                std::size_t ob = ib * other.strides_[0] + jb * other.strides_[1] + kb * other.strides_[2];
-                std::size_t orr = i * r.strides_[0] + j * r.strides_[1] + k * r.strides_[2];
-
-                r.data_[orr] = data_[oa] - other.data_[ob];
-            }
-        }
-    }
-    return r;
-}
-
-Tensor Tensor::operator*(const Tensor& other) const {
-    std::vector<std::size_t> out_shape = broadcast_shape_or_throw(shape_, other.shape_);
-
-    Tensor r;
-    r.validate_shape_or_throw(out_shape);
-    r.shape_ = out_shape;
-    r.size_ = product(out_shape);
-    r.compute_strides();
-    r.data_ = new double[r.size_];
-
-    if (dims() == 1) {
-        for (std::size_t i = 0; i < out_shape[0]; ++i) {
-            std::size_t ia = (shape_[0] == 1 ? 0 : i);
-            std::size_t ib = (other.shape_[0] == 1 ? 0 : i);
-            r.data_[i] = data_[ia] * other.data_[ib];
-        }
-        return r;
-    }
-
-    if (dims() == 2) {
-        const std::size_t R = out_shape[0], C = out_shape[1];
-        for (std::size_t i = 0; i < R; ++i) {
-            std::size_t ia = (shape_[0] == 1 ? 0 : i);
-            std::size_t ib = (other.shape_[0] == 1 ? 0 : i);
-            for (std::size_t j = 0; j < C; ++j) {
-                std::size_t ja = (shape_[1] == 1 ? 0 : j);
-                std::size_t jb = (other.shape_[1] == 1 ? 0 : j);
-
-                std::size_t oa = ia * strides_[0] + ja * strides_[1];
-                std::size_t ob = ib * other.strides_[0] + jb * other.strides_[1];
-                std::size_t orr = i * r.strides_[0] + j * r.strides_[1];
-
-                r.data_[orr] = data_[oa] * other.data_[ob];
-            }
-        }
-        return r;
-    }
-
-    const std::size_t A = out_shape[0], B = out_shape[1], C = out_shape[2];
-    for (std::size_t i = 0; i < A; ++i) {
-        std::size_t ia = (shape_[0] == 1 ? 0 : i);
-        std::size_t ib = (other.shape_[0] == 1 ? 0 : i);
-        for (std::size_t j = 0; j < B; ++j) {
-            std::size_t ja = (shape_[1] == 1 ? 0 : j);
-            std::size_t jb = (other.shape_[1] == 1 ? 0 : j);
-            for (std::size_t k = 0; k < C; ++k) {
-                std::size_t ka = (shape_[2] == 1 ? 0 : k);
-                std::size_t kb = (other.shape_[2] == 1 ? 0 : k);
-
-                std::size_t oa = ia * strides_[0] + ja * strides_[1] + ka * strides_[2];
-                std::size_t ob = ib * other.strides_[0] + jb * other.strides_[1] + kb * other.strides_[2];
-                std::size_t orr = i * r.strides_[0] + j * r.strides_[1] + k * r.strides_[2];
-
-                r.data_[orr] = data_[oa] * other.data_[ob];
-            }
-        }
-    }
-    return r;
+TensorShape expr::broadcast_shape(const TensorShape& a,
+                                               const TensorShape& b) {
+    return DoubleTensor::broadcast_shape_or_throw(a, b);
 }
 
 
@@ -488,7 +487,8 @@ Tensor Tensor::operator*(const Tensor& other) const {
 //Impresion de TENSORES
 //
 
-void Tensor::imprimir() const {
+template <typename T>
+void BasicTensor<T>::imprimir() const {
     if (dims() == 1) {
         for (std::size_t i = 0; i < shape_[0]; ++i) {
             std::cout << at(i) << " ";
@@ -512,90 +512,196 @@ void Tensor::imprimir() const {
             }
             std::cout << "\n";
         }
+    } else {
+        // Mas de 3 dimensiones: una matriz por cada combinacion de las primeras dims()-2.
+        const std::size_t D = dims();
+        TensorShape idx(D, 0);
+        std::size_t slices = 1;
+        for (std::size_t d = 0; d + 2 < D; ++d) slices *= shape_[d];
+        for (std::size_t s = 0; s < slices; ++s) {
+            std::cout << "Slice [";
+            for (std::size_t d = 0; d + 2 < D; ++d) std::cout << (d ? ", " : "") << idx[d];
+            std::cout << "]:\n";
+            for (idx[D - 2] = 0; idx[D - 2] < shape_[D - 2]; ++idx[D - 2]) {
+                for (idx[D - 1] = 0; idx[D - 1] < shape_[D - 1]; ++idx[D - 1]) {
+                    std::cout << at(idx) << " ";
+                }
+                std::cout << "\n";
+            }
+            std::cout << "\n";
+            idx[D - 2] = idx[D - 1] = 0;
+            for (std::size_t d = D - 2; d-- > 0;) {
+                if (++idx[d] < shape_[d]) break;
+                idx[d] = 0;
+            }
+        }
     }
 }
 
-Tensor Tensor::view(const std::vector<std::size_t> &new_shape) {
+//
+//VISTAS
+//
+
+template <typename T>
+iter::Span<T> BasicTensor<T>::span() {
+    if (!is_contiguous()) {
+        throw std::invalid_argument("Tensor::span: el tensor no es contiguo (usar contiguous())");
+    }
+    return iter::Span<T>(data_, size_);
+}
+
+template <typename T>
+iter::Span<const T> BasicTensor<T>::span() const {
+    if (!is_contiguous()) {
+        throw std::invalid_argument("Tensor::span: el tensor no es contiguo (usar contiguous())");
+    }
+    return iter::Span<const T>(data_, size_);
+}
+
+template <typename T>
+bool BasicTensor<T>::is_contiguous() const {
+    std::size_t expected = 1;
+    for (std::size_t d = shape_.size(); d-- > 0;) {
+        if (shape_[d] != 1 && strides_[d] != expected) return false;
+        expected *= shape_[d];
+    }
+    return true;
+}
+
+template <typename T>
+BasicTensor<T> BasicTensor<T>::contiguous() const {
+    if (is_contiguous()) return share_with(shape_, strides_, 0);
+    return BasicTensor<T>(*this);
+}
+
+template <typename T>
+BasicTensor<T> BasicTensor<T>::view(const TensorShape &new_shape) const {
     validate_shape_or_throw(new_shape);
     std::size_t new_size = product(new_shape);
     if (new_size != size_) {
         throw std::invalid_argument("Tensor::view: product(new_shape) must match current numel()");
     }
+    if (!is_contiguous()) {
+        throw std::invalid_argument("Tensor::view: el tensor no es contiguo (usa contiguous().view(...))");
+    }
 
-    Tensor out;
-    out.shape_ = new_shape;
-    out.size_ = size_;
+    BasicTensor<T> out = share_with(new_shape, TensorShape(), 0);
     out.compute_strides();
-    out.data_ = data_;
-    data_ = nullptr;
-    size_ = 0;
-    shape_.clear();
-    strides_.clear();
-
     return out;
 }
 
-Tensor Tensor::unsqueeze(std::size_t dim) {
+template <typename T>
+BasicTensor<T> BasicTensor<T>::unsqueeze(std::size_t dim) const {
     std::size_t old_dims = dims();
     if (dim > old_dims) {
         throw std::invalid_argument("Tensor::unsqueeze: dim out of range");
     }
-    if (old_dims + 1 > 3) {
-        throw std::invalid_argument("Tensor::unsqueeze: dims cannot exceed 3");
-    }
 
-    std::vector<std::size_t> new_shape;
+    TensorShape new_shape;
+    TensorShape new_strides;
     new_shape.reserve(old_dims + 1);
+    new_strides.reserve(old_dims + 1);
     for (std::size_t i = 0; i < old_dims + 1; ++i) {
-        if (i == dim) new_shape.push_back(1);
-        else {
+        if (i == dim) {
+            new_shape.push_back(1);
+            new_strides.push_back(dim < old_dims ? strides_[dim] * shape_[dim] : 1);
+        } else {
             std::size_t old_i = (i < dim) ? i : (i - 1);
             new_shape.push_back(shape_[old_i]);
+            new_strides.push_back(strides_[old_i]);
         }
     }
 
     validate_shape_or_throw(new_shape);
+    return share_with(new_shape, new_strides, 0);
+}
 
-    Tensor out;
-    out.shape_ = new_shape;
-    out.size_ = size_;
-    out.compute_strides();
-    out.data_ = data_;
-    data_ = nullptr;
-    size_ = 0;
-    shape_.clear();
-    strides_.clear();
+template <typename T>
+BasicTensor<T> BasicTensor<T>::slice(std::size_t dim, std::size_t begin, std::size_t end) const {
+    if (dim >= dims()) {
+        throw std::invalid_argument("Tensor::slice: dim out of range");
+    }
+    if (begin >= end || end > shape_[dim]) {
+        throw std::out_of_range("Tensor::slice: rango invalido (begin < end <= shape[dim])");
+    }
+    TensorShape new_shape = shape_;
+    new_shape[dim] = end - begin;
+    return share_with(new_shape, strides_, begin * strides_[dim]);
+}
+
+template <typename T>
+BasicTensor<T> BasicTensor<T>::transpose(std::size_t dim0, std::size_t dim1) const {
+    if (dim0 >= dims() || dim1 >= dims()) {
+        throw std::invalid_argument("Tensor::transpose: dim out of range");
+    }
+    TensorShape new_shape = shape_;
+    TensorShape new_strides = strides_;
+    std::swap(new_shape[dim0], new_shape[dim1]);
+    std::swap(new_strides[dim0], new_strides[dim1]);
+    return share_with(new_shape, new_strides, 0);
+}
+
+template <typename T>
+BasicTensor<T> BasicTensor<T>::transpose() const {
+    if (dims() < 2) return share_with(shape_, strides_, 0);
+    return transpose(dims() - 2, dims() - 1);
+}
 
+template <typename T>
+BasicTensor<T> BasicTensor<T>::permute(const std::vector<std::size_t>& order) const {
+    if (order.size() != dims()) {
+        throw std::invalid_argument("Tensor::permute: hay que dar una posicion por dimension");
+    }
+    std::vector<bool> seen(dims(), false);
+    TensorShape new_shape(dims());
+    TensorShape new_strides(dims());
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        if (order[i] >= dims() || seen[order[i]]) {
+            throw std::invalid_argument("Tensor::permute: dims debe ser una permutacion de 0..dims()-1");
+        }
+        seen[order[i]] = true;
+        new_shape[i] = shape_[order[i]];
+        new_strides[i] = strides_[order[i]];
+    }
+    return share_with(new_shape, new_strides, 0);
+}
+
+template <typename T>
+BasicTensor<T> BasicTensor<T>::concat(const std::vector<BasicTensor<T>> &tensors, std::size_t dim) {
+    BasicTensor<T> out;
+    concat(tensors, dim, out);
     return out;
 }
 
-Tensor Tensor::concat(const std::vector<Tensor> &tensors, std::size_t dim) {
+template <typename T>
+TensorShape BasicTensor<T>::concat_shape_or_throw(const std::vector<BasicTensor<T>> &tensors,
+                                                               std::size_t dim, const char* fn) {
     if (tensors.empty()) {
-        throw std::invalid_argument("Tensor::concat: tensors is empty");
+        throw std::invalid_argument(std::string(fn) + ": tensors is empty");
     }
 
     const std::size_t base_dims = tensors[0].dims();
-    if (base_dims == 0 || base_dims > 3) {
-        throw std::invalid_argument("Tensor::concat: invalid base tensor dims");
+    if (base_dims == 0) {
+        throw std::invalid_argument(std::string(fn) + ": invalid base tensor dims");
     }
     if (dim >= base_dims) {
-        throw std::invalid_argument("Tensor::concat: dim out of range");
+        throw std::invalid_argument(std::string(fn) + ": dim out of range");
     }
 
-    std::vector<std::size_t> out_shape = tensors[0].shape_;
+    TensorShape out_shape = tensors[0].shape_;
     std::size_t sum_dim = 0;
 
     for (std::size_t t = 0; t < tensors.size(); ++t) {
-        const Tensor& X = tensors[t];
+        const BasicTensor<T>& X = tensors[t];
 
         if (X.dims() != base_dims) {
-            throw std::invalid_argument("Tensor::concat: all tensors must have same dims");
+            throw std::invalid_argument(std::string(fn) + ": all tensors must have same dims");
         }
 
         for (std::size_t d = 0; d < base_dims; ++d) {
             if (d == dim) continue;
             if (X.shape_[d] != out_shape[d]) {
-                throw std::invalid_argument("Tensor::concat: shape mismatch in non-concat dimension");
+                throw std::invalid_argument(std::string(fn) + ": shape mismatch in non-concat dimension");
             }
         }
 
@@ -603,136 +709,144 @@ Tensor Tensor::concat(const std::vector<Tensor> &tensors, std::size_t dim) {
     }
 
     out_shape[dim] = sum_dim;
+    return out_shape;
+}
 
-    Tensor out;
-    out.validate_shape_or_throw(out_shape);
-    out.shape_ = out_shape;
-    out.size_ = product(out_shape);
-    out.compute_strides();
-    out.data_ = new double[out.size_];
-
-    const std::size_t D = base_dims;
-
-    if (D == 1) {
-        std::size_t dst = 0;
-        for (std::size_t t = 0; t < tensors.size(); ++t) {
-            const Tensor& X = tensors[t];
-            for (std::size_t i = 0; i < X.size_; ++i) {
-                out.data_[dst++] = X.data_[i];
-            }
+template <typename T>
+BasicTensor<T>& BasicTensor<T>::concat(const std::vector<BasicTensor<T>> &tensors, std::size_t dim, BasicTensor<T>& out) {
+    const TensorShape out_shape = concat_shape_or_throw(tensors, dim, "Tensor::concat");
+    TENSOR_PROFILE_SCOPE("Tensor::concat");
+    for (std::size_t t = 0; t < tensors.size(); ++t) TENSOR_PROFILE_INPUT(tensors[t].shape_);
+    TENSOR_PROFILE_OUTPUT(out_shape);
+    for (std::size_t t = 0; t < tensors.size(); ++t) {
+        if (out.data_ != nullptr && out.shares_storage(tensors[t])) {
+            throw std::invalid_argument("Tensor::concat: out no puede ser una de las entradas");
         }
-        return out;
     }
+    out.prepare_out_or_throw(out_shape, "Tensor::concat");
+    concat_copy(tensors, dim, out);
+    return out;
+}
 
-    if (D == 2) {
-        const std::size_t R = out.shape_[0];
-        if (dim == 0) {
-            std::size_t dst = 0;
-            for (std::size_t t = 0; t < tensors.size(); ++t) {
-                const Tensor& X = tensors[t];
-                for (std::size_t i = 0; i < X.size_; ++i) {
-                    out.data_[dst++] = X.data_[i];
-                }
-            }
-            return out;
-        }
-
-        const std::size_t C_out = out.shape_[1];
-        (void)C_out;
-
-        for (std::size_t r = 0; r < R; ++r) {
-            std::size_t dst_col = 0;
-            const std::size_t out_row_base = r * out.strides_[0];
-
-            for (std::size_t t = 0; t < tensors.size(); ++t) {
-                const Tensor& X = tensors[t];
-                const std::size_t X_cols = X.shape_[1];
-                const std::size_t x_row_base = r * X.strides_[0];
-
-                for (std::size_t c = 0; c < X_cols; ++c) {
-                    out.data_[out_row_base + dst_col + c] = X.data_[x_row_base + c];
-                }
-                dst_col += X_cols;
-            }
-        }
-        return out;
+template <typename T>
+BasicTensor<T>& BasicTensor<T>::concat_into(const std::vector<BasicTensor<T>> &tensors, std::size_t dim, BasicTensor<T>& out) {
+    const TensorShape out_shape = concat_shape_or_throw(tensors, dim, "Tensor::concat_into");
+    TENSOR_PROFILE_SCOPE("Tensor::concat_into");
+    for (std::size_t t = 0; t < tensors.size(); ++t) TENSOR_PROFILE_INPUT(tensors[t].shape_);
+    TENSOR_PROFILE_OUTPUT(out_shape);
+    if (out.shape_ != out_shape) {
+        throw std::invalid_argument("Tensor::concat_into: out tiene una shape distinta a la del resultado");
     }
-
-    const std::size_t A = out.shape_[0];
-    const std::size_t B = out.shape_[1];
-    const std::size_t C = out.shape_[2];
-
-    if (dim == 0) {
-        std::size_t dst = 0;
-        for (std::size_t t = 0; t < tensors.size(); ++t) {
-            const Tensor& X = tensors[t];
-            for (std::size_t i = 0; i < X.size_; ++i) {
-                out.data_[dst++] = X.data_[i];
-            }
+    for (std::size_t t = 0; t < tensors.size(); ++t) {
+        if (out.shares_storage(tensors[t])) {
+            throw std::invalid_argument("Tensor::concat_into: out no puede compartir buffer con las entradas");
         }
-        return out;
     }
+    concat_copy(tensors, dim, out);
+    return out;
+}
 
-    if (dim == 1) {
-        for (std::size_t i = 0; i < A; ++i) {
-            std::size_t dst_j = 0;
-            for (std::size_t t = 0; t < tensors.size(); ++t) {
-                const Tensor& X = tensors[t];
-                const std::size_t Bj = X.shape_[1];
-                for (std::size_t j = 0; j < Bj; ++j) {
-                    for (std::size_t k = 0; k < C; ++k) {
-                        std::size_t out_off = i * out.strides_[0] + (dst_j + j) * out.strides_[1] + k * out.strides_[2];
-                        std::size_t x_off   = i * X.strides_[0]   + j * X.strides_[1]           + k * X.strides_[2];
-                        out.data_[out_off] = X.data_[x_off];
-                    }
-                }
-                dst_j += Bj;
-            }
+// Con out contiguo, la entrada t ocupa en cada indice externo o (producto de las dims antes de
+// dim) un tramo contiguo de run_t = shape_t[dim] * inner elementos que empieza en
+// o * out_run + (filas de dim anteriores) * inner. Las entradas contiguas se copian por tramos
+// con memcpy; las demas con copy_strided. Si la salida es grande, los tramos se reparten entre
+// hilos: por indice externo si hay suficientes, si no cada tramo se parte en pedazos.
+template <typename T>
+void BasicTensor<T>::concat_copy(const std::vector<BasicTensor<T>> &tensors, std::size_t dim, BasicTensor<T>& out) {
+    const std::size_t PIECE = std::size_t(1) << 14;
+    const std::size_t PARALLEL_MIN_ELEMS = std::size_t(1) << 16;
+
+    std::size_t outer = 1, inner = 1;
+    for (std::size_t d = 0; d < dim; ++d) outer *= out.shape_[d];
+    for (std::size_t d = dim + 1; d < out.dims(); ++d) inner *= out.shape_[d];
+    const std::size_t out_run = out.shape_[dim] * inner;
+
+    // Hasta 8 entradas sin heap (Graph::run llama aca en cada ejecucion).
+    struct Part {
+        const T* src;
+        std::size_t run, start;
+    };
+    Part inline_parts[8];
+    std::vector<Part> heap_parts;
+    Part* part = inline_parts;
+    if (tensors.size() > 8) {
+        heap_parts.resize(tensors.size());
+        part = heap_parts.data();
+    }
+    std::size_t at = 0;
+    for (std::size_t t = 0; t < tensors.size(); ++t) {
+        const BasicTensor<T>& X = tensors[t];
+        part[t].src = nullptr;
+        part[t].run = X.shape_[dim] * inner;
+        part[t].start = at;
+        at += part[t].run;
+        if (out.is_contiguous() && X.is_contiguous()) {
+            part[t].src = X.data_;
+        } else {
+            copy_strided(X.data_, X.strides_, out.data_ + part[t].start / inner * out.strides_[dim], out.strides_, X.shape_);
         }
-        return out;
     }
 
-    for (std::size_t i = 0; i < A; ++i) {
-        for (std::size_t j = 0; j < B; ++j) {
-            std::size_t dst_k = 0;
+    // Tramo [b, e) de la entrada t en el indice externo o.
+    auto copy_part = [&](std::size_t o, std::size_t t, std::size_t b, std::size_t e) {
+        std::memcpy(out.data_ + o * out_run + part[t].start + b, part[t].src + o * part[t].run + b, (e - b) * sizeof(T));
+    };
+    auto copy_outer = [&](std::size_t o0, std::size_t o1) {
+        for (std::size_t o = o0; o < o1; ++o)
+            for (std::size_t t = 0; t < tensors.size(); ++t)
+                if (part[t].src != nullptr) copy_part(o, t, 0, part[t].run);
+    };
+
+    // std::cref: el std::function de parallel_for guarda la referencia sin pedir memoria.
+    const std::size_t threads = parallel::in_parallel_region() ? 1 : parallel::num_threads();
+    if (threads <= 1 || out.size_ < PARALLEL_MIN_ELEMS) {
+        copy_outer(0, outer);
+    } else if (outer >= threads) {
+        parallel::parallel_for(0, outer, std::max<std::size_t>(1, PIECE / out_run), std::cref(copy_outer));
+    } else {
+        for (std::size_t o = 0; o < outer; ++o) {
             for (std::size_t t = 0; t < tensors.size(); ++t) {
-                const Tensor& X = tensors[t];
-                const std::size_t Ck = X.shape_[2];
-                for (std::size_t k = 0; k < Ck; ++k) {
-                    std::size_t out_off = i * out.strides_[0] + j * out.strides_[1] + (dst_k + k) * out.strides_[2];
-                    std::size_t x_off   = i * X.strides_[0]   + j * X.strides_[1]   + k * X.strides_[2];
-                    out.data_[out_off] = X.data_[x_off];
-                }
-                dst_k += Ck;
+                if (part[t].src == nullptr) continue;
+                auto piece = [&](std::size_t b, std::size_t e) { copy_part(o, t, b, e); };
+                parallel::parallel_for(0, part[t].run, PIECE, std::cref(piece));
             }
         }
     }
-
-    return out;
 }
 
-Tensor dot(const Tensor& a, const Tensor& b) {
+template <typename T>
+BasicTensor<T> dot(const BasicTensor<T>& a, const BasicTensor<T>& b) {
     if (a.dims() != b.dims()) {
         throw std::invalid_argument("dot: dims incompatibles");
     }
     if (a.shape_ != b.shape_) {
         throw std::invalid_argument("dot: shapes incompatibles (deben ser iguales)");
     }
-    double acc = 0.0;
-    for (std::size_t i = 0; i < a.size_; ++i) {
-        acc += a.data_[i] * b.data_[i];
-    }
-    std::vector<std::size_t> s;
-    s.push_back(1);
-    std::vector<double> v;
-    v.push_back(acc);
-    Tensor out(s, v);
+    TENSOR_PROFILE_SCOPE("dot");
+    TENSOR_PROFILE_INPUT(a.shape_);
+    TENSOR_PROFILE_INPUT(b.shape_);
+    TENSOR_PROFILE_OUTPUT(TensorShape(1, 1));
+    TENSOR_PROFILE_FLOPS(2.0 * a.size_);
+    BasicTensor<T> out;
+    out.prepare_out_or_throw(TensorShape(1, 1), "dot");
+    out.data_[0] = blas::dot(a, b);
+    return out;
+}
+
+template <typename T>
+BasicTensor<T> matmul(const BasicTensor<T>& a, const BasicTensor<T>& b) {
+    BasicTensor<T> out;
+    matmul(a, b, out);
     return out;
 }
 
-Tensor matmul(const Tensor& a, const Tensor& b) {
-    if (a.dims() != 2 || b.dims() != 2) {
-        throw std::invalid_argument("matmul: ambos tensores deben ser 2D");
+template <typename T>
+BasicTensor<T>& matmul(const BasicTensor<T>& a, const BasicTensor<T>& b, BasicTensor<T>& out) {
+    if (a.dims() < 2 || b.dims() < 2 || a.dims() > 3 || b.dims() > 3) {
+        throw std::invalid_argument("matmul: los tensores deben ser 2D o 3D (lote de matrices)");
+    }
+    if (a.dims() == 3 || b.dims() == 3) {
+        return bmm(a, b, out);
     }
     std::size_t m = a.shape_[0];
     std::size_t k = a.shape_[1];
@@ -741,45 +855,224 @@ Tensor matmul(const Tensor& a, const Tensor& b) {
     if (k != kb) {
         throw std::invalid_argument("matmul: shapes incompatibles (a.cols debe ser = b.rows)");
     }
-    std::vector<std::size_t> out_shape;
+    if (out.shares_storage(a) || out.shares_storage(b)) {
+        throw std::invalid_argument("matmul: out no puede ser una de las entradas");
+    }
+    TensorShape out_shape;
     out_shape.push_back(m);
     out_shape.push_back(n);
+    TENSOR_PROFILE_SCOPE("matmul");
+    TENSOR_PROFILE_INPUT(a.shape_);
+    TENSOR_PROFILE_INPUT(b.shape_);
+    TENSOR_PROFILE_OUTPUT(out_shape);
+    TENSOR_PROFILE_FLOPS(2.0 * m * n * k);
+    out.prepare_out_or_throw(out_shape, "matmul");
+
+    gemm::gemm(m, n, k,
+               a.data_, a.strides_[0], a.strides_[1],
+               b.data_, b.strides_[0], b.strides_[1],
+               out.data_, out.strides_[0]);
+    return out;
+}
 
-    Tensor out;
-    out.validate_shape_or_throw(out_shape);
-    out.shape_ = out_shape;
-    out.size_ = Tensor::product(out_shape);
-    out.compute_strides();
-    out.data_ = new double[out.size_];
-
-    for (std::size_t i = 0; i < out.size_; ++i) out.data_[i] = 0.0;
-    for (std::size_t i = 0; i < m; ++i) {
-        for (std::size_t j = 0; j < n; ++j) {
-            double sum = 0.0;
-            for (std::size_t t = 0; t < k; ++t) {
-                std::size_t oa = i * a.strides_[0] + t * a.strides_[1];
-                std::size_t ob = t * b.strides_[0] + j * b.strides_[1];
-                sum += a.data_[oa] * b.data_[ob];
-            }
-            std::size_t oo = i * out.strides_[0] + j * out.strides_[1];
-            out.data_[oo] = sum;
-        }
+//
+//CAPA LINEAL FUSIONADA: act(X * W + b)
+//
+// El bias y la activacion se aplican en el epilogo del GEMM, tile a tile.
+//
+
+template <typename T>
+BasicTensor<T> linear(const BasicTensor<T>& x, const BasicTensor<T>& w, const BasicTensor<T>& b, const TensorTransform* act) {
+    BasicTensor<T> out;
+    linear(x, w, b, act, out);
+    return out;
+}
+
+template <typename T>
+BasicTensor<T>& linear(const BasicTensor<T>& x, const BasicTensor<T>& w, const BasicTensor<T>& b,
+                       const TensorTransform* act, BasicTensor<T>& out) {
+    if (x.dims() != 2 || w.dims() != 2) {
+        throw std::invalid_argument("linear: X y W deben ser 2D");
+    }
+    const std::size_t m = x.shape_[0];
+    const std::size_t k = x.shape_[1];
+    const std::size_t n = w.shape_[1];
+    if (k != w.shape_[0]) {
+        throw std::invalid_argument("linear: shapes incompatibles (X.cols debe ser = W.rows)");
+    }
+    const bool bias_1d = b.dims() == 1 && b.shape_[0] == n;
+    const bool bias_row = b.dims() == 2 && b.shape_[0] == 1 && b.shape_[1] == n;
+    if (!bias_1d && !bias_row) {
+        throw std::invalid_argument("linear: bias debe tener shape (n) o (1 x n)");
+    }
+
+    if (out.shares_storage(x) || out.shares_storage(w) || out.shares_storage(b)) {
+        throw std::invalid_argument("linear: out no puede ser una de las entradas");
     }
+    TensorShape out_shape;
+    out_shape.push_back(m);
+    out_shape.push_back(n);
+    TENSOR_PROFILE_SCOPE("linear");
+    TENSOR_PROFILE_INPUT(x.shape_);
+    TENSOR_PROFILE_INPUT(w.shape_);
+    TENSOR_PROFILE_INPUT(b.shape_);
+    TENSOR_PROFILE_OUTPUT(out_shape);
+    TENSOR_PROFILE_FLOPS(2.0 * m * n * k + (act != nullptr ? 2.0 : 1.0) * m * n);
+    out.prepare_out_or_throw(out_shape, "linear");
+
+    gemm::Epilogue<T> ep;
+    ep.bias = b.data_;
+    ep.bias_stride = bias_1d ? b.strides_[0] : b.strides_[1];
+    ep.act = act;
+
+    gemm::gemm(m, n, k,
+               x.data_, x.strides_[0], x.strides_[1],
+               w.data_, w.strides_[0], w.strides_[1],
+               out.data_, out.strides_[0], &ep);
     return out;
 }
 
-Tensor Tensor::apply(const TensorTransform& op) const {
-    Tensor out;
-    out.shape_ = shape_;
-    out.size_ = size_;
-    out.compute_strides();
-    if (out.size_ == 0) {
-        out.data_ = nullptr;
-        return out;
+//
+//MATMUL POR LOTES: (B, m, k) x (B, k, n) -> (B, m, n)
+//
+// Un operando 2D o con batch 1 se reutiliza para todo el lote (stride de batch 0).
+//
+
+template <typename T>
+BasicTensor<T> bmm(const BasicTensor<T>& a, const BasicTensor<T>& b) {
+    BasicTensor<T> out;
+    bmm(a, b, out);
+    return out;
+}
+
+template <typename T>
+BasicTensor<T>& bmm(const BasicTensor<T>& a, const BasicTensor<T>& b, BasicTensor<T>& out) {
+    if (a.dims() < 2 || b.dims() < 2 || a.dims() > 3 || b.dims() > 3) {
+        throw std::invalid_argument("bmm: los tensores deben ser 3D (o 2D, tratado como batch 1)");
+    }
+    const bool a3 = a.dims() == 3;
+    const bool b3 = b.dims() == 3;
+    const std::size_t da = a3 ? 1 : 0;
+    const std::size_t db = b3 ? 1 : 0;
+
+    const std::size_t m = a.shape_[da];
+    const std::size_t k = a.shape_[da + 1];
+    const std::size_t kb = b.shape_[db];
+    const std::size_t n = b.shape_[db + 1];
+    if (k != kb) {
+        throw std::invalid_argument("bmm: shapes incompatibles (a.cols debe ser = b.rows)");
     }
-    out.data_ = new double[out.size_];
-    for (std::size_t i = 0; i < out.size_; ++i) {
-        out.data_[i] = op.apply(data_[i]);
+
+    const std::size_t batch_a = a3 ? a.shape_[0] : 1;
+    const std::size_t batch_b = b3 ? b.shape_[0] : 1;
+    const std::size_t batch = BasicTensor<T>::broadcast_shape_or_throw(
+        TensorShape(1, batch_a), TensorShape(1, batch_b))[0];
+
+    if (out.shares_storage(a) || out.shares_storage(b)) {
+        throw std::invalid_argument("bmm: out no puede ser una de las entradas");
+    }
+    TensorShape out_shape;
+    out_shape.push_back(batch);
+    out_shape.push_back(m);
+    out_shape.push_back(n);
+    TENSOR_PROFILE_SCOPE("bmm");
+    TENSOR_PROFILE_INPUT(a.shape_);
+    TENSOR_PROFILE_INPUT(b.shape_);
+    TENSOR_PROFILE_OUTPUT(out_shape);
+    TENSOR_PROFILE_FLOPS(2.0 * batch * m * n * k);
+    out.prepare_out_or_throw(out_shape, "bmm");
+
+    const std::size_t sa = (batch_a == 1) ? 0 : a.strides_[0];
+    const std::size_t sb = (batch_b == 1) ? 0 : b.strides_[0];
+    const std::size_t rsa = a.strides_[da], csa = a.strides_[da + 1];
+    const std::size_t rsb = b.strides_[db], csb = b.strides_[db + 1];
+
+    auto run = [&](std::size_t i0, std::size_t i1) {
+        for (std::size_t i = i0; i < i1; ++i) {
+            gemm::gemm(m, n, k,
+                       a.data_ + i * sa, rsa, csa,
+                       b.data_ + i * sb, rsb, csb,
+                       out.data_ + i * out.strides_[0], out.strides_[1]);
+        }
+    };
+
+    // Con suficientes matrices se reparte el lote (cada gemm corre en serie dentro del hilo);
+    // con pocas y grandes, cada gemm ya se paraleliza por tiles.
+    if (batch >= parallel::num_threads()) {
+        parallel::parallel_for(0, batch, 1, std::cref(run));   // sin copiar la lambda al heap
+    } else {
+        run(0, batch);
     }
     return out;
-}
\ No newline at end of file
+}
+
+template <typename T>
+BasicTensor<T> BasicTensor<T>::apply(const TensorTransform& op) const {
+    BasicTensor<T> out;
+    if (size_ == 0) return out;
+    apply(op, out);
+    return out;
+}
+
+// op.apply(in, out, n) admite in == out, asi que out puede ser *this.
+// Los kernels por lotes leen memoria contigua: una vista con strides pasa antes por contiguous().
+template <typename T>
+BasicTensor<T>& BasicTensor<T>::apply(const TensorTransform& op, BasicTensor<T>& out) const {
+    TENSOR_PROFILE_SCOPE("Tensor::apply");
+    TENSOR_PROFILE_INPUT(shape_);
+    TENSOR_PROFILE_OUTPUT(shape_);
+    TENSOR_PROFILE_FLOPS(size_);
+    const BasicTensor<T> src = contiguous();
+    out.prepare_out_or_throw(shape_, "Tensor::apply");
+    op.apply(src.data_, out.data_, out.size_);
+    return out;
+}
+
+template <typename T>
+BasicTensor<T>& BasicTensor<T>::apply_inplace(const TensorTransform& op) {
+    TENSOR_PROFILE_SCOPE("Tensor::apply_inplace");
+    TENSOR_PROFILE_INPUT(shape_);
+    TENSOR_PROFILE_OUTPUT(shape_);
+    TENSOR_PROFILE_FLOPS(size_);
+    if (is_contiguous()) {
+        op.apply(data_, data_, size_);
+        return *this;
+    }
+    BasicTensor<T> tmp(*this);
+    op.apply(tmp.data_, tmp.data_, tmp.size_);
+    copy_strided(tmp.data_, tmp.strides_, data_, strides_, shape_);
+    return *this;
+}
+
+template <typename T>
+BasicTensor<T>& BasicTensor<T>::operator*=(double scalar) {
+    return assign_inplace(*this * scalar, "Tensor::operator*=");
+}
+
+
+//
+//INSTANCIACIONES
+//
+
+template class BasicTensor<float>;
+template class BasicTensor<double>;
+
+template BasicTensor<float>  dot(const BasicTensor<float>& a, const BasicTensor<float>& b);
+template BasicTensor<double> dot(const BasicTensor<double>& a, const BasicTensor<double>& b);
+template BasicTensor<float>  matmul(const BasicTensor<float>& a, const BasicTensor<float>& b);
+template BasicTensor<double> matmul(const BasicTensor<double>& a, const BasicTensor<double>& b);
+template BasicTensor<float>  bmm(const BasicTensor<float>& a, const BasicTensor<float>& b);
+template BasicTensor<double> bmm(const BasicTensor<double>& a, const BasicTensor<double>& b);
+template BasicTensor<float>  linear(const BasicTensor<float>& x, const BasicTensor<float>& w,
+                                    const BasicTensor<float>& b, const TensorTransform* act);
+template BasicTensor<double> linear(const BasicTensor<double>& x, const BasicTensor<double>& w,
+                                    const BasicTensor<double>& b, const TensorTransform* act);
+
+template BasicTensor<float>&  matmul(const BasicTensor<float>& a, const BasicTensor<float>& b, BasicTensor<float>& out);
+template BasicTensor<double>& matmul(const BasicTensor<double>& a, const BasicTensor<double>& b, BasicTensor<double>& out);
+template BasicTensor<float>&  bmm(const BasicTensor<float>& a, const BasicTensor<float>& b, BasicTensor<float>& out);
+template BasicTensor<double>& bmm(const BasicTensor<double>& a, const BasicTensor<double>& b, BasicTensor<double>& out);
+template BasicTensor<float>&  linear(const BasicTensor<float>& x, const BasicTensor<float>& w,
+                                     const BasicTensor<float>& b, const TensorTransform* act, BasicTensor<float>& out);
+template BasicTensor<double>& linear(const BasicTensor<double>& x, const BasicTensor<double>& w,
+                                     const BasicTensor<double>& b, const TensorTransform* act, BasicTensor<double>& out);
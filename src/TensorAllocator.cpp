@@ -0,0 +1,172 @@
+#include "../include/TensorAllocator.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+//
+//MEMORIA ALINEADA
+//
+
+static void* aligned_alloc_or_throw(std::size_t bytes) {
+    if (bytes == 0) bytes = TENSOR_ALIGNMENT;
+#if defined(_WIN32)
+    void* p = _aligned_malloc(bytes, TENSOR_ALIGNMENT);
+#else
+    void* p = nullptr;
+    if (posix_memalign(&p, TENSOR_ALIGNMENT, bytes) != 0) p = nullptr;
+#endif
+    if (p == nullptr) throw std::bad_alloc();
+    return p;
+}
+
+static void aligned_free(void* p) {
+#if defined(_WIN32)
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+void* AlignedAllocator::allocate(std::size_t bytes) {
+    return aligned_alloc_or_throw(bytes);
+}
+
+void AlignedAllocator::deallocate(void* p, std::size_t) {
+    aligned_free(p);
+}
+
+//
+//POOL
+//
+
+PoolAllocator::PoolAllocator(std::size_t max_cached_bytes, std::size_t huge_page_bytes)
+    : max_cached_(max_cached_bytes), huge_page_bytes_(huge_page_bytes) {}
+
+PoolAllocator::~PoolAllocator() {
+    release_cached();
+}
+
+std::size_t PoolAllocator::size_class(std::size_t bytes) {
+    if (bytes == 0) bytes = 1;
+    if (bytes <= 4096) return (bytes + TENSOR_ALIGNMENT - 1) / TENSOR_ALIGNMENT * TENSOR_ALIGNMENT;
+    // Potencia de dos p <= bytes; paso p/8.
+    std::size_t p = 4096;
+    while (p <= bytes / 2) p *= 2;
+    const std::size_t step = p / 8;
+    return (bytes + step - 1) / step * step;
+}
+
+void* PoolAllocator::system_allocate(std::size_t cls) {
+#if defined(__linux__)
+    if (huge_page_bytes_ != 0 && cls >= huge_page_bytes_) {
+        void* p = mmap(nullptr, cls, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) throw std::bad_alloc();
+#if defined(MADV_HUGEPAGE)
+        madvise(p, cls, MADV_HUGEPAGE);
+#endif
+        return p;
+    }
+#endif
+    return aligned_alloc_or_throw(cls);
+}
+
+void PoolAllocator::system_deallocate(void* p, std::size_t cls) {
+#if defined(__linux__)
+    if (huge_page_bytes_ != 0 && cls >= huge_page_bytes_) {
+        munmap(p, cls);
+        return;
+    }
+#endif
+    aligned_free(p);
+}
+
+void* PoolAllocator::allocate(std::size_t bytes) {
+    const std::size_t cls = size_class(bytes);
+    {
+        std::lock_guard<std::mutex> lk(m_);
+        std::unordered_map<std::size_t, std::vector<void*> >::iterator it = free_.find(cls);
+        if (it != free_.end() && !it->second.empty()) {
+            void* p = it->second.back();
+            it->second.pop_back();
+            ++stats_.hits;
+            stats_.bytes_cached -= cls;
+            stats_.bytes_in_use += cls;
+            return p;
+        }
+        ++stats_.misses;
+    }
+    // La reserva al sistema se hace fuera del lock.
+    void* p = system_allocate(cls);
+    std::lock_guard<std::mutex> lk(m_);
+    stats_.bytes_in_use += cls;
+    stats_.peak_bytes = std::max(stats_.peak_bytes, stats_.bytes_in_use + stats_.bytes_cached);
+    return p;
+}
+
+void PoolAllocator::deallocate(void* p, std::size_t bytes) {
+    if (p == nullptr) return;
+    const std::size_t cls = size_class(bytes);
+    {
+        std::lock_guard<std::mutex> lk(m_);
+        stats_.bytes_in_use -= cls;
+        if (stats_.bytes_cached + cls <= max_cached_) {
+            free_[cls].push_back(p);
+            stats_.bytes_cached += cls;
+            return;
+        }
+    }
+    system_deallocate(p, cls);
+}
+
+void PoolAllocator::release_cached() {
+    std::unordered_map<std::size_t, std::vector<void*> > blocks;
+    {
+        std::lock_guard<std::mutex> lk(m_);
+        blocks.swap(free_);
+        stats_.bytes_cached = 0;
+    }
+    for (std::unordered_map<std::size_t, std::vector<void*> >::iterator it = blocks.begin(); it != blocks.end(); ++it)
+        for (std::size_t i = 0; i < it->second.size(); ++i) system_deallocate(it->second[i], it->first);
+}
+
+PoolStats PoolAllocator::stats() const {
+    std::lock_guard<std::mutex> lk(m_);
+    return stats_;
+}
+
+void PoolAllocator::reset_stats() {
+    std::lock_guard<std::mutex> lk(m_);
+    stats_.hits = 0;
+    stats_.misses = 0;
+    stats_.peak_bytes = stats_.bytes_in_use + stats_.bytes_cached;
+}
+
+//
+//ALLOCATOR POR DEFECTO
+//
+
+// Nunca se destruye: tensores globales pueden liberarse despues del fin de main.
+PoolAllocator& default_pool() {
+    static PoolAllocator* pool = new PoolAllocator();
+    return *pool;
+}
+
+static std::atomic<TensorAllocator*> current_allocator(nullptr);
+
+TensorAllocator& default_allocator() {
+    TensorAllocator* a = current_allocator.load();
+    return a != nullptr ? *a : default_pool();
+}
+
+void set_default_allocator(TensorAllocator* alloc) {
+    current_allocator.store(alloc);
+}
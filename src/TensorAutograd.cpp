@@ -0,0 +1,376 @@
+#include "../include/TensorAutograd.h"
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace autograd {
+
+namespace {
+
+// Otro BasicTensor sobre el mismo buffer (los valores y gradientes de la cinta son contiguos).
+template <typename T>
+BasicTensor<T> share(const BasicTensor<T>& t) {
+    return t.view(t.shape());
+}
+
+// Suma g sobre las dimensiones que el broadcast agrego o expandio desde 1 hasta llegar a shape.
+// Si no hay nada que reducir devuelve g (compartido) o una copia si copy es true.
+template <typename T>
+BasicTensor<T> reduce_to(const BasicTensor<T>& g, const std::vector<std::size_t>& shape, bool copy) {
+    const std::size_t lead = g.dims() - shape.size();
+    bool reduce = lead > 0;
+    for (std::size_t d = 0; d < shape.size() && !reduce; ++d) reduce = shape[d] != g.shape()[lead + d];
+    if (!reduce) return copy ? BasicTensor<T>(g) : share(g);
+
+    BasicTensor<T> r = share(g);
+    for (std::size_t d = 0; d < lead; ++d) r = r.sum(0);
+    for (std::size_t d = 0; d < shape.size(); ++d) {
+        if (shape[d] == 1 && r.shape()[d] != 1) r = r.sum(d, true);
+    }
+    return r.view(shape);
+}
+
+// Intercambia las dos ultimas dimensiones (vista).
+template <typename T>
+BasicTensor<T> transpose_last(const BasicTensor<T>& t) {
+    return t.transpose(t.dims() - 2, t.dims() - 1);
+}
+
+template <typename T>
+Tape<T>& same_tape_or_throw(const Var<T>& a, const Var<T>& b, const char* fn) {
+    if (a.tape() == nullptr || a.tape() != b.tape()) {
+        throw std::invalid_argument(std::string(fn) + ": las Var tienen que ser de la misma Tape");
+    }
+    return *a.tape();
+}
+
+template <typename T>
+Tape<T>& tape_or_throw(const Var<T>& a, const char* fn) {
+    if (a.tape() == nullptr) {
+        throw std::invalid_argument(std::string(fn) + ": Var sin Tape");
+    }
+    return *a.tape();
+}
+
+enum class Activation { ReLU, Sigmoid, Tanh };
+
+}
+
+//
+//TAPE
+//
+
+template <typename T>
+void Tape<T>::check_var_or_throw(const Var<T>& v, const char* fn) const {
+    if (v.tape() != this || v.id() >= nodes_.size()) {
+        throw std::invalid_argument(std::string(fn) + ": la Var no es de esta Tape");
+    }
+}
+
+template <typename T>
+Var<T> Tape<T>::leaf(const BasicTensor<T>& value, bool requires_grad) {
+    if (value.numel() == 0) {
+        throw std::invalid_argument("autograd::Tape::leaf: tensor vacio");
+    }
+    Node n;
+    n.value = value.is_contiguous() ? share(value) : value.contiguous();
+    n.requires_grad = requires_grad;
+    n.leaf = true;
+    nodes_.push_back(std::move(n));
+    return Var<T>(this, nodes_.size() - 1);
+}
+
+template <typename T>
+Var<T> Tape<T>::record(BasicTensor<T>&& value, const std::vector<Var<T> >& inputs, BackwardFn fn) {
+    bool requires_grad = false;
+    for (std::size_t i = 0; i < inputs.size(); ++i) {
+        check_var_or_throw(inputs[i], "autograd::Tape::record");
+        requires_grad = requires_grad || nodes_[inputs[i].id()].requires_grad;
+    }
+    Node n;
+    n.value = std::move(value);
+    n.requires_grad = requires_grad;
+    n.leaf = false;
+    if (requires_grad) n.backward = std::move(fn);
+    nodes_.push_back(std::move(n));
+    return Var<T>(this, nodes_.size() - 1);
+}
+
+template <typename T>
+void Tape<T>::accumulate(const Var<T>& v, BasicTensor<T>&& g) {
+    Node& n = nodes_[v.id()];
+    if (!n.requires_grad) return;
+    if (g.shape() != n.value.shape()) {
+        throw std::logic_error("autograd::Tape::accumulate: gradiente con shape distinta al valor");
+    }
+    if (n.grad.numel() == 0) n.grad = std::move(g);
+    else n.grad += g;
+}
+
+template <typename T>
+void Tape<T>::backward(const Var<T>& out) {
+    check_var_or_throw(out, "autograd::Tape::backward");
+    if (nodes_[out.id()].value.numel() != 1) {
+        throw std::invalid_argument("autograd::Tape::backward: out tiene que tener un solo elemento (o pasar grad_out)");
+    }
+    backward(out, BasicTensor<T>::ones(nodes_[out.id()].value.shape()));
+}
+
+template <typename T>
+void Tape<T>::backward(const Var<T>& out, const BasicTensor<T>& grad_out) {
+    check_var_or_throw(out, "autograd::Tape::backward");
+    if (grad_out.shape() != nodes_[out.id()].value.shape()) {
+        throw std::invalid_argument("autograd::Tape::backward: grad_out tiene que tener la shape de out");
+    }
+    accumulate(out, BasicTensor<T>(grad_out));
+
+    // Los ids crecen en orden de ejecucion: recorrer hacia atras es un orden topologico inverso.
+    for (std::size_t i = out.id() + 1; i-- > 0;) {
+        Node& n = nodes_[i];
+        if (n.leaf || n.grad.numel() == 0) continue;
+        const BasicTensor<T> g = std::move(n.grad);
+        n.grad = BasicTensor<T>();
+        n.backward(*this, g);
+    }
+}
+
+template <typename T>
+void Tape<T>::zero_grad() {
+    for (std::size_t i = 0; i < nodes_.size(); ++i) nodes_[i].grad = BasicTensor<T>();
+}
+
+template <typename T>
+void Tape<T>::clear() {
+    nodes_.clear();
+}
+
+template <typename T>
+std::size_t Tape<T>::activation_bytes() const {
+    std::size_t bytes = 0;
+    for (std::size_t i = 0; i < nodes_.size(); ++i) {
+        if (!nodes_[i].leaf) bytes += nodes_[i].value.numel() * sizeof(T);
+    }
+    return bytes;
+}
+
+//
+//CHECKPOINT
+//
+
+template <typename T>
+Var<T> Tape<T>::checkpoint(const std::vector<Var<T> >& inputs, const Segment& fn) {
+    for (std::size_t i = 0; i < inputs.size(); ++i) check_var_or_throw(inputs[i], "autograd::Tape::checkpoint");
+
+    // Forward en una cinta temporal sin gradientes: al destruirse libera los intermedios.
+    BasicTensor<T> y;
+    {
+        Tape<T> sub;
+        std::vector<Var<T> > sub_inputs;
+        for (std::size_t i = 0; i < inputs.size(); ++i) sub_inputs.push_back(sub.leaf(inputs[i].value(), false));
+        const Var<T> out = fn(sub, sub_inputs);
+        if (out.tape() != &sub) {
+            throw std::invalid_argument("autograd::Tape::checkpoint: fn tiene que devolver una Var de la Tape que recibe");
+        }
+        y = share(out.value());
+    }
+
+    return record(std::move(y), inputs, [inputs, fn](Tape<T>& tape, const BasicTensor<T>& g) {
+        Tape<T> sub;
+        std::vector<Var<T> > sub_inputs;
+        for (std::size_t i = 0; i < inputs.size(); ++i)
+            sub_inputs.push_back(sub.leaf(inputs[i].value(), inputs[i].requires_grad()));
+        const Var<T> out = fn(sub, sub_inputs);
+        sub.backward(out, g);
+        for (std::size_t i = 0; i < inputs.size(); ++i) {
+            if (sub_inputs[i].grad().numel() > 0) tape.accumulate(inputs[i], share(sub_inputs[i].grad()));
+        }
+    });
+}
+
+//
+//OPERACIONES
+//
+
+template <typename T>
+Var<T> matmul(const Var<T>& a, const Var<T>& b) {
+    Tape<T>& tape = same_tape_or_throw(a, b, "autograd::matmul");
+    return tape.record(::matmul(a.value(), b.value()), {a, b}, [a, b](Tape<T>& t, const BasicTensor<T>& g) {
+        // dA = g * B^T, dB = A^T * g (por lote si es 3D; un operando 2D suma sobre el lote).
+        if (a.requires_grad()) t.accumulate(a, reduce_to(::matmul(g, transpose_last(b.value())), a.shape(), false));
+        if (b.requires_grad()) t.accumulate(b, reduce_to(::matmul(transpose_last(a.value()), g), b.shape(), false));
+    });
+}
+
+template <typename T>
+Var<T> operator+(const Var<T>& a, const Var<T>& b) {
+    Tape<T>& tape = same_tape_or_throw(a, b, "autograd::operator+");
+    return tape.record(BasicTensor<T>(a.value() + b.value()), {a, b}, [a, b](Tape<T>& t, const BasicTensor<T>& g) {
+        if (a.requires_grad()) t.accumulate(a, reduce_to(g, a.shape(), false));
+        if (b.requires_grad()) t.accumulate(b, reduce_to(g, b.shape(), a.requires_grad()));
+    });
+}
+
+template <typename T>
+Var<T> operator-(const Var<T>& a, const Var<T>& b) {
+    Tape<T>& tape = same_tape_or_throw(a, b, "autograd::operator-");
+    return tape.record(BasicTensor<T>(a.value() - b.value()), {a, b}, [a, b](Tape<T>& t, const BasicTensor<T>& g) {
+        if (a.requires_grad()) t.accumulate(a, reduce_to(g, a.shape(), false));
+        if (b.requires_grad()) t.accumulate(b, BasicTensor<T>(reduce_to(g, b.shape(), false) * -1.0));
+    });
+}
+
+template <typename T>
+Var<T> operator*(const Var<T>& a, const Var<T>& b) {
+    Tape<T>& tape = same_tape_or_throw(a, b, "autograd::operator*");
+    return tape.record(BasicTensor<T>(a.value() * b.value()), {a, b}, [a, b](Tape<T>& t, const BasicTensor<T>& g) {
+        if (a.requires_grad()) t.accumulate(a, reduce_to(BasicTensor<T>(g * b.value()), a.shape(), false));
+        if (b.requires_grad()) t.accumulate(b, reduce_to(BasicTensor<T>(g * a.value()), b.shape(), false));
+    });
+}
+
+template <typename T>
+Var<T> operator*(const Var<T>& a, double scalar) {
+    Tape<T>& tape = tape_or_throw(a, "autograd::operator*");
+    return tape.record(BasicTensor<T>(a.value() * scalar), {a}, [a, scalar](Tape<T>& t, const BasicTensor<T>& g) {
+        t.accumulate(a, BasicTensor<T>(g * scalar));
+    });
+}
+
+// La derivada se calcula con la salida y: relu' = (y > 0), sigmoid' = y (1 - y), tanh' = 1 - y^2.
+template <typename T>
+Var<T> apply(const Var<T>& a, const TensorTransform& op) {
+    Tape<T>& tape = tape_or_throw(a, "autograd::apply");
+    Activation kind;
+    if (dynamic_cast<const ReLU*>(&op) != nullptr) kind = Activation::ReLU;
+    else if (dynamic_cast<const Sigmoid*>(&op) != nullptr) kind = Activation::Sigmoid;
+    else if (dynamic_cast<const Tanh*>(&op) != nullptr) kind = Activation::Tanh;
+    else throw std::invalid_argument("autograd::apply: derivada no disponible (usar ReLU, Sigmoid o Tanh)");
+
+    BasicTensor<T> y = a.value().apply(op);
+    const BasicTensor<T> ys = share(y);
+    return tape.record(std::move(y), {a}, [a, kind, ys](Tape<T>& t, const BasicTensor<T>& g) {
+        BasicTensor<T> ga = BasicTensor<T>::zeros(a.shape());
+        const T* py = ys.data();
+        const T* pg = g.data();
+        T* po = ga.data();
+        const std::size_t n = ga.numel();
+        switch (kind) {
+        case Activation::ReLU:
+            for (std::size_t i = 0; i < n; ++i) po[i] = py[i] > T(0) ? pg[i] : T(0);
+            break;
+        case Activation::Sigmoid:
+            for (std::size_t i = 0; i < n; ++i) po[i] = pg[i] * py[i] * (T(1) - py[i]);
+            break;
+        case Activation::Tanh:
+            for (std::size_t i = 0; i < n; ++i) po[i] = pg[i] * (T(1) - py[i] * py[i]);
+            break;
+        }
+        t.accumulate(a, std::move(ga));
+    });
+}
+
+template <typename T>
+Var<T> relu(const Var<T>& a) {
+    static const ReLU op;
+    return apply(a, op);
+}
+
+template <typename T>
+Var<T> sigmoid(const Var<T>& a) {
+    static const Sigmoid op;
+    return apply(a, op);
+}
+
+template <typename T>
+Var<T> view(const Var<T>& a, const std::vector<std::size_t>& shape) {
+    Tape<T>& tape = tape_or_throw(a, "autograd::view");
+    return tape.record(a.value().view(shape), {a}, [a](Tape<T>& t, const BasicTensor<T>& g) {
+        t.accumulate(a, g.view(a.shape()));
+    });
+}
+
+template <typename T>
+Var<T> unsqueeze(const Var<T>& a, std::size_t dim) {
+    Tape<T>& tape = tape_or_throw(a, "autograd::unsqueeze");
+    return tape.record(a.value().unsqueeze(dim), {a}, [a](Tape<T>& t, const BasicTensor<T>& g) {
+        t.accumulate(a, g.view(a.shape()));
+    });
+}
+
+template <typename T>
+Var<T> concat(const std::vector<Var<T> >& parts, std::size_t dim) {
+    if (parts.empty()) {
+        throw std::invalid_argument("autograd::concat: parts esta vacio");
+    }
+    Tape<T>& tape = tape_or_throw(parts[0], "autograd::concat");
+    std::vector<BasicTensor<T> > values;
+    for (std::size_t i = 0; i < parts.size(); ++i) {
+        same_tape_or_throw(parts[0], parts[i], "autograd::concat");
+        values.push_back(share(parts[i].value()));
+    }
+    return tape.record(BasicTensor<T>::concat(values, dim), parts, [parts, dim](Tape<T>& t, const BasicTensor<T>& g) {
+        std::size_t begin = 0;
+        for (std::size_t i = 0; i < parts.size(); ++i) {
+            const std::size_t end = begin + parts[i].shape()[dim];
+            if (parts[i].requires_grad()) t.accumulate(parts[i], g.slice(dim, begin, end).contiguous());
+            begin = end;
+        }
+    });
+}
+
+template <typename T>
+Var<T> sum(const Var<T>& a) {
+    Tape<T>& tape = tape_or_throw(a, "autograd::sum");
+    BasicTensor<T> y = BasicTensor<T>::zeros({1});
+    y.at(0) = a.value().sum();
+    return tape.record(std::move(y), {a}, [a](Tape<T>& t, const BasicTensor<T>& g) {
+        t.accumulate(a, BasicTensor<T>(BasicTensor<T>::ones(a.shape()) * static_cast<double>(g.at(0))));
+    });
+}
+
+template <typename T>
+Var<T> mean(const Var<T>& a) {
+    Tape<T>& tape = tape_or_throw(a, "autograd::mean");
+    BasicTensor<T> y = BasicTensor<T>::zeros({1});
+    y.at(0) = a.value().mean();
+    return tape.record(std::move(y), {a}, [a](Tape<T>& t, const BasicTensor<T>& g) {
+        const double scale = static_cast<double>(g.at(0)) / static_cast<double>(a.value().numel());
+        t.accumulate(a, BasicTensor<T>(BasicTensor<T>::ones(a.shape()) * scale));
+    });
+}
+
+//
+//INSTANCIACIONES
+//
+
+template class Tape<float>;
+template class Tape<double>;
+
+template Var<float>  matmul(const Var<float>& a, const Var<float>& b);
+template Var<double> matmul(const Var<double>& a, const Var<double>& b);
+template Var<float>  operator+(const Var<float>& a, const Var<float>& b);
+template Var<double> operator+(const Var<double>& a, const Var<double>& b);
+template Var<float>  operator-(const Var<float>& a, const Var<float>& b);
+template Var<double> operator-(const Var<double>& a, const Var<double>& b);
+template Var<float>  operator*(const Var<float>& a, const Var<float>& b);
+template Var<double> operator*(const Var<double>& a, const Var<double>& b);
+template Var<float>  operator*(const Var<float>& a, double scalar);
+template Var<double> operator*(const Var<double>& a, double scalar);
+template Var<float>  apply(const Var<float>& a, const TensorTransform& op);
+template Var<double> apply(const Var<double>& a, const TensorTransform& op);
+template Var<float>  relu(const Var<float>& a);
+template Var<double> relu(const Var<double>& a);
+template Var<float>  sigmoid(const Var<float>& a);
+template Var<double> sigmoid(const Var<double>& a);
+template Var<float>  view(const Var<float>& a, const std::vector<std::size_t>& shape);
+template Var<double> view(const Var<double>& a, const std::vector<std::size_t>& shape);
+template Var<float>  unsqueeze(const Var<float>& a, std::size_t dim);
+template Var<double> unsqueeze(const Var<double>& a, std::size_t dim);
+template Var<float>  concat(const std::vector<Var<float> >& parts, std::size_t dim);
+template Var<double> concat(const std::vector<Var<double> >& parts, std::size_t dim);
+template Var<float>  sum(const Var<float>& a);
+template Var<double> sum(const Var<double>& a);
+template Var<float>  mean(const Var<float>& a);
+template Var<double> mean(const Var<double>& a);
+
+}
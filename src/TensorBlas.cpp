@@ -0,0 +1,324 @@
+#include "../include/TensorBlas.h"
+#include "../include/Tensor.h"
+#include "../include/TensorParallel.h"
+#include "TensorSimd.h"
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+// Tamaño de los trozos de dot/nrm2/asum: fijo, para que la suma sea la misma en serie y en paralelo.
+const std::size_t CHUNK = std::size_t(1) << 14;
+
+std::atomic<std::size_t> parallel_elems(std::size_t(1) << 16);
+
+bool use_threads(std::size_t n) {
+    return n >= parallel_elems.load() && !parallel::in_parallel_region() && parallel::num_threads() > 1;
+}
+
+//
+//KERNELS (un trozo)
+//
+
+template <typename T>
+T dot_kernel(std::size_t n, const T* x, std::size_t incx, const T* y, std::size_t incy) {
+    typedef typename simd::vec_of<T>::type V;
+    const std::size_t W = V::width;
+    std::size_t i = 0;
+    T r = 0;
+    if (incx == 1 && incy == 1) {
+        V a0 = simd::set1(0.0, V()), a1 = a0, a2 = a0, a3 = a0;
+        for (; i + 4 * W <= n; i += 4 * W) {
+            a0 = simd::fmadd(simd::load(x + i, V()), simd::load(y + i, V()), a0);
+            a1 = simd::fmadd(simd::load(x + i + W, V()), simd::load(y + i + W, V()), a1);
+            a2 = simd::fmadd(simd::load(x + i + 2 * W, V()), simd::load(y + i + 2 * W, V()), a2);
+            a3 = simd::fmadd(simd::load(x + i + 3 * W, V()), simd::load(y + i + 3 * W, V()), a3);
+        }
+        for (; i + W <= n; i += W)
+            a0 = simd::fmadd(simd::load(x + i, V()), simd::load(y + i, V()), a0);
+        r = simd::hsum((a0 + a1) + (a2 + a3));
+        for (; i < n; ++i) r += x[i] * y[i];
+        return r;
+    }
+    T s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    for (; i + 4 <= n; i += 4) {
+        s0 += x[i * incx] * y[i * incy];
+        s1 += x[(i + 1) * incx] * y[(i + 1) * incy];
+        s2 += x[(i + 2) * incx] * y[(i + 2) * incy];
+        s3 += x[(i + 3) * incx] * y[(i + 3) * incy];
+    }
+    r = (s0 + s1) + (s2 + s3);
+    for (; i < n; ++i) r += x[i * incx] * y[i * incy];
+    return r;
+}
+
+// sum(|x[i]| * scale) si Square == false, sum((x[i] * scale)^2) si Square == true.
+template <typename T, bool Square>
+T norm_kernel(std::size_t n, const T* x, std::size_t incx, T scale) {
+    typedef typename simd::vec_of<T>::type V;
+    const std::size_t W = V::width;
+    std::size_t i = 0;
+    T r = 0;
+    if (incx == 1) {
+        const V s = simd::set1(scale, V());
+        V a0 = simd::set1(0.0, V()), a1 = a0, a2 = a0, a3 = a0;
+        for (; i + 4 * W <= n; i += 4 * W) {
+            V v0 = simd::load(x + i, V()) * s, v1 = simd::load(x + i + W, V()) * s;
+            V v2 = simd::load(x + i + 2 * W, V()) * s, v3 = simd::load(x + i + 3 * W, V()) * s;
+            if (Square) {
+                a0 = simd::fmadd(v0, v0, a0); a1 = simd::fmadd(v1, v1, a1);
+                a2 = simd::fmadd(v2, v2, a2); a3 = simd::fmadd(v3, v3, a3);
+            } else {
+                a0 = a0 + simd::vabs(v0); a1 = a1 + simd::vabs(v1);
+                a2 = a2 + simd::vabs(v2); a3 = a3 + simd::vabs(v3);
+            }
+        }
+        r = simd::hsum((a0 + a1) + (a2 + a3));
+    }
+    for (; i < n; ++i) {
+        const T v = x[i * incx] * scale;
+        r += Square ? v * v : std::fabs(v);
+    }
+    return r;
+}
+
+template <typename T>
+T amax_kernel(std::size_t n, const T* x, std::size_t incx) {
+    T r = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        const T v = std::fabs(x[i * incx]);
+        r = v > r ? v : r;
+    }
+    return r;
+}
+
+template <typename T>
+void axpy_kernel(std::size_t n, T alpha, const T* x, std::size_t incx, T* y, std::size_t incy) {
+    typedef typename simd::vec_of<T>::type V;
+    const std::size_t W = V::width;
+    std::size_t i = 0;
+    if (incx == 1 && incy == 1) {
+        const V a = simd::set1(alpha, V());
+        for (; i + 2 * W <= n; i += 2 * W) {
+            simd::store(y + i, simd::fmadd(a, simd::load(x + i, V()), simd::load(y + i, V())));
+            simd::store(y + i + W, simd::fmadd(a, simd::load(x + i + W, V()), simd::load(y + i + W, V())));
+        }
+    }
+    for (; i < n; ++i) y[i * incy] += alpha * x[i * incx];
+}
+
+template <typename T>
+void scal_kernel(std::size_t n, T alpha, T* x, std::size_t incx) {
+    typedef typename simd::vec_of<T>::type V;
+    const std::size_t W = V::width;
+    std::size_t i = 0;
+    if (incx == 1) {
+        const V a = simd::set1(alpha, V());
+        for (; i + 2 * W <= n; i += 2 * W) {
+            simd::store(x + i, simd::load(x + i, V()) * a);
+            simd::store(x + i + W, simd::load(x + i + W, V()) * a);
+        }
+    }
+    for (; i < n; ++i) x[i * incx] *= alpha;
+}
+
+//
+//REPARTO EN TROZOS
+//
+
+template <typename T>
+T sum_tree(const T* p, std::size_t n) {
+    if (n == 1) return p[0];
+    const std::size_t half = n / 2;
+    return sum_tree(p, half) + sum_tree(p + half, n - half);
+}
+
+// kernel(b, e) reduce [b, e). Con n > CHUNK siempre se parte igual (en serie o en paralelo).
+template <typename T, typename F>
+T chunked_sum(std::size_t n, F kernel) {
+    if (n <= CHUNK) return kernel(std::size_t(0), n);
+    const std::size_t chunks = (n + CHUNK - 1) / CHUNK;
+    std::vector<T> partial(chunks);
+    auto body = [&](std::size_t c0, std::size_t c1) {
+        for (std::size_t c = c0; c < c1; ++c)
+            partial[c] = kernel(c * CHUNK, std::min(n, (c + 1) * CHUNK));
+    };
+    if (use_threads(n)) parallel::parallel_for(0, chunks, 1, body);
+    else body(0, chunks);
+    return sum_tree(partial.data(), chunks);
+}
+
+template <typename F>
+void chunked_for(std::size_t n, F kernel) {
+    if (use_threads(n)) parallel::parallel_for(0, n, CHUNK, kernel);
+    else kernel(std::size_t(0), n);
+}
+
+}
+
+namespace blas {
+
+void set_parallel_min_elems(std::size_t n) {
+    parallel_elems.store(n);
+}
+
+std::size_t parallel_min_elems() {
+    return parallel_elems.load();
+}
+
+template <typename T>
+T dot(std::size_t n, const T* x, std::size_t incx, const T* y, std::size_t incy) {
+    return chunked_sum<T>(n, [=](std::size_t b, std::size_t e) {
+        return dot_kernel(e - b, x + b * incx, incx, y + b * incy, incy);
+    });
+}
+
+template <typename T>
+void axpy(std::size_t n, T alpha, const T* x, std::size_t incx, T* y, std::size_t incy) {
+    chunked_for(n, [=](std::size_t b, std::size_t e) {
+        axpy_kernel(e - b, alpha, x + b * incx, incx, y + b * incy, incy);
+    });
+}
+
+template <typename T>
+void scal(std::size_t n, T alpha, T* x, std::size_t incx) {
+    chunked_for(n, [=](std::size_t b, std::size_t e) {
+        scal_kernel(e - b, alpha, x + b * incx, incx);
+    });
+}
+
+template <typename T>
+T nrm2(std::size_t n, const T* x, std::size_t incx) {
+    if (n == 0) return 0;
+    const T ssq = chunked_sum<T>(n, [=](std::size_t b, std::size_t e) {
+        return norm_kernel<T, true>(e - b, x + b * incx, incx, T(1));
+    });
+    // Sin desborde ni underflow: la suma directa es exacta hasta el redondeo.
+    const T tiny = std::numeric_limits<T>::min() / std::numeric_limits<T>::epsilon();
+    if (std::isnan(ssq) || (ssq >= tiny && ssq <= std::numeric_limits<T>::max())) return std::sqrt(ssq);
+
+    // Si no, se repite con x / max|x|.
+    T amax = 0;
+    for (std::size_t b = 0; b < n; b += CHUNK) {
+        const T m = amax_kernel(std::min(CHUNK, n - b), x + b * incx, incx);
+        amax = m > amax ? m : amax;
+    }
+    if (amax == 0 || std::isinf(amax)) return amax;
+    const T inv = T(1) / amax;
+    const T scaled = chunked_sum<T>(n, [=](std::size_t b, std::size_t e) {
+        return norm_kernel<T, true>(e - b, x + b * incx, incx, inv);
+    });
+    return amax * std::sqrt(scaled);
+}
+
+template <typename T>
+T asum(std::size_t n, const T* x, std::size_t incx) {
+    return chunked_sum<T>(n, [=](std::size_t b, std::size_t e) {
+        return norm_kernel<T, false>(e - b, x + b * incx, incx, T(1));
+    });
+}
+
+}
+
+//
+//SOBRECARGAS SOBRE BasicTensor
+//
+
+template <typename T>
+const T* BasicTensor<T>::vector_data(std::size_t& inc, BasicTensor<T>& tmp) const {
+    if (is_contiguous()) {
+        inc = 1;
+        return data_;
+    }
+    if (dims() == 1) {
+        inc = strides_[0];
+        return data_;
+    }
+    tmp = contiguous();
+    inc = 1;
+    return tmp.data_;
+}
+
+namespace blas {
+
+template <typename T>
+T dot(const BasicTensor<T>& x, const BasicTensor<T>& y) {
+    if (x.shape_ != y.shape_) {
+        throw std::invalid_argument("blas::dot: shapes incompatibles (deben ser iguales)");
+    }
+    std::size_t incx, incy;
+    BasicTensor<T> tx, ty;
+    const T* px = x.vector_data(incx, tx);
+    const T* py = y.vector_data(incy, ty);
+    return dot(x.size_, px, incx, py, incy);
+}
+
+template <typename T>
+T nrm2(const BasicTensor<T>& x) {
+    std::size_t inc;
+    BasicTensor<T> tmp;
+    const T* p = x.vector_data(inc, tmp);
+    return nrm2(x.size_, p, inc);
+}
+
+template <typename T>
+T asum(const BasicTensor<T>& x) {
+    std::size_t inc;
+    BasicTensor<T> tmp;
+    const T* p = x.vector_data(inc, tmp);
+    return asum(x.size_, p, inc);
+}
+
+template <typename T>
+void axpy(double alpha, const BasicTensor<T>& x, BasicTensor<T>& y) {
+    if (x.shape_ != y.shape_) {
+        throw std::invalid_argument("blas::axpy: shapes incompatibles (deben ser iguales)");
+    }
+    // Otra vista sobre el mismo buffer: se lee de una copia.
+    const bool same_view = x.data_ == y.data_ && x.strides_ == y.strides_;
+    const BasicTensor<T> xsafe = (y.shares_storage(x) && !same_view) ? BasicTensor<T>(x) : BasicTensor<T>();
+    const BasicTensor<T>& xs = xsafe.size_ != 0 ? xsafe : x;
+
+    if (!y.is_contiguous() && y.dims() != 1) {
+        y += xs * alpha;
+        return;
+    }
+    std::size_t incx;
+    BasicTensor<T> tmp;
+    const T* px = xs.vector_data(incx, tmp);
+    axpy(y.size_, static_cast<T>(alpha), px, incx, y.data_, y.is_contiguous() ? 1 : y.strides_[0]);
+}
+
+template <typename T>
+void scal(double alpha, BasicTensor<T>& x) {
+    if (!x.is_contiguous() && x.dims() != 1) {
+        x *= alpha;
+        return;
+    }
+    scal(x.size_, static_cast<T>(alpha), x.data_, x.is_contiguous() ? 1 : x.strides_[0]);
+}
+
+}
+
+//
+//INSTANCIACIONES
+//
+
+#define TENSOR_BLAS_INSTANTIATE(T) \
+    template T blas::dot(std::size_t, const T*, std::size_t, const T*, std::size_t); \
+    template void blas::axpy(std::size_t, T, const T*, std::size_t, T*, std::size_t); \
+    template void blas::scal(std::size_t, T, T*, std::size_t); \
+    template T blas::nrm2(std::size_t, const T*, std::size_t); \
+    template T blas::asum(std::size_t, const T*, std::size_t); \
+    template const T* BasicTensor<T>::vector_data(std::size_t&, BasicTensor<T>&) const; \
+    template T blas::dot(const BasicTensor<T>&, const BasicTensor<T>&); \
+    template T blas::nrm2(const BasicTensor<T>&); \
+    template T blas::asum(const BasicTensor<T>&); \
+    template void blas::axpy(double, const BasicTensor<T>&, BasicTensor<T>&); \
+    template void blas::scal(double, BasicTensor<T>&);
+
+TENSOR_BLAS_INSTANTIATE(float)
+TENSOR_BLAS_INSTANTIATE(double)
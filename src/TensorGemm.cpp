@@ -0,0 +1,438 @@
+#include "../include/TensorGemm.h"
+#include "../include/TensorParallel.h"
+#include "../include/TensorTransform.h"
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+namespace gemm {
+
+//
+//TAMAÑOS DEL MICRO-KERNEL (registros): 12 acumuladores AVX2 en ambos casos
+//
+template <typename T> struct Kernel;
+template <> struct Kernel<double> { static const std::size_t MR = 6; static const std::size_t NR = 8; };
+template <> struct Kernel<float>  { static const std::size_t MR = 6; static const std::size_t NR = 16; };
+
+// Productos con menos flops que esto no compensan el empaquetado.
+static const std::size_t SMALL_GEMM_FLOPS = 32 * 32 * 32;
+
+// m*n*k a partir del cual se reparte C entre hilos (1000x100x10 queda en serie).
+static std::atomic<std::size_t> parallel_flops(std::size_t(1) << 22);
+
+//
+//TAMAÑOS DE BLOQUE SEGUN CACHE
+//
+
+static std::size_t cache_bytes(int level, std::size_t fallback) {
+    long v = 0;
+#if defined(_SC_LEVEL1_DCACHE_SIZE) && defined(_SC_LEVEL2_CACHE_SIZE) && defined(_SC_LEVEL3_CACHE_SIZE)
+    if (level == 1) v = sysconf(_SC_LEVEL1_DCACHE_SIZE);
+    else if (level == 2) v = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    else v = sysconf(_SC_LEVEL3_CACHE_SIZE);
+#else
+    (void)level;
+#endif
+    return v > 0 ? static_cast<std::size_t>(v) : fallback;
+}
+
+template <typename T>
+static BlockSizes compute_block_sizes() {
+    const std::size_t MR = Kernel<T>::MR, NR = Kernel<T>::NR;
+    const std::size_t l1 = cache_bytes(1, 32 * 1024);
+    const std::size_t l2 = cache_bytes(2, 256 * 1024);
+    const std::size_t l3 = cache_bytes(3, 8 * 1024 * 1024);
+
+    BlockSizes bs;
+    // Un micro-panel de B (kc x NR) ocupa la mitad de L1; el resto queda para A y C.
+    bs.kc = (l1 / 2) / (NR * sizeof(T));
+    bs.kc = std::max<std::size_t>(64, std::min<std::size_t>(bs.kc, 512));
+
+    // El bloque empaquetado de A (mc x kc) ocupa la mitad de L2.
+    bs.mc = (l2 / 2) / (bs.kc * sizeof(T));
+    bs.mc = std::max(MR, std::min<std::size_t>(bs.mc, 1024) / MR * MR);
+
+    // El panel empaquetado de B (kc x nc) ocupa la mitad de L3.
+    bs.nc = (l3 / 2) / (bs.kc * sizeof(T));
+    bs.nc = std::max(NR, std::min<std::size_t>(bs.nc, 8192) / NR * NR);
+    return bs;
+}
+
+template <typename T>
+const BlockSizes& block_sizes() {
+    static const BlockSizes bs = compute_block_sizes<T>();
+    return bs;
+}
+
+//
+//EMPAQUETADO
+//
+
+// A(mb x kb) -> paneles de MR filas; dentro de cada panel, MR valores por cada p.
+template <typename T>
+static void pack_a(std::size_t mb, std::size_t kb,
+                   const T* a, std::size_t rsa, std::size_t csa, T* dst) {
+    const std::size_t MR = Kernel<T>::MR;
+    for (std::size_t ir = 0; ir < mb; ir += MR) {
+        const std::size_t mr = std::min(MR, mb - ir);
+        for (std::size_t p = 0; p < kb; ++p) {
+            const T* src = a + ir * rsa + p * csa;
+            std::size_t i = 0;
+            for (; i < mr; ++i) dst[i] = src[i * rsa];
+            for (; i < MR; ++i) dst[i] = T(0);
+            dst += MR;
+        }
+    }
+}
+
+// B(kb x nb) -> paneles de NR columnas; dentro de cada panel, NR valores por cada p.
+template <typename T>
+static void pack_b(std::size_t kb, std::size_t nb,
+                   const T* b, std::size_t rsb, std::size_t csb, T* dst) {
+    const std::size_t NR = Kernel<T>::NR;
+    for (std::size_t jr = 0; jr < nb; jr += NR) {
+        const std::size_t nr = std::min(NR, nb - jr);
+        for (std::size_t p = 0; p < kb; ++p) {
+            const T* src = b + p * rsb + jr * csb;
+            std::size_t j = 0;
+            if (csb == 1) {
+                for (; j < nr; ++j) dst[j] = src[j];
+            } else {
+                for (; j < nr; ++j) dst[j] = src[j * csb];
+            }
+            for (; j < NR; ++j) dst[j] = T(0);
+            dst += NR;
+        }
+    }
+}
+
+//
+//MICRO-KERNEL: tile(MR x NR) = panel_a(MR x kc) * panel_b(kc x NR)
+//
+
+#if defined(__AVX2__) && defined(__FMA__)
+
+static void micro_kernel(std::size_t kc, const double* pa, const double* pb, double* tile) {
+    const std::size_t MR = Kernel<double>::MR, NR = Kernel<double>::NR;
+    __m256d c00 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd();
+    __m256d c10 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd();
+    __m256d c20 = _mm256_setzero_pd(), c21 = _mm256_setzero_pd();
+    __m256d c30 = _mm256_setzero_pd(), c31 = _mm256_setzero_pd();
+    __m256d c40 = _mm256_setzero_pd(), c41 = _mm256_setzero_pd();
+    __m256d c50 = _mm256_setzero_pd(), c51 = _mm256_setzero_pd();
+
+    for (std::size_t p = 0; p < kc; ++p) {
+        const __m256d b0 = _mm256_loadu_pd(pb);
+        const __m256d b1 = _mm256_loadu_pd(pb + 4);
+        __m256d a;
+        a = _mm256_broadcast_sd(pa + 0); c00 = _mm256_fmadd_pd(a, b0, c00); c01 = _mm256_fmadd_pd(a, b1, c01);
+        a = _mm256_broadcast_sd(pa + 1); c10 = _mm256_fmadd_pd(a, b0, c10); c11 = _mm256_fmadd_pd(a, b1, c11);
+        a = _mm256_broadcast_sd(pa + 2); c20 = _mm256_fmadd_pd(a, b0, c20); c21 = _mm256_fmadd_pd(a, b1, c21);
+        a = _mm256_broadcast_sd(pa + 3); c30 = _mm256_fmadd_pd(a, b0, c30); c31 = _mm256_fmadd_pd(a, b1, c31);
+        a = _mm256_broadcast_sd(pa + 4); c40 = _mm256_fmadd_pd(a, b0, c40); c41 = _mm256_fmadd_pd(a, b1, c41);
+        a = _mm256_broadcast_sd(pa + 5); c50 = _mm256_fmadd_pd(a, b0, c50); c51 = _mm256_fmadd_pd(a, b1, c51);
+        pa += MR;
+        pb += NR;
+    }
+
+    _mm256_storeu_pd(tile + 0 * NR, c00); _mm256_storeu_pd(tile + 0 * NR + 4, c01);
+    _mm256_storeu_pd(tile + 1 * NR, c10); _mm256_storeu_pd(tile + 1 * NR + 4, c11);
+    _mm256_storeu_pd(tile + 2 * NR, c20); _mm256_storeu_pd(tile + 2 * NR + 4, c21);
+    _mm256_storeu_pd(tile + 3 * NR, c30); _mm256_storeu_pd(tile + 3 * NR + 4, c31);
+    _mm256_storeu_pd(tile + 4 * NR, c40); _mm256_storeu_pd(tile + 4 * NR + 4, c41);
+    _mm256_storeu_pd(tile + 5 * NR, c50); _mm256_storeu_pd(tile + 5 * NR + 4, c51);
+}
+
+static void micro_kernel(std::size_t kc, const float* pa, const float* pb, float* tile) {
+    const std::size_t MR = Kernel<float>::MR, NR = Kernel<float>::NR;
+    __m256 c00 = _mm256_setzero_ps(), c01 = _mm256_setzero_ps();
+    __m256 c10 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps();
+    __m256 c20 = _mm256_setzero_ps(), c21 = _mm256_setzero_ps();
+    __m256 c30 = _mm256_setzero_ps(), c31 = _mm256_setzero_ps();
+    __m256 c40 = _mm256_setzero_ps(), c41 = _mm256_setzero_ps();
+    __m256 c50 = _mm256_setzero_ps(), c51 = _mm256_setzero_ps();
+
+    for (std::size_t p = 0; p < kc; ++p) {
+        const __m256 b0 = _mm256_loadu_ps(pb);
+        const __m256 b1 = _mm256_loadu_ps(pb + 8);
+        __m256 a;
+        a = _mm256_broadcast_ss(pa + 0); c00 = _mm256_fmadd_ps(a, b0, c00); c01 = _mm256_fmadd_ps(a, b1, c01);
+        a = _mm256_broadcast_ss(pa + 1); c10 = _mm256_fmadd_ps(a, b0, c10); c11 = _mm256_fmadd_ps(a, b1, c11);
+        a = _mm256_broadcast_ss(pa + 2); c20 = _mm256_fmadd_ps(a, b0, c20); c21 = _mm256_fmadd_ps(a, b1, c21);
+        a = _mm256_broadcast_ss(pa + 3); c30 = _mm256_fmadd_ps(a, b0, c30); c31 = _mm256_fmadd_ps(a, b1, c31);
+        a = _mm256_broadcast_ss(pa + 4); c40 = _mm256_fmadd_ps(a, b0, c40); c41 = _mm256_fmadd_ps(a, b1, c41);
+        a = _mm256_broadcast_ss(pa + 5); c50 = _mm256_fmadd_ps(a, b0, c50); c51 = _mm256_fmadd_ps(a, b1, c51);
+        pa += MR;
+        pb += NR;
+    }
+
+    _mm256_storeu_ps(tile + 0 * NR, c00); _mm256_storeu_ps(tile + 0 * NR + 8, c01);
+    _mm256_storeu_ps(tile + 1 * NR, c10); _mm256_storeu_ps(tile + 1 * NR + 8, c11);
+    _mm256_storeu_ps(tile + 2 * NR, c20); _mm256_storeu_ps(tile + 2 * NR + 8, c21);
+    _mm256_storeu_ps(tile + 3 * NR, c30); _mm256_storeu_ps(tile + 3 * NR + 8, c31);
+    _mm256_storeu_ps(tile + 4 * NR, c40); _mm256_storeu_ps(tile + 4 * NR + 8, c41);
+    _mm256_storeu_ps(tile + 5 * NR, c50); _mm256_storeu_ps(tile + 5 * NR + 8, c51);
+}
+
+#else
+
+template <typename T>
+static void micro_kernel(std::size_t kc, const T* pa, const T* pb, T* tile) {
+    const std::size_t MR = Kernel<T>::MR, NR = Kernel<T>::NR;
+    T acc[MR][NR] = {};
+    for (std::size_t p = 0; p < kc; ++p) {
+        for (std::size_t i = 0; i < MR; ++i) {
+            const T av = pa[i];
+            for (std::size_t j = 0; j < NR; ++j) acc[i][j] += av * pb[j];
+        }
+        pa += MR;
+        pb += NR;
+    }
+    for (std::size_t i = 0; i < MR; ++i)
+        for (std::size_t j = 0; j < NR; ++j) tile[i * NR + j] = acc[i][j];
+}
+
+#endif
+
+//
+//EPILOGO: bias + activacion sobre un bloque de C
+//
+
+template <typename T>
+static void apply_epilogue(const Epilogue<T>* ep, std::size_t col0,
+                           T* c, std::size_t ldc, std::size_t mr, std::size_t nr) {
+    if (ep == nullptr) return;
+    for (std::size_t i = 0; i < mr; ++i) {
+        T* row = c + i * ldc;
+        if (ep->bias != nullptr) {
+            const T* bias = ep->bias + col0 * ep->bias_stride;
+            for (std::size_t j = 0; j < nr; ++j) row[j] += bias[j * ep->bias_stride];
+        }
+        if (ep->act != nullptr) {
+            ep->act->apply(row, row, nr);
+        }
+    }
+}
+
+template <typename T>
+static void store_tile(const T* tile, std::size_t mr, std::size_t nr,
+                       T* c, std::size_t ldc, bool first) {
+    const std::size_t NR = Kernel<T>::NR;
+    for (std::size_t i = 0; i < mr; ++i) {
+        T* row = c + i * ldc;
+        const T* t = tile + i * NR;
+        if (first) {
+            for (std::size_t j = 0; j < nr; ++j) row[j] = t[j];
+        } else {
+            for (std::size_t j = 0; j < nr; ++j) row[j] += t[j];
+        }
+    }
+}
+
+//
+//CASO PEQUEÑO: i-p-j sin empaquetar
+//
+
+template <typename T>
+static void gemm_small(std::size_t m, std::size_t n, std::size_t k,
+                       const T* a, std::size_t rsa, std::size_t csa,
+                       const T* b, std::size_t rsb, std::size_t csb,
+                       T* c, std::size_t ldc, const Epilogue<T>* ep) {
+    for (std::size_t i = 0; i < m; ++i) {
+        T* crow = c + i * ldc;
+        for (std::size_t j = 0; j < n; ++j) crow[j] = T(0);
+        for (std::size_t p = 0; p < k; ++p) {
+            const T av = a[i * rsa + p * csa];
+            const T* brow = b + p * rsb;
+            for (std::size_t j = 0; j < n; ++j) crow[j] += av * brow[j * csb];
+        }
+        apply_epilogue(ep, 0, crow, ldc, 1, n);
+    }
+}
+
+//
+//GEMM POR BLOQUES (Goto): jc -> pc -> ic -> jr -> ir
+//
+
+// Elementos de los buffers de empaquetado (A y luego B) para n columnas.
+template <typename T>
+static std::size_t pack_size(std::size_t n) {
+    const std::size_t NR = Kernel<T>::NR;
+    const BlockSizes& bs = block_sizes<T>();
+    return bs.mc * bs.kc + bs.kc * ((std::min(bs.nc, n) + NR - 1) / NR * NR);
+}
+
+// Buffer de empaquetado del hilo que llama a gemm (solo crece). Los tiles en paralelo usan
+// trozos de este buffer y no uno por worker: que hilo ejecuta cada tile cambia entre
+// llamadas, y asi la memoria se pide una sola vez por hilo llamador y shape.
+template <typename T>
+static T* pack_buffer(std::size_t elems) {
+    static thread_local std::vector<T> buf;
+    if (buf.size() < elems) buf.resize(elems);
+    return buf.data();
+}
+
+template <typename T>
+static void gemm_blocked(std::size_t m, std::size_t n, std::size_t k,
+                         const T* a, std::size_t rsa, std::size_t csa,
+                         const T* b, std::size_t rsb, std::size_t csb,
+                         T* c, std::size_t ldc, const Epilogue<T>* ep, T* pack) {
+    const std::size_t MR = Kernel<T>::MR, NR = Kernel<T>::NR;
+    const BlockSizes& bs = block_sizes<T>();
+    T* const apack = pack;
+    T* const bpack = pack + bs.mc * bs.kc;
+
+    T tile[Kernel<T>::MR * Kernel<T>::NR];
+
+    for (std::size_t jc = 0; jc < n; jc += bs.nc) {
+        const std::size_t nb = std::min(bs.nc, n - jc);
+
+        for (std::size_t pc = 0; pc < k; pc += bs.kc) {
+            const std::size_t kb = std::min(bs.kc, k - pc);
+            const bool first = (pc == 0);
+            const bool last = (pc + kb == k);
+            pack_b(kb, nb, b + pc * rsb + jc * csb, rsb, csb, bpack);
+
+            for (std::size_t ic = 0; ic < m; ic += bs.mc) {
+                const std::size_t mb = std::min(bs.mc, m - ic);
+                pack_a(mb, kb, a + ic * rsa + pc * csa, rsa, csa, apack);
+
+                for (std::size_t jr = 0; jr < nb; jr += NR) {
+                    const std::size_t nr = std::min(NR, nb - jr);
+                    for (std::size_t ir = 0; ir < mb; ir += MR) {
+                        const std::size_t mr = std::min(MR, mb - ir);
+                        micro_kernel(kb, apack + ir * kb, bpack + jr * kb, tile);
+                        T* ctile = c + (ic + ir) * ldc + jc + jr;
+                        store_tile(tile, mr, nr, ctile, ldc, first);
+                        if (last) apply_epilogue(ep, jc + jr, ctile, ldc, mr, nr);
+                    }
+                }
+            }
+        }
+    }
+}
+
+template <typename T>
+static void gemm_serial(std::size_t m, std::size_t n, std::size_t k,
+                        const T* a, std::size_t rsa, std::size_t csa,
+                        const T* b, std::size_t rsb, std::size_t csb,
+                        T* c, std::size_t ldc, const Epilogue<T>* ep, T* pack) {
+    if (m * n * k <= SMALL_GEMM_FLOPS)
+        gemm_small(m, n, k, a, rsa, csa, b, rsb, csb, c, ldc, ep);
+    else
+        gemm_blocked(m, n, k, a, rsa, csa, b, rsb, csb, c, ldc, ep, pack);
+}
+
+//
+//PARTICION 2D DE C ENTRE HILOS
+//
+
+// Elige tm x tn tiles (tm * tn <= threads) con tiles lo mas cuadrados posible,
+// respetando que cada tile tenga al menos MR filas y NR columnas.
+static void choose_grid(std::size_t m, std::size_t n, std::size_t threads,
+                        std::size_t MR, std::size_t NR,
+                        std::size_t& tm, std::size_t& tn) {
+    const std::size_t max_tm = std::max<std::size_t>(1, m / MR);
+    const std::size_t max_tn = std::max<std::size_t>(1, n / NR);
+    tm = 1;
+    tn = 1;
+    double best = -1.0;
+    for (std::size_t r = 1; r <= threads && r <= max_tm; ++r) {
+        const std::size_t cc = std::min(threads / r, max_tn);
+        const double tile_m = static_cast<double>(m) / r;
+        const double tile_n = static_cast<double>(n) / cc;
+        // Primero usar el maximo de hilos; a igualdad, tiles con mejor relacion de aspecto.
+        const double aspect = std::min(tile_m, tile_n) / std::max(tile_m, tile_n);
+        const double score = static_cast<double>(r * cc) + aspect;
+        if (score > best) {
+            best = score;
+            tm = r;
+            tn = cc;
+        }
+    }
+}
+
+static std::size_t split_point(std::size_t total, std::size_t parts, std::size_t i, std::size_t align) {
+    const std::size_t blocks = (total + align - 1) / align;
+    return std::min(total, (blocks * i / parts) * align);
+}
+
+void set_parallel_threshold(std::size_t flops) {
+    parallel_flops.store(flops);
+}
+
+std::size_t parallel_threshold() {
+    return parallel_flops.load();
+}
+
+template <typename T>
+void gemm(std::size_t m, std::size_t n, std::size_t k,
+          const T* a, std::size_t rsa, std::size_t csa,
+          const T* b, std::size_t rsb, std::size_t csb,
+          T* c, std::size_t ldc,
+          const Epilogue<T>* ep) {
+    const std::size_t MR = Kernel<T>::MR, NR = Kernel<T>::NR;
+    if (m == 0 || n == 0) return;
+
+    const std::size_t threads = parallel::in_parallel_region() ? 1 : parallel::num_threads();
+    if (threads <= 1 || m * n * k < parallel_flops.load()) {
+        T* pack = m * n * k <= SMALL_GEMM_FLOPS ? nullptr : pack_buffer<T>(pack_size<T>(n));
+        gemm_serial(m, n, k, a, rsa, csa, b, rsb, csb, c, ldc, ep, pack);
+        return;
+    }
+
+    std::size_t tm, tn;
+    choose_grid(m, n, threads, MR, NR, tm, tn);
+    std::size_t tile_n = 0;
+    for (std::size_t tj = 0; tj < tn; ++tj)
+        tile_n = std::max(tile_n, split_point(n, tn, tj + 1, NR) - split_point(n, tn, tj, NR));
+    const std::size_t tile_pack = pack_size<T>(tile_n);
+    T* const packs = pack_buffer<T>(tm * tn * tile_pack);
+
+    auto tiles = [&](std::size_t t0, std::size_t t1) {
+        for (std::size_t t = t0; t < t1; ++t) {
+            const std::size_t ti = t / tn, tj = t % tn;
+            const std::size_t i0 = split_point(m, tm, ti, MR), i1 = split_point(m, tm, ti + 1, MR);
+            const std::size_t j0 = split_point(n, tn, tj, NR), j1 = split_point(n, tn, tj + 1, NR);
+            if (i0 >= i1 || j0 >= j1) continue;
+            Epilogue<T> tile_ep;
+            if (ep != nullptr) {
+                tile_ep = *ep;
+                if (tile_ep.bias != nullptr) tile_ep.bias += j0 * tile_ep.bias_stride;
+            }
+            gemm_serial(i1 - i0, j1 - j0, k,
+                        a + i0 * rsa, rsa, csa,
+                        b + j0 * csb, rsb, csb,
+                        c + i0 * ldc + j0, ldc, ep != nullptr ? &tile_ep : nullptr,
+                        packs + t * tile_pack);
+        }
+    };
+    // std::cref: el std::function de parallel_for guarda la referencia sin pedir memoria.
+    parallel::parallel_for(0, tm * tn, 1, std::cref(tiles));
+}
+
+//
+//INSTANCIACIONES
+//
+
+template const BlockSizes& block_sizes<float>();
+template const BlockSizes& block_sizes<double>();
+
+template void gemm<float>(std::size_t, std::size_t, std::size_t,
+                          const float*, std::size_t, std::size_t,
+                          const float*, std::size_t, std::size_t,
+                          float*, std::size_t, const Epilogue<float>*);
+template void gemm<double>(std::size_t, std::size_t, std::size_t,
+                           const double*, std::size_t, std::size_t,
+                           const double*, std::size_t, std::size_t,
+                           double*, std::size_t, const Epilogue<double>*);
+
+}
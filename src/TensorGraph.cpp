@@ -0,0 +1,648 @@
+#include "../include/TensorGraph.h"
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+#include <utility>
+
+namespace graph {
+
+namespace {
+
+std::string shape_str(const std::vector<std::size_t>& shape) {
+    std::string s = "(";
+    for (std::size_t i = 0; i < shape.size(); ++i) {
+        if (i > 0) s += ", ";
+        s += std::to_string(shape[i]);
+    }
+    return s + ")";
+}
+
+// Elementos por bloque en los kernels fusionados: los bloques de entradas e intermedios
+// quedan en cache entre un paso y el siguiente.
+const std::size_t FUSED_BLOCK = 512;
+
+std::size_t numel_of(const std::vector<std::size_t>& shape) {
+    std::size_t n = 1;
+    for (std::size_t d = 0; d < shape.size(); ++d) n *= shape[d];
+    return n;
+}
+
+// Pasos de los kernels fusionados sobre n elementos contiguos; Op es uno de los functores de
+// TensorExpr.h, asi que el bucle se instancia (y vectoriza) por operacion, sin llamadas
+// virtuales por elemento.
+template <typename Op, typename T>
+void binary_block(const T* a, const T* b, T* o, std::size_t n) {
+    for (std::size_t j = 0; j < n; ++j) o[j] = Op::apply(a[j], b[j]);
+}
+
+template <typename Op, typename T>
+void scalar_block(const T* a, T scalar, T* o, std::size_t n) {
+    for (std::size_t j = 0; j < n; ++j) o[j] = Op::apply(a[j], scalar);
+}
+
+}
+
+//
+//CONSTRUCCION
+//
+
+template <typename T>
+void Graph<T>::check_value_or_throw(const Value<T>& v, const char* fn) const {
+    if (v.graph() != this || v.id() >= nodes_.size()) {
+        throw std::invalid_argument(std::string(fn) + ": el Value no es de este Graph");
+    }
+}
+
+template <typename T>
+Value<T> Graph<T>::add_node(Node n) {
+    if (n.shape.empty() || numel_of(n.shape) == 0) {
+        throw std::invalid_argument("graph::Graph: shape vacia o con dimensiones 0");
+    }
+    n.numel = numel_of(n.shape);
+    nodes_.push_back(std::move(n));
+    constants_.push_back(BasicTensor<T>());
+    compiled_ = false;
+    return Value<T>(this, nodes_.size() - 1);
+}
+
+template <typename T>
+const std::vector<std::size_t>& Graph<T>::shape(const Value<T>& v) const {
+    check_value_or_throw(v, "graph::Graph::shape");
+    return nodes_[v.id()].shape;
+}
+
+template <typename T>
+Value<T> Graph<T>::input(const std::vector<std::size_t>& shape) {
+    Node n;
+    n.op = Op::Input;
+    n.shape = shape;
+    const Value<T> v = add_node(std::move(n));
+    inputs_.push_back(v.id());
+    return v;
+}
+
+template <typename T>
+Value<T> Graph<T>::constant(const BasicTensor<T>& t) {
+    Node n;
+    n.op = Op::Constant;
+    n.shape = t.shape();
+    const Value<T> v = add_node(std::move(n));
+    constants_[v.id()] = t.contiguous();
+    return v;
+}
+
+template <typename T>
+void Graph<T>::output(const Value<T>& v) {
+    check_value_or_throw(v, "graph::Graph::output");
+    outputs_.push_back(v.id());
+    compiled_ = false;
+}
+
+template <typename T>
+Value<T> Graph<T>::matmul(const Value<T>& a, const Value<T>& b) {
+    check_value_or_throw(a, "graph::matmul");
+    check_value_or_throw(b, "graph::matmul");
+    const std::vector<std::size_t>& sa = nodes_[a.id()].shape;
+    const std::vector<std::size_t>& sb = nodes_[b.id()].shape;
+    Node n;
+    n.op = Op::MatMul;
+    n.inputs = {a.id(), b.id()};
+    if ((sa.size() == 3 || sb.size() == 3) && sa.size() >= 2 && sb.size() >= 2) {
+        if (sa.size() > 3 || sb.size() > 3) throw std::invalid_argument("graph::matmul: tensores 2D o 3D");
+        const std::size_t da = sa.size() - 2, db = sb.size() - 2;
+        if (sa[da + 1] != sb[db]) {
+            throw std::invalid_argument("graph::matmul: shapes incompatibles " + shape_str(sa) + " x " + shape_str(sb));
+        }
+        const std::size_t batch_a = da == 1 ? sa[0] : 1, batch_b = db == 1 ? sb[0] : 1;
+        const std::size_t batch = BasicTensor<T>::broadcast_shape_or_throw({batch_a}, {batch_b})[0];
+        n.shape = {batch, sa[da], sb[db + 1]};
+    } else {
+        if (sa.size() != 2 || sb.size() != 2) throw std::invalid_argument("graph::matmul: ambos tensores deben ser 2D");
+        if (sa[1] != sb[0]) {
+            throw std::invalid_argument("graph::matmul: shapes incompatibles " + shape_str(sa) + " x " + shape_str(sb));
+        }
+        n.shape = {sa[0], sb[1]};
+    }
+    return add_node(std::move(n));
+}
+
+template <typename T>
+Value<T> Graph<T>::linear(const Value<T>& x, const Value<T>& w, const Value<T>& b, const TensorTransform* act) {
+    check_value_or_throw(x, "graph::linear");
+    check_value_or_throw(w, "graph::linear");
+    check_value_or_throw(b, "graph::linear");
+    const std::vector<std::size_t>& sx = nodes_[x.id()].shape;
+    const std::vector<std::size_t>& sw = nodes_[w.id()].shape;
+    const std::vector<std::size_t>& sb = nodes_[b.id()].shape;
+    if (sx.size() != 2 || sw.size() != 2 || sx[1] != sw[0]) {
+        throw std::invalid_argument("graph::linear: shapes incompatibles " + shape_str(sx) + " x " + shape_str(sw));
+    }
+    const std::size_t n_out = sw[1];
+    if (!(sb.size() == 1 && sb[0] == n_out) && !(sb.size() == 2 && sb[0] == 1 && sb[1] == n_out)) {
+        throw std::invalid_argument("graph::linear: bias debe tener shape (n) o (1 x n)");
+    }
+    Node n;
+    n.op = Op::Linear;
+    n.inputs = {x.id(), w.id(), b.id()};
+    n.shape = {sx[0], n_out};
+    n.transform = act;
+    return add_node(std::move(n));
+}
+
+template <typename T>
+Value<T> Graph<T>::elementwise(Op op, const Value<T>& a, const Value<T>& b, const char* fn) {
+    check_value_or_throw(a, fn);
+    check_value_or_throw(b, fn);
+    Node n;
+    n.op = op;
+    n.inputs = {a.id(), b.id()};
+    n.shape = BasicTensor<T>::broadcast_shape_or_throw(nodes_[a.id()].shape, nodes_[b.id()].shape);
+    return add_node(std::move(n));
+}
+
+template <typename T>
+Value<T> Graph<T>::add(const Value<T>& a, const Value<T>& b) { return elementwise(Op::Add, a, b, "graph::operator+"); }
+
+template <typename T>
+Value<T> Graph<T>::sub(const Value<T>& a, const Value<T>& b) { return elementwise(Op::Sub, a, b, "graph::operator-"); }
+
+template <typename T>
+Value<T> Graph<T>::mul(const Value<T>& a, const Value<T>& b) { return elementwise(Op::Mul, a, b, "graph::operator*"); }
+
+template <typename T>
+Value<T> Graph<T>::scale(const Value<T>& a, double scalar) {
+    check_value_or_throw(a, "graph::operator*");
+    Node n;
+    n.op = Op::Scale;
+    n.inputs = {a.id()};
+    n.shape = nodes_[a.id()].shape;
+    n.scalar = scalar;
+    return add_node(std::move(n));
+}
+
+template <typename T>
+Value<T> Graph<T>::apply(const Value<T>& a, const TensorTransform& op) {
+    check_value_or_throw(a, "graph::apply");
+    Node n;
+    n.op = Op::Apply;
+    n.inputs = {a.id()};
+    n.shape = nodes_[a.id()].shape;
+    n.transform = &op;
+    return add_node(std::move(n));
+}
+
+template <typename T>
+Value<T> Graph<T>::view(const Value<T>& a, const std::vector<std::size_t>& shape) {
+    check_value_or_throw(a, "graph::view");
+    if (numel_of(shape) != nodes_[a.id()].numel) {
+        throw std::invalid_argument("graph::view: " + shape_str(shape) + " no tiene la misma cantidad de elementos que "
+                                    + shape_str(nodes_[a.id()].shape));
+    }
+    Node n;
+    n.op = Op::View;
+    n.inputs = {a.id()};
+    n.shape = shape;
+    return add_node(std::move(n));
+}
+
+template <typename T>
+Value<T> Graph<T>::unsqueeze(const Value<T>& a, std::size_t dim) {
+    check_value_or_throw(a, "graph::unsqueeze");
+    std::vector<std::size_t> shape = nodes_[a.id()].shape;
+    if (dim > shape.size()) throw std::invalid_argument("graph::unsqueeze: dim out of range");
+    shape.insert(shape.begin() + static_cast<std::ptrdiff_t>(dim), 1);
+    Node n;
+    n.op = Op::Unsqueeze;
+    n.inputs = {a.id()};
+    n.shape = shape;
+    n.dim = dim;
+    return add_node(std::move(n));
+}
+
+template <typename T>
+Value<T> Graph<T>::concat(const std::vector<Value<T> >& parts, std::size_t dim) {
+    if (parts.empty()) throw std::invalid_argument("graph::concat: parts esta vacio");
+    for (std::size_t i = 0; i < parts.size(); ++i) check_value_or_throw(parts[i], "graph::concat");
+    std::vector<std::size_t> shape = nodes_[parts[0].id()].shape;
+    if (dim >= shape.size()) throw std::invalid_argument("graph::concat: dim out of range");
+    Node n;
+    n.op = Op::Concat;
+    n.dim = dim;
+    n.inputs.push_back(parts[0].id());
+    for (std::size_t i = 1; i < parts.size(); ++i) {
+        const std::vector<std::size_t>& s = nodes_[parts[i].id()].shape;
+        bool ok = s.size() == shape.size();
+        for (std::size_t d = 0; ok && d < s.size(); ++d) ok = d == dim || s[d] == shape[d];
+        if (!ok) {
+            throw std::invalid_argument("graph::concat: shapes incompatibles " + shape_str(shape) + " y " + shape_str(s));
+        }
+        shape[dim] += s[dim];
+        n.inputs.push_back(parts[i].id());
+    }
+    n.shape = shape;
+    return add_node(std::move(n));
+}
+
+//
+//FUSION
+//
+// Un nodo elemento a elemento se absorbe en su consumidor si ese es su unico uso (no es
+// salida), el consumidor tambien es elemento a elemento y ambos tienen la misma shape; asi
+// ningun intermedio se calcula dos veces ni con broadcast. Las entradas con broadcast
+// (p. ej. el bias (1 x n)) quedan como entradas externas del kernel.
+//
+
+template <typename T>
+void Graph<T>::fuse() {
+    const std::size_t n = nodes_.size();
+    absorbed_.assign(n, false);
+    fused_of_.assign(n, -1);
+    fused_.clear();
+    if (!fusion_) return;
+
+    std::vector<std::size_t> uses(n, 0);
+    for (std::size_t i = 0; i < n; ++i)
+        for (std::size_t k = 0; k < nodes_[i].inputs.size(); ++k) ++uses[nodes_[i].inputs[k]];
+    for (std::size_t k = 0; k < outputs_.size(); ++k) uses[outputs_[k]] += 2;
+
+    for (std::size_t i = 0; i < n; ++i) {
+        if (!is_elementwise(nodes_[i].op)) continue;
+        for (std::size_t k = 0; k < nodes_[i].inputs.size(); ++k) {
+            const std::size_t j = nodes_[i].inputs[k];
+            if (is_elementwise(nodes_[j].op) && uses[j] == 1 && nodes_[j].shape == nodes_[i].shape) absorbed_[j] = true;
+        }
+    }
+    for (std::size_t i = 0; i < n; ++i) {
+        if (!is_elementwise(nodes_[i].op) || absorbed_[i]) continue;
+        bool any = false;
+        for (std::size_t k = 0; k < nodes_[i].inputs.size(); ++k) any = any || absorbed_[nodes_[i].inputs[k]];
+        if (!any) continue;
+        Fused f;
+        bool from_step;
+        emit(f, i, i, from_step);
+        fused_of_[i] = static_cast<long>(fused_.size());
+        fused_.push_back(std::move(f));
+    }
+}
+
+// Agrega a f los pasos que calculan el nodo id (en orden topologico) y devuelve su operando.
+template <typename T>
+std::size_t Graph<T>::emit(Fused& f, std::size_t id, std::size_t root, bool& from_step) {
+    if (id != root && !absorbed_[id]) {
+        from_step = false;
+        for (std::size_t k = 0; k < f.inputs.size(); ++k)
+            if (f.inputs[k] == id) return k;
+        f.inputs.push_back(id);
+        return f.inputs.size() - 1;
+    }
+    const Node& n = nodes_[id];
+    Step st;
+    st.op = n.op;
+    st.arg[1] = 0;
+    st.from_step[1] = false;
+    st.scalar = n.scalar;
+    st.transform = n.transform;
+    for (std::size_t k = 0; k < n.inputs.size(); ++k) st.arg[k] = emit(f, n.inputs[k], root, st.from_step[k]);
+    f.steps.push_back(st);
+    from_step = true;
+    return f.steps.size() - 1;
+}
+
+template <typename T>
+const std::vector<std::size_t>& Graph<T>::args(std::size_t i) const {
+    return fused_of_[i] >= 0 ? fused_[fused_of_[i]].inputs : nodes_[i].inputs;
+}
+
+//
+//PLAN DE MEMORIA
+//
+// Recorre los nodos en orden (ya es topologico) saltando los absorbidos; un kernel fusionado
+// lee sus entradas externas. root(i) es el nodo dueño de la memoria de i
+// (el mismo i salvo en las vistas). last_use[r] es el ultimo nodo que lee r o una vista suya;
+// las salidas viven hasta el final. Cada nodo toma el slot libre mas chico que le alcance
+// (si no hay, agranda el mas grande libre o crea uno) y despues se liberan los slots de las
+// entradas que mueren en ese nodo.
+//
+
+template <typename T>
+void Graph<T>::plan() {
+    const std::size_t n = nodes_.size();
+    const std::size_t forever = std::numeric_limits<std::size_t>::max();
+    std::vector<std::size_t> root(n), last_use(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        root[i] = is_alias(nodes_[i].op) ? root[nodes_[i].inputs[0]] : i;
+        last_use[i] = i;
+        if (absorbed_[i]) continue;
+        const std::vector<std::size_t>& in = args(i);
+        for (std::size_t k = 0; k < in.size(); ++k) {
+            const std::size_t r = root[in[k]];
+            last_use[r] = std::max(last_use[r], i);
+        }
+    }
+    for (std::size_t k = 0; k < outputs_.size(); ++k) last_use[root[outputs_[k]]] = forever;
+
+    slot_of_.assign(n, -1);
+    slot_elems_.clear();
+    std::vector<std::size_t> free_slots;
+    std::vector<std::size_t> owner;   // root que ocupa cada slot
+
+    for (std::size_t i = 0; i < n; ++i) {
+        const Node& node = nodes_[i];
+        if (node.op == Op::Input || node.op == Op::Constant || is_alias(node.op) || absorbed_[i]) continue;
+        const std::vector<std::size_t>& in = args(i);
+
+        long chosen = -1;
+        // En el lugar: una entrada que muere aca, con la misma shape que la salida y sin que
+        // otra entrada del nodo la lea con otra shape.
+        if (is_elementwise(node.op)) {
+            for (std::size_t k = 0; k < in.size() && chosen < 0; ++k) {
+                const std::size_t r = root[in[k]];
+                if (slot_of_[r] < 0 || last_use[r] != i || nodes_[r].numel != node.numel) continue;
+                bool same_layout = true;
+                for (std::size_t q = 0; q < in.size(); ++q) {
+                    if (root[in[q]] == r && nodes_[in[q]].shape != node.shape) same_layout = false;
+                }
+                if (same_layout) chosen = slot_of_[r];
+            }
+        }
+        if (chosen < 0 && !free_slots.empty()) {
+            std::size_t best = free_slots.size(), largest = 0;
+            for (std::size_t f = 0; f < free_slots.size(); ++f) {
+                const std::size_t e = slot_elems_[free_slots[f]];
+                if (e >= node.numel && (best == free_slots.size() || e < slot_elems_[free_slots[best]])) best = f;
+                if (e > slot_elems_[free_slots[largest]]) largest = f;
+            }
+            const std::size_t pick = best < free_slots.size() ? best : largest;
+            chosen = static_cast<long>(free_slots[pick]);
+            free_slots.erase(free_slots.begin() + static_cast<std::ptrdiff_t>(pick));
+        }
+        if (chosen < 0) {
+            chosen = static_cast<long>(slot_elems_.size());
+            slot_elems_.push_back(0);
+            owner.push_back(i);
+        }
+        slot_of_[i] = chosen;
+        slot_elems_[chosen] = std::max(slot_elems_[chosen], node.numel);
+        owner[chosen] = i;
+
+        // Liberar las entradas que mueren aca (salvo el slot que se acaba de reutilizar) y el
+        // propio resultado si nadie lo usa.
+        for (std::size_t k = 0; k < in.size(); ++k) {
+            const std::size_t r = root[in[k]];
+            const long s = slot_of_[r];
+            if (s < 0 || last_use[r] != i || owner[s] != r) continue;
+            if (std::find(free_slots.begin(), free_slots.end(), static_cast<std::size_t>(s)) == free_slots.end())
+                free_slots.push_back(static_cast<std::size_t>(s));
+        }
+        if (last_use[i] == i) free_slots.push_back(static_cast<std::size_t>(chosen));
+    }
+}
+
+template <typename T>
+void Graph<T>::compile() {
+    fuse();
+    plan();
+    std::size_t max_inputs = 0, max_bufs = 0;
+    for (std::size_t f = 0; f < fused_.size(); ++f) {
+        max_inputs = std::max(max_inputs, fused_[f].inputs.size());
+        max_bufs = std::max(max_bufs, fused_[f].inputs.size() + fused_[f].steps.size());
+    }
+    fused_buf_.assign(max_bufs * FUSED_BLOCK, T(0));
+    fused_ptr_.assign(max_inputs, nullptr);
+    arena_.clear();
+    for (std::size_t s = 0; s < slot_elems_.size(); ++s) arena_.push_back(BasicTensor<T>::zeros({slot_elems_[s]}));
+
+    plans_.assign(nodes_.size(), iter::Plan());
+    values_.assign(nodes_.size(), BasicTensor<T>());
+    for (std::size_t i = 0; i < nodes_.size(); ++i) {
+        if (slot_of_[i] >= 0) values_[i] = arena_[slot_of_[i]].slice(0, 0, nodes_[i].numel).view(nodes_[i].shape);
+        else if (nodes_[i].op == Op::Constant) values_[i] = constants_[i].view(nodes_[i].shape);
+    }
+    compiled_ = true;
+}
+
+//
+//EJECUCION
+//
+
+template <typename T>
+void Graph<T>::execute(std::size_t i) {
+    const Node& n = nodes_[i];
+    BasicTensor<T>& out = values_[i];
+    if (absorbed_[i]) return;
+    if (fused_of_[i] >= 0) {
+        run_fused(fused_[fused_of_[i]], out);
+        return;
+    }
+    switch (n.op) {
+    case Op::Input:
+    case Op::Constant:
+        break;
+    case Op::MatMul:
+        ::matmul(values_[n.inputs[0]], values_[n.inputs[1]], out);
+        break;
+    case Op::Linear:
+        ::linear(values_[n.inputs[0]], values_[n.inputs[1]], values_[n.inputs[2]], n.transform, out);
+        break;
+    case Op::Add:
+        run_elementwise(i, values_[n.inputs[0]] + values_[n.inputs[1]]);
+        break;
+    case Op::Sub:
+        run_elementwise(i, values_[n.inputs[0]] - values_[n.inputs[1]]);
+        break;
+    case Op::Mul:
+        run_elementwise(i, values_[n.inputs[0]] * values_[n.inputs[1]]);
+        break;
+    case Op::Scale:
+        run_elementwise(i, values_[n.inputs[0]] * n.scalar);
+        break;
+    case Op::Apply:
+        values_[n.inputs[0]].apply(*n.transform, out);
+        break;
+    case Op::View:
+        out = values_[n.inputs[0]].view(n.shape);
+        break;
+    case Op::Unsqueeze:
+        out = values_[n.inputs[0]].unsqueeze(n.dim);
+        break;
+    case Op::Concat:
+        concat_parts_.resize(n.inputs.size());
+        for (std::size_t k = 0; k < n.inputs.size(); ++k) {
+            const BasicTensor<T>& p = values_[n.inputs[k]];
+            concat_parts_[k] = p.view(p.shape());
+        }
+        BasicTensor<T>::concat_into(concat_parts_, n.dim, out);
+        break;
+    }
+}
+
+// Como Tensor::assign, pero con el plan del nodo: las shapes y strides de la salida y de las
+// entradas no cambian entre run(), asi que se arma una sola vez. Si la salida usa el slot de una
+// entrada, plan() garantiza que es la misma vista (cada posicion se lee antes de escribirse).
+template <typename T>
+template <typename E>
+void Graph<T>::run_elementwise(std::size_t i, const E& e) {
+    BasicTensor<T>& out = values_[i];
+    iter::Plan& p = plans_[i];
+    TENSOR_PROFILE_SCOPE("graph::elementwise");
+    TENSOR_PROFILE_EXPR(e);
+    if (p.nops == 0) p = expr::plan_of(e, &out.strides_);
+    expr::evaluate(e, out.data_, p);
+}
+
+// Recorre la salida por filas (iter::Plan) y cada fila por bloques de FUSED_BLOCK: las
+// entradas contiguas se leen en su lugar, las de broadcast o con stride se copian a un
+// bloque, y cada paso escribe su bloque (el ultimo, directo en la salida). out puede ser el
+// slot de una entrada: cada posicion se lee antes de escribirse.
+template <typename T>
+void Graph<T>::run_fused(Fused& f, BasicTensor<T>& out) {
+    const std::size_t N = f.inputs.size();
+    TENSOR_PROFILE_SCOPE("graph::fused");
+    for (std::size_t k = 0; k < N; ++k) TENSOR_PROFILE_INPUT(values_[f.inputs[k]].shape_);
+    TENSOR_PROFILE_OUTPUT(out.shape_);
+    TENSOR_PROFILE_FLOPS(static_cast<double>(f.steps.size() * out.size_));
+    if (f.plan.nops == 0) {
+        std::vector<const TensorShape*> shapes(N + 1), strides(N + 1);
+        shapes[0] = &out.shape_;
+        strides[0] = &out.strides_;
+        for (std::size_t k = 0; k < N; ++k) {
+            shapes[k + 1] = &values_[f.inputs[k]].shape_;
+            strides[k + 1] = &values_[f.inputs[k]].strides_;
+        }
+        f.plan = iter::make_plan(out.shape_, N + 1, shapes.data(), strides.data());   // solo el primer run()
+    }
+    const std::size_t cols = f.plan.cols();
+    const std::size_t last = f.steps.size() - 1;
+    T* const in_buf = fused_buf_.data();
+    T* const step_buf = in_buf + N * FUSED_BLOCK;
+    const T** const p = fused_ptr_.data();
+
+    iter::for_each_row(f.plan, [&](const std::size_t* off) {
+        for (std::size_t c0 = 0; c0 < cols; c0 += FUSED_BLOCK) {
+            const std::size_t nb = std::min(FUSED_BLOCK, cols - c0);
+            for (std::size_t k = 0; k < N; ++k) {
+                const std::size_t s = cols > 1 ? f.plan.inner_stride(k + 1) : 1;
+                const T* src = values_[f.inputs[k]].data_ + off[k + 1] + c0 * s;
+                T* buf = in_buf + k * FUSED_BLOCK;
+                if (s == 1) {
+                    p[k] = src;
+                } else if (s == 0) {
+                    std::fill(buf, buf + nb, *src);
+                    p[k] = buf;
+                } else {
+                    for (std::size_t j = 0; j < nb; ++j) buf[j] = src[j * s];
+                    p[k] = buf;
+                }
+            }
+            T* const o = out.data_ + off[0] + c0;
+            for (std::size_t q = 0; q <= last; ++q) {
+                const Step& st = f.steps[q];
+                const T* a = st.from_step[0] ? step_buf + st.arg[0] * FUSED_BLOCK : p[st.arg[0]];
+                const T* b = st.from_step[1] ? step_buf + st.arg[1] * FUSED_BLOCK : p[st.arg[1]];
+                T* dst = q == last ? o : step_buf + q * FUSED_BLOCK;
+                switch (st.op) {
+                case Op::Add:   binary_block<expr::AddOp>(a, b, dst, nb); break;
+                case Op::Sub:   binary_block<expr::SubOp>(a, b, dst, nb); break;
+                case Op::Mul:   binary_block<expr::MulOp>(a, b, dst, nb); break;
+                case Op::Scale: scalar_block<expr::MulOp>(a, static_cast<T>(st.scalar), dst, nb); break;
+                case Op::Apply: st.transform->apply(a, dst, nb); break;
+                default: break;
+                }
+            }
+        }
+    });
+}
+
+template <typename T>
+void Graph<T>::run(const std::vector<BasicTensor<T> >& inputs) {
+    if (inputs.size() != inputs_.size()) {
+        throw std::invalid_argument("graph::Graph::run: se esperaban " + std::to_string(inputs_.size())
+                                    + " entradas y llegaron " + std::to_string(inputs.size()));
+    }
+    for (std::size_t k = 0; k < inputs.size(); ++k) {
+        if (inputs[k].shape() != nodes_[inputs_[k]].shape) {
+            throw std::invalid_argument("graph::Graph::run: la entrada " + std::to_string(k) + " tiene shape "
+                                        + shape_str(inputs[k].shape()) + " y se declaro "
+                                        + shape_str(nodes_[inputs_[k]].shape));
+        }
+    }
+    if (!compiled_) compile();
+    for (std::size_t k = 0; k < inputs.size(); ++k) values_[inputs_[k]] = inputs[k].contiguous();
+    for (std::size_t i = 0; i < nodes_.size(); ++i) execute(i);
+}
+
+template <typename T>
+const BasicTensor<T>& Graph<T>::run(const BasicTensor<T>& input) {
+    if (outputs_.size() != 1) {
+        throw std::invalid_argument("graph::Graph::run: el grafo tiene que tener una sola salida");
+    }
+    // contiguous() comparte el buffer; el vector es miembro para no reservarlo en cada llamada.
+    single_input_.resize(1);
+    single_input_[0] = input.contiguous();
+    run(single_input_);
+    return output(0);
+}
+
+template <typename T>
+const BasicTensor<T>& Graph<T>::output(std::size_t i) const {
+    if (i >= outputs_.size()) throw std::invalid_argument("graph::Graph::output: indice fuera de rango");
+    return values_[outputs_[i]];
+}
+
+template <typename T>
+std::size_t Graph<T>::arena_bytes() const {
+    std::size_t bytes = 0;
+    for (std::size_t s = 0; s < slot_elems_.size(); ++s) bytes += slot_elems_[s] * sizeof(T);
+    return bytes;
+}
+
+template <typename T>
+std::size_t Graph<T>::num_kernels() const {
+    std::size_t k = 0;
+    for (std::size_t i = 0; i < nodes_.size(); ++i) {
+        const Op op = nodes_[i].op;
+        if (op == Op::Input || op == Op::Constant || is_alias(op) || (compiled_ && absorbed_[i])) continue;
+        ++k;
+    }
+    return k;
+}
+
+template <typename T>
+std::size_t Graph<T>::naive_bytes() const {
+    std::size_t bytes = 0;
+    for (std::size_t i = 0; i < nodes_.size(); ++i) {
+        const Op op = nodes_[i].op;
+        if (op != Op::Input && op != Op::Constant && !is_alias(op)) bytes += nodes_[i].numel * sizeof(T);
+    }
+    return bytes;
+}
+
+template <typename T>
+void Graph<T>::print(std::ostream& os) const {
+    static const char* names[] = {"input", "constant", "matmul", "linear", "add", "sub", "mul",
+                                  "scale", "apply", "view", "unsqueeze", "concat"};
+    for (std::size_t i = 0; i < nodes_.size(); ++i) {
+        const Node& n = nodes_[i];
+        os << "%" << i << " = " << names[static_cast<int>(n.op)] << "(";
+        for (std::size_t k = 0; k < n.inputs.size(); ++k) os << (k > 0 ? ", %" : "%") << n.inputs[k];
+        os << ") " << shape_str(n.shape);
+        if (compiled_ && absorbed_[i]) os << " (fusionado)";
+        if (compiled_ && fused_of_[i] >= 0) {
+            const Fused& f = fused_[fused_of_[i]];
+            os << " fused[";
+            for (std::size_t q = 0; q < f.steps.size(); ++q) os << (q > 0 ? " " : "") << names[static_cast<int>(f.steps[q].op)];
+            os << "]";
+        }
+        if (compiled_ && slot_of_[i] >= 0) os << " slot " << slot_of_[i];
+        os << "\n";
+    }
+}
+
+//
+//INSTANCIACIONES
+//
+
+template class Graph<float>;
+template class Graph<double>;
+
+}
@@ -0,0 +1,371 @@
+#include "../include/TensorIO.h"
+#include "../include/Tensor.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace io {
+
+static const std::uint64_t FNV_OFFSET = 14695981039346656037ull;
+static const std::uint64_t FNV_PRIME = 1099511628211ull;
+
+Checksum::Checksum() : npending_(0), total_(0) {
+    for (int l = 0; l < 4; ++l) h_[l] = FNV_OFFSET;
+}
+
+void Checksum::update(const void* data, std::size_t bytes) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    total_ += bytes;
+    if (npending_ > 0) {
+        const std::size_t take = std::min(bytes, sizeof(pending_) - npending_);
+        std::memcpy(pending_ + npending_, p, take);
+        npending_ += take;
+        p += take;
+        bytes -= take;
+        if (npending_ < sizeof(pending_)) return;
+        std::uint64_t w[4];
+        std::memcpy(w, pending_, sizeof(w));
+        for (int l = 0; l < 4; ++l) h_[l] = (h_[l] ^ w[l]) * FNV_PRIME;
+        npending_ = 0;
+    }
+    for (; bytes >= 32; p += 32, bytes -= 32) {
+        std::uint64_t w[4];
+        std::memcpy(w, p, sizeof(w));
+        for (int l = 0; l < 4; ++l) h_[l] = (h_[l] ^ w[l]) * FNV_PRIME;
+    }
+    std::memcpy(pending_, p, bytes);
+    npending_ = bytes;
+}
+
+// Lo que queda (menos de 32 bytes): palabras enteras al carril 0 y bytes sueltos al final.
+std::uint64_t Checksum::value() const {
+    std::uint64_t h0 = h_[0];
+    const std::size_t words = npending_ / 8;
+    for (std::size_t i = 0; i < words; ++i) {
+        std::uint64_t w;
+        std::memcpy(&w, pending_ + i * 8, sizeof(w));
+        h0 = (h0 ^ w) * FNV_PRIME;
+    }
+    std::uint64_t r = FNV_OFFSET;
+    r = (r ^ h0) * FNV_PRIME;
+    for (int l = 1; l < 4; ++l) r = (r ^ h_[l]) * FNV_PRIME;
+    for (std::size_t b = words * 8; b < npending_; ++b) r = (r ^ pending_[b]) * FNV_PRIME;
+    return (r ^ total_) * FNV_PRIME;
+}
+
+std::uint64_t checksum(const void* data, std::size_t bytes) {
+    Checksum c;
+    c.update(data, bytes);
+    return c.value();
+}
+
+}
+
+namespace {
+
+const char MAGIC[8] = {'C', 'S', '2', '0', '1', '3', 'T', 'N'};
+
+struct Header {
+    std::uint32_t dtype;
+    std::uint32_t alignment;
+    std::uint64_t data_offset;
+    std::uint64_t data_bytes;
+    std::uint64_t checksum;
+    std::vector<std::size_t> shape;
+    std::vector<std::size_t> strides;
+};
+
+bool little_endian() {
+    const std::uint16_t one = 1;
+    unsigned char b;
+    std::memcpy(&b, &one, 1);
+    return b == 1;
+}
+
+template <typename V>
+V read_field(const unsigned char* p) {
+    V v;
+    std::memcpy(&v, p, sizeof(V));
+    return v;
+}
+
+template <typename V>
+void write_field(std::vector<unsigned char>& out, std::size_t at, V v) {
+    std::memcpy(out.data() + at, &v, sizeof(V));
+}
+
+// Parte fija (HEADER_FIXED_BYTES): devuelve el rank y llena los campos escalares de h.
+std::uint32_t parse_fixed(const unsigned char* p, Header& h, const std::string& fn) {
+    if (!little_endian()) {
+        throw std::runtime_error(fn + ": el formato .tensor solo se lee en maquinas little-endian");
+    }
+    if (std::memcmp(p, MAGIC, sizeof(MAGIC)) != 0) {
+        throw std::runtime_error(fn + ": no es un archivo .tensor (magic incorrecto)");
+    }
+    const std::uint32_t version = read_field<std::uint32_t>(p + 8);
+    if (version != io::FORMAT_VERSION) {
+        throw std::runtime_error(fn + ": version de formato no soportada (" + std::to_string(version) + ")");
+    }
+    h.dtype = read_field<std::uint32_t>(p + 12);
+    const std::uint32_t rank = read_field<std::uint32_t>(p + 16);
+    h.alignment = read_field<std::uint32_t>(p + 20);
+    h.data_offset = read_field<std::uint64_t>(p + 24);
+    h.data_bytes = read_field<std::uint64_t>(p + 32);
+    h.checksum = read_field<std::uint64_t>(p + 40);
+    // Un rank mayor no cabe en TensorShape (lanzaria invalid_argument al construir la vista).
+    if (rank == 0 || rank > kMaxDims) {
+        throw std::runtime_error(fn + ": rank invalido");
+    }
+    // Alineacion potencia de 2 y como mucho una pagina: acota el relleno antes de los datos.
+    if (h.alignment == 0 || (h.alignment & (h.alignment - 1)) != 0 || h.alignment > 4096) {
+        throw std::runtime_error(fn + ": alignment invalido");
+    }
+    // Entre el final de strides y los datos solo hay relleno hasta la alineacion.
+    const std::uint64_t used = io::HEADER_FIXED_BYTES + 16ull * rank;
+    if (h.data_offset % h.alignment != 0 ||
+        h.data_offset < used || h.data_offset >= used + h.alignment) {
+        throw std::runtime_error(fn + ": data_offset invalido");
+    }
+    return rank;
+}
+
+// shape/strides (rank uint64 cada uno) y validacion contra el tipo y el tamaño de los datos.
+template <typename T>
+void parse_dims(const unsigned char* p, std::uint32_t rank, Header& h, const std::string& fn) {
+    if (h.dtype != io::dtype_of<T>::value) {
+        throw std::runtime_error(fn + ": el archivo tiene otro tipo de elemento (dtype "
+                                 + std::to_string(h.dtype) + ")");
+    }
+    if (h.data_bytes % sizeof(T) != 0) {
+        throw std::runtime_error(fn + ": data_bytes no es multiplo del tamaño del elemento");
+    }
+    const std::uint64_t elems = h.data_bytes / sizeof(T);
+    if (elems == 0) {
+        throw std::runtime_error(fn + ": el archivo no tiene datos");
+    }
+    h.shape.resize(rank);
+    h.strides.resize(rank);
+    // last = mayor offset alcanzable; se mantiene < elems sin desbordar.
+    std::uint64_t last = 0;
+    for (std::uint32_t d = 0; d < rank; ++d) {
+        const std::uint64_t n = read_field<std::uint64_t>(p + 8 * d);
+        const std::uint64_t s = read_field<std::uint64_t>(p + 8 * (rank + d));
+        if (n == 0 || (n > 1 && s != 0 && (s >= elems || n - 1 > (elems - 1 - last) / s))) {
+            throw std::runtime_error(fn + ": shape/strides fuera de los datos");
+        }
+        if (n > 1) last += (n - 1) * s;
+        h.shape[d] = static_cast<std::size_t>(n);
+        h.strides[d] = static_cast<std::size_t>(s);
+    }
+}
+
+// Tamaño en bytes de un archivo abierto.
+bool file_size(std::FILE* f, std::uint64_t& bytes) {
+#if defined(_WIN32)
+    struct _stat64 st;
+    if (::_fstat64(::_fileno(f), &st) != 0) return false;
+#else
+    struct stat st;
+    if (::fstat(::fileno(f), &st) != 0) return false;
+#endif
+    bytes = static_cast<std::uint64_t>(st.st_size);
+    return true;
+}
+
+#if !defined(_WIN32)
+// Cierra el descriptor al salir del scope.
+struct FileCloser {
+    int fd;
+    ~FileCloser() { if (fd >= 0) ::close(fd); }
+};
+
+struct MmapDeleter {
+    void* base;
+    std::size_t bytes;
+    void operator()(void*) const { ::munmap(base, bytes); }
+};
+#endif
+
+}
+
+std::vector<unsigned char> io::encode_header(DType dtype,
+                                             const std::vector<std::size_t>& shape,
+                                             const std::vector<std::size_t>& strides,
+                                             std::uint64_t data_bytes, std::uint64_t checksum) {
+    const std::uint32_t rank = static_cast<std::uint32_t>(shape.size());
+    const std::size_t align = TENSOR_ALIGNMENT;
+    const std::size_t used = HEADER_FIXED_BYTES + 16 * rank;
+    const std::size_t data_offset = (used + align - 1) / align * align;
+
+    std::vector<unsigned char> header(data_offset, 0);
+    std::memcpy(header.data(), MAGIC, sizeof(MAGIC));
+    write_field<std::uint32_t>(header, 8, FORMAT_VERSION);
+    write_field<std::uint32_t>(header, 12, dtype);
+    write_field<std::uint32_t>(header, 16, rank);
+    write_field<std::uint32_t>(header, 20, static_cast<std::uint32_t>(align));
+    write_field<std::uint64_t>(header, 24, data_offset);
+    write_field<std::uint64_t>(header, 32, data_bytes);
+    write_field<std::uint64_t>(header, 40, checksum);
+    for (std::uint32_t d = 0; d < rank; ++d) {
+        write_field<std::uint64_t>(header, HEADER_FIXED_BYTES + 8 * d, shape[d]);
+        write_field<std::uint64_t>(header, HEADER_FIXED_BYTES + 8 * (rank + d), strides[d]);
+    }
+    return header;
+}
+
+//
+//GUARDAR
+//
+
+template <typename T>
+void BasicTensor<T>::save(const std::string& path) const {
+    if (size_ == 0) {
+        throw std::invalid_argument("Tensor::save: tensor vacio");
+    }
+    if (!little_endian()) {
+        throw std::runtime_error("Tensor::save: el formato .tensor solo se escribe en maquinas little-endian");
+    }
+    const BasicTensor<T> src = contiguous();
+    const std::size_t data_bytes = size_ * sizeof(T);
+
+    const std::vector<unsigned char> header =
+        io::encode_header(io::dtype_of<T>::value, src.shape_, src.strides_, data_bytes,
+                          io::checksum(src.data_, data_bytes));
+
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    if (f == nullptr) {
+        throw std::runtime_error("Tensor::save: no se pudo abrir " + path);
+    }
+    bool ok = std::fwrite(header.data(), 1, header.size(), f) == header.size();
+    ok = ok && std::fwrite(src.data_, 1, data_bytes, f) == data_bytes;
+    ok = (std::fclose(f) == 0) && ok;
+    if (!ok) {
+        throw std::runtime_error("Tensor::save: error al escribir " + path);
+    }
+}
+
+//
+//CARGAR (copiando)
+//
+
+template <typename T>
+BasicTensor<T> BasicTensor<T>::load(const std::string& path) {
+    const std::string fn = "Tensor::load(" + path + ")";
+    std::FILE* f = std::fopen(path.c_str(), "rb");
+    if (f == nullptr) {
+        throw std::runtime_error(fn + ": no se pudo abrir");
+    }
+    struct Closer { std::FILE* f; ~Closer() { std::fclose(f); } } closer = {f};
+
+    unsigned char fixed[io::HEADER_FIXED_BYTES];
+    if (std::fread(fixed, 1, sizeof(fixed), f) != sizeof(fixed)) {
+        throw std::runtime_error(fn + ": archivo truncado");
+    }
+    Header h;
+    const std::uint32_t rank = parse_fixed(fixed, h, fn);
+    // Los tamaños del header se comparan con el archivo antes de reservar nada.
+    std::uint64_t file_bytes = 0;
+    if (!file_size(f, file_bytes)) {
+        throw std::runtime_error(fn + ": no se pudo leer el tamaño del archivo");
+    }
+    if (h.data_offset > file_bytes || h.data_bytes > file_bytes - h.data_offset) {
+        throw std::runtime_error(fn + ": archivo truncado");
+    }
+    std::vector<unsigned char> rest(h.data_offset - io::HEADER_FIXED_BYTES);
+    if (std::fread(rest.data(), 1, rest.size(), f) != rest.size()) {
+        throw std::runtime_error(fn + ": archivo truncado");
+    }
+    parse_dims<T>(rest.data(), rank, h, fn);
+
+    // Buffer con todos los elementos del archivo; el resultado es una vista con sus strides.
+    BasicTensor<T> storage;
+    storage.prepare_out_or_throw(std::vector<std::size_t>(1, h.data_bytes / sizeof(T)), "Tensor::load");
+    if (std::fread(storage.data_, 1, h.data_bytes, f) != h.data_bytes) {
+        throw std::runtime_error(fn + ": archivo truncado");
+    }
+    if (io::checksum(storage.data_, h.data_bytes) != h.checksum) {
+        throw std::runtime_error(fn + ": checksum incorrecto");
+    }
+    return storage.share_with(h.shape, h.strides, 0);
+}
+
+//
+//CARGAR (mmap, sin copiar)
+//
+
+template <typename T>
+BasicTensor<T> BasicTensor<T>::mmap_load(const std::string& path, bool verify_checksum) {
+#if defined(_WIN32)
+    // Sin mmap: se lee a memoria propia (load siempre verifica el checksum).
+    (void)verify_checksum;
+    return load(path);
+#else
+    const std::string fn = "Tensor::mmap_load(" + path + ")";
+    FileCloser fd = {::open(path.c_str(), O_RDONLY)};
+    if (fd.fd < 0) {
+        throw std::runtime_error(fn + ": no se pudo abrir");
+    }
+    struct stat st;
+    if (::fstat(fd.fd, &st) != 0 || static_cast<std::uint64_t>(st.st_size) < io::HEADER_FIXED_BYTES) {
+        throw std::runtime_error(fn + ": archivo truncado");
+    }
+    const std::size_t file_bytes = static_cast<std::size_t>(st.st_size);
+
+    // Escribible a proposito: BasicTensor no tiene modo solo lectura y +=, apply_inplace o
+    // data() escriben en el storage; con PROT_READ eso seria un SIGSEGV en vez de un tensor
+    // normal. MAP_PRIVATE hace copy-on-write por pagina: el archivo no se modifica nunca y las
+    // paginas que no se escriben siguen compartidas con la cache del sistema.
+    void* base = ::mmap(nullptr, file_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd.fd, 0);
+    if (base == MAP_FAILED) {
+        throw std::runtime_error(fn + ": mmap fallo");
+    }
+    MmapDeleter del = {base, file_bytes};
+    const unsigned char* p = static_cast<const unsigned char*>(base);
+    Header h;
+    try {
+        const std::uint32_t rank = parse_fixed(p, h, fn);
+        if (h.data_offset > file_bytes || h.data_bytes > file_bytes - h.data_offset) {
+            throw std::runtime_error(fn + ": archivo truncado");
+        }
+        if (h.data_offset % alignof(T) != 0) {
+            throw std::runtime_error(fn + ": datos desalineados");
+        }
+        parse_dims<T>(p + io::HEADER_FIXED_BYTES, rank, h, fn);
+        if (verify_checksum && io::checksum(p + h.data_offset, h.data_bytes) != h.checksum) {
+            throw std::runtime_error(fn + ": checksum incorrecto");
+        }
+    } catch (...) {
+        del(nullptr);
+        throw;
+    }
+
+    T* data = reinterpret_cast<T*>(static_cast<unsigned char*>(base) + h.data_offset);
+    BasicTensor<T> storage;
+    storage.storage_ = std::shared_ptr<T>(data, del);
+    storage.data_ = data;
+    return storage.share_with(h.shape, h.strides, 0);
+#endif
+}
+
+//
+//INSTANCIACIONES
+//
+
+#define TENSOR_IO_INSTANTIATE(T) \
+    template void BasicTensor<T>::save(const std::string&) const; \
+    template BasicTensor<T> BasicTensor<T>::load(const std::string&); \
+    template BasicTensor<T> BasicTensor<T>::mmap_load(const std::string&, bool);
+
+TENSOR_IO_INSTANTIATE(float)
+TENSOR_IO_INSTANTIATE(double)
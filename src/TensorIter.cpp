@@ -0,0 +1,45 @@
+#include "../include/TensorIter.h"
+
+namespace iter {
+
+std::size_t Plan::rows() const {
+    std::size_t r = 1;
+    for (std::size_t d = 0; d + 1 < shape.size(); ++d) r *= shape[d];
+    return r;
+}
+
+Plan make_plan(const TensorShape& shape, std::size_t nops,
+               const TensorShape* const* shapes,
+               const TensorShape* const* strides) {
+    const std::size_t D = shape.size();
+
+    // Stride alineado a la derecha; 0 donde el operando no tiene la dimension o vale 1.
+    auto aligned = [&](std::size_t i, std::size_t d) -> std::size_t {
+        const std::size_t r = shapes[i]->size();
+        if (d + r < D) return 0;
+        const std::size_t k = d + r - D;
+        return ((*shapes[i])[k] == 1) ? 0 : (*strides[i])[k];
+    };
+
+    // Dimensiones que quedan (tamaño > 1), de fuera hacia dentro, fusionando cuando
+    // stride[fuera] == stride[dentro] * shape[dentro] para todos los operandos.
+    Plan plan;
+    plan.nops = nops;
+    if (nops > kPlanInlineOps) plan.extra_strides.resize(nops - kPlanInlineOps);
+    for (std::size_t d = 0; d < D; ++d) {
+        if (shape[d] == 1) continue;
+        bool merge = !plan.shape.empty();
+        for (std::size_t i = 0; i < nops && merge; ++i)
+            if (plan.strides(i).back() != aligned(i, d) * shape[d]) merge = false;
+        if (merge) {
+            plan.shape.back() *= shape[d];
+            for (std::size_t i = 0; i < nops; ++i) plan.strides(i).back() = aligned(i, d);
+        } else {
+            plan.shape.push_back(shape[d]);
+            for (std::size_t i = 0; i < nops; ++i) plan.strides(i).push_back(aligned(i, d));
+        }
+    }
+    return plan;
+}
+
+}
@@ -0,0 +1,210 @@
+#include "../include/TensorParallel.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstdlib>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace parallel {
+
+static thread_local bool tl_in_parallel = false;
+
+static std::size_t default_num_threads() {
+    if (const char* env = std::getenv("TENSOR_NUM_THREADS")) {
+        long v = std::strtol(env, nullptr, 10);
+        if (v > 0) return static_cast<std::size_t>(v);
+    }
+    unsigned hc = std::thread::hardware_concurrency();
+    return hc > 0 ? hc : 1;
+}
+
+//
+//POOL
+//
+
+class ThreadPool {
+public:
+    explicit ThreadPool(std::size_t n) : size_(n) {
+        for (std::size_t i = 1; i < n; ++i)
+            workers_.emplace_back([this] { worker_loop(); });
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lk(m_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        for (std::thread& t : workers_) t.join();
+    }
+
+    std::size_t size() const { return size_; }
+
+    // Devuelve false si el pool ya esta ocupado por otra llamada (el llamador ejecuta en serie).
+    bool run(std::size_t begin, std::size_t end, std::size_t chunk, std::size_t nchunks,
+             const std::function<void(std::size_t, std::size_t)>& fn) {
+        std::unique_lock<std::mutex> submit(submit_, std::try_to_lock);
+        if (!submit.owns_lock()) return false;
+
+        Job job;
+        {
+            std::lock_guard<std::mutex> lk(m_);
+            job_.fn = &fn;
+            job_.begin = begin;
+            job_.end = end;
+            job_.chunk = chunk;
+            job_.nchunks = nchunks;
+            job_.generation = ++generation_;
+            remaining_ = nchunks;
+            next_ = 0;
+            error_ = nullptr;
+            job = job_;
+        }
+        cv_.notify_all();
+
+        run_chunks(job);
+
+        std::exception_ptr err;
+        {
+            std::unique_lock<std::mutex> lk(m_);
+            done_cv_.wait(lk, [this] { return remaining_ == 0 && active_ == 0; });
+            job_.fn = nullptr;
+            err = error_;
+        }
+        if (err) std::rethrow_exception(err);
+        return true;
+    }
+
+private:
+    // Copia de la llamada en curso: un hilo que despierta tarde no lee los campos mientras
+    // run() escribe los de la siguiente.
+    struct Job {
+        const std::function<void(std::size_t, std::size_t)>* fn = nullptr;
+        std::size_t begin = 0, end = 0, chunk = 0, nchunks = 0;
+        unsigned long long generation = 0;
+    };
+
+    void worker_loop() {
+        unsigned long long seen = 0;
+        for (;;) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lk(m_);
+                cv_.wait(lk, [&] { return stop_ || generation_ != seen; });
+                if (stop_) return;
+                seen = generation_;
+                job = job_;
+                ++active_;
+            }
+            run_chunks(job);
+            {
+                std::lock_guard<std::mutex> lk(m_);
+                --active_;
+            }
+            done_cv_.notify_all();
+        }
+    }
+
+    // Los trozos se reparten bajo m_ y solo mientras siga la misma generacion; si run() ya
+    // termino (o empezo otra llamada) el hilo sale sin tocar fn.
+    void run_chunks(const Job& job) {
+        const bool was_parallel = tl_in_parallel;
+        tl_in_parallel = true;
+        for (;;) {
+            std::size_t c;
+            {
+                std::lock_guard<std::mutex> lk(m_);
+                if (generation_ != job.generation || next_ >= job.nchunks) break;
+                c = next_++;
+            }
+            const std::size_t b = job.begin + c * job.chunk;
+            const std::size_t e = std::min(job.end, b + job.chunk);
+            try {
+                (*job.fn)(b, e);
+            } catch (...) {
+                std::lock_guard<std::mutex> lk(m_);
+                if (!error_) error_ = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lk(m_);
+            if (--remaining_ == 0) done_cv_.notify_all();
+        }
+        tl_in_parallel = was_parallel;
+    }
+
+    std::size_t size_;
+    std::vector<std::thread> workers_;
+
+    std::mutex submit_;
+    std::mutex m_;
+    std::condition_variable cv_;
+    std::condition_variable done_cv_;
+
+    Job job_;
+    std::size_t next_ = 0;
+    std::size_t remaining_ = 0;
+    std::size_t active_ = 0;
+    unsigned long long generation_ = 0;
+    bool stop_ = false;
+    std::exception_ptr error_;
+};
+
+// shared_ptr: set_num_threads cambia el pool global, pero quien ya lo tomo en parallel_for
+// termina con el anterior, que se destruye al soltar la ultima referencia.
+static std::mutex pool_mutex;
+static std::shared_ptr<ThreadPool> pool;
+
+static std::shared_ptr<ThreadPool> get_pool() {
+    std::lock_guard<std::mutex> lk(pool_mutex);
+    if (!pool) pool = std::make_shared<ThreadPool>(default_num_threads());
+    return pool;
+}
+
+std::size_t num_threads() {
+    return get_pool()->size();
+}
+
+void set_num_threads(std::size_t n) {
+    if (n == 0) n = default_num_threads();
+    std::shared_ptr<ThreadPool> old;
+    {
+        std::lock_guard<std::mutex> lk(pool_mutex);
+        if (pool && pool->size() == n) return;
+        old = pool;
+        pool = std::make_shared<ThreadPool>(n);
+    }
+}
+
+bool in_parallel_region() {
+    return tl_in_parallel;
+}
+
+void parallel_for(std::size_t begin, std::size_t end, std::size_t grain,
+                  const std::function<void(std::size_t, std::size_t)>& fn) {
+    if (end <= begin) return;
+    const std::size_t len = end - begin;
+    if (grain == 0) grain = 1;
+    // Dentro de un trozo no se toma el pool: un worker nunca suelta su ultima referencia.
+    if (tl_in_parallel) {
+        fn(begin, end);
+        return;
+    }
+
+    const std::shared_ptr<ThreadPool> p = get_pool();
+    const std::size_t max_chunks = (len + grain - 1) / grain;
+    const std::size_t nchunks = std::min(p->size(), max_chunks);
+
+    if (nchunks <= 1) {
+        fn(begin, end);
+        return;
+    }
+
+    const std::size_t chunk = (len + nchunks - 1) / nchunks;
+    if (!p->run(begin, end, chunk, (len + chunk - 1) / chunk, fn)) {
+        fn(begin, end);
+    }
+}
+
+}
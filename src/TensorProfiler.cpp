@@ -0,0 +1,250 @@
+#include "../include/TensorProfiler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+
+namespace profiler {
+
+namespace {
+
+struct State {
+    std::mutex m;
+    std::vector<Event> events;
+    std::atomic<bool> enabled{true};
+    std::atomic<std::int64_t> epoch_ns{0};
+    std::atomic<unsigned> next_thread{0};
+};
+
+State& state() {
+    static State s;
+    return s;
+}
+
+std::int64_t clock_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Origen de tiempos: la primera llamada (o el ultimo reset).
+std::int64_t epoch() {
+    State& s = state();
+    std::int64_t e = s.epoch_ns.load(std::memory_order_relaxed);
+    if (e == 0) {
+        std::int64_t expected = 0;
+        const std::int64_t now = clock_ns();
+        e = s.epoch_ns.compare_exchange_strong(expected, now) ? now : expected;
+    }
+    return e;
+}
+
+thread_local Scope* tl_current = nullptr;
+thread_local unsigned tl_depth = 0;
+thread_local std::uint64_t tl_allocated = 0;
+thread_local int tl_thread = -1;
+
+unsigned thread_index() {
+    if (tl_thread < 0) tl_thread = static_cast<int>(state().next_thread.fetch_add(1));
+    return static_cast<unsigned>(tl_thread);
+}
+
+std::string format_shape(const std::vector<std::size_t>& shape) {
+    std::string s = "(";
+    for (std::size_t i = 0; i < shape.size(); ++i) {
+        if (i > 0) s += ", ";
+        s += std::to_string(shape[i]);
+    }
+    return s + ")";
+}
+
+void json_string(std::string& out, const std::string& s) {
+    out += '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char buf[8];
+            std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+            out += buf;
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+}
+
+bool compiled_in() {
+#ifdef TENSOR_PROFILE
+    return true;
+#else
+    return false;
+#endif
+}
+
+void set_enabled(bool on) {
+    state().enabled.store(on);
+}
+
+bool enabled() {
+    return state().enabled.load(std::memory_order_relaxed);
+}
+
+void reset() {
+    State& s = state();
+    std::lock_guard<std::mutex> lk(s.m);
+    s.events.clear();
+    s.epoch_ns.store(clock_ns());
+}
+
+std::vector<Event> events() {
+    State& s = state();
+    std::lock_guard<std::mutex> lk(s.m);
+    return s.events;
+}
+
+void record_allocation(std::size_t bytes) {
+    tl_allocated += bytes;
+}
+
+//
+//SCOPE
+//
+
+Scope::Scope(const char* name)
+    : name_(name), active_(enabled()), parent_(nullptr), start_ns_(0), child_ns_(0), bytes_(0), flops_(0) {
+    if (!active_) return;
+    parent_ = tl_current;
+    tl_current = this;
+    ++tl_depth;
+    bytes_ = static_cast<std::size_t>(tl_allocated);
+    const std::int64_t origin = epoch();
+    start_ns_ = static_cast<std::uint64_t>(clock_ns() - origin);
+}
+
+Scope::~Scope() {
+    if (!active_) return;
+    const std::int64_t origin = epoch();
+    const std::uint64_t end = static_cast<std::uint64_t>(clock_ns() - origin);
+    const std::uint64_t dur = end > start_ns_ ? end - start_ns_ : 0;
+    tl_current = parent_;
+    --tl_depth;
+    if (parent_ != nullptr) parent_->child_ns_ += dur;
+
+    Event e;
+    e.name = name_;
+    e.inputs = std::move(inputs_);
+    e.output = std::move(output_);
+    e.start_ns = start_ns_;
+    e.dur_ns = dur;
+    e.self_ns = dur > child_ns_ ? dur - child_ns_ : 0;
+    e.flops = flops_;
+    e.bytes = static_cast<std::size_t>(tl_allocated) - bytes_;
+    e.thread = thread_index();
+    e.depth = tl_depth;
+
+    State& s = state();
+    std::lock_guard<std::mutex> lk(s.m);
+    s.events.push_back(std::move(e));
+}
+
+void Scope::input(const std::vector<std::size_t>& shape) {
+    if (!active_) return;
+    if (!inputs_.empty()) inputs_ += ' ';
+    inputs_ += format_shape(shape);
+}
+
+void Scope::output(const std::vector<std::size_t>& shape) {
+    if (active_) output_ = format_shape(shape);
+}
+
+void Scope::flops(double n) {
+    flops_ = n;
+}
+
+//
+//RESUMEN Y EXPORTACION
+//
+
+std::vector<OpStats> summary() {
+    const std::vector<Event> evs = events();
+    std::map<std::string, OpStats> by_name;
+    for (const Event& e : evs) {
+        OpStats& st = by_name[e.name];
+        if (st.calls == 0) {
+            st.name = e.name;
+            st.min_ns = e.dur_ns;
+            st.max_ns = e.dur_ns;
+        }
+        ++st.calls;
+        st.total_ns += e.dur_ns;
+        st.self_ns += e.self_ns;
+        st.min_ns = std::min(st.min_ns, e.dur_ns);
+        st.max_ns = std::max(st.max_ns, e.dur_ns);
+        st.flops += e.flops;
+        st.bytes += e.bytes;
+    }
+    std::vector<OpStats> out;
+    for (const auto& kv : by_name) out.push_back(kv.second);
+    std::sort(out.begin(), out.end(), [](const OpStats& a, const OpStats& b) { return a.self_ns > b.self_ns; });
+    return out;
+}
+
+void print_summary(std::ostream& os) {
+    const std::vector<OpStats> stats = summary();
+    char line[256];
+    std::snprintf(line, sizeof(line), "%-28s %8s %12s %12s %12s %10s %12s\n",
+                  "op", "calls", "total(ms)", "self(ms)", "avg(us)", "GFLOP/s", "alloc(MB)");
+    os << line;
+    for (const OpStats& st : stats) {
+        const double gflops = st.total_ns > 0 ? st.flops / static_cast<double>(st.total_ns) : 0;
+        std::snprintf(line, sizeof(line), "%-28s %8zu %12.3f %12.3f %12.2f %10.2f %12.2f\n",
+                      st.name.c_str(), st.calls, st.total_ns / 1e6, st.self_ns / 1e6,
+                      st.total_ns / 1e3 / static_cast<double>(st.calls), gflops, st.bytes / 1048576.0);
+        os << line;
+    }
+}
+
+// Eventos completos ("ph": "X") con ts/dur en microsegundos.
+std::string chrome_trace_json() {
+    const std::vector<Event> evs = events();
+    std::string out = "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    char num[192];
+    for (std::size_t i = 0; i < evs.size(); ++i) {
+        const Event& e = evs[i];
+        out += "{\"name\": ";
+        json_string(out, e.name);
+        std::snprintf(num, sizeof(num), ", \"cat\": \"tensor\", \"ph\": \"X\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f",
+                      e.thread, e.start_ns / 1e3, e.dur_ns / 1e3);
+        out += num;
+        out += ", \"args\": {\"inputs\": ";
+        json_string(out, e.inputs);
+        out += ", \"output\": ";
+        json_string(out, e.output);
+        std::snprintf(num, sizeof(num), ", \"flops\": %.0f, \"bytes\": %zu, \"self_us\": %.3f}}",
+                      e.flops, e.bytes, e.self_ns / 1e3);
+        out += num;
+        out += i + 1 < evs.size() ? ",\n" : "\n";
+    }
+    out += "]}\n";
+    return out;
+}
+
+void write_chrome_trace(const std::string& path) {
+    std::ofstream f(path.c_str(), std::ios::binary);
+    if (!f) {
+        throw std::runtime_error("profiler::write_chrome_trace: no se pudo abrir " + path);
+    }
+    f << chrome_trace_json();
+    if (!f) {
+        throw std::runtime_error("profiler::write_chrome_trace: error al escribir " + path);
+    }
+}
+
+}
@@ -0,0 +1,669 @@
+#include "../include/TensorQuant.h"
+#include "../include/TensorGemm.h"
+#include "../include/TensorParallel.h"
+#include "../include/TensorProfiler.h"
+#include "../include/TensorTransform.h"
+#include "TensorSimd.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace quant {
+
+//
+//TAMAÑOS DEL MICRO-KERNEL
+//
+// MR filas x NR columnas (dos paneles de 8): 12 acumuladores int32 AVX2.
+static const std::size_t MR = 6;
+static const std::size_t NR = 16;
+static const std::size_t PANEL = 8;
+
+// Con |q| <= 128 cada producto es <= 2^14: 65536 terminos entran en un int32.
+static const std::size_t MAX_K = 65536;
+
+//
+//PARAMETROS DE CUANTIZACION
+//
+
+// Asimetrico: el rango se extiende hasta incluir el 0, para que 0.0 sea exacto (padding, ReLU).
+template <typename T>
+static void choose_params(T lo, T hi, bool symmetric, float& scale, std::int32_t& zero) {
+    if (!(lo <= hi)) lo = hi = T(0);
+    if (!std::isfinite(lo) || !std::isfinite(hi)) throw std::invalid_argument("quant: valores no finitos");
+    if (symmetric) {
+        const T amax = std::max(std::abs(lo), std::abs(hi));
+        scale = static_cast<float>(amax / T(127));
+        zero = 0;
+    } else {
+        lo = std::min(lo, T(0));
+        hi = std::max(hi, T(0));
+        scale = static_cast<float>((hi - lo) / T(255));
+        zero = 0;
+        if (scale > 0.0f) {
+            const T z = std::nearbyint(T(-128) - lo / T(scale));
+            zero = static_cast<std::int32_t>(std::min(std::max(z, T(-128)), T(127)));
+        }
+    }
+    if (!(scale > 0.0f)) scale = 1.0f;
+}
+
+// v tiene que estar dentro del rango con el que se eligio la escala (|v * inv_scale| <= 255),
+// asi la conversion a int32 no desborda y el recorte es entero (se vectoriza).
+template <typename T>
+static inline std::int32_t to_int8(T v, T inv_scale, std::int32_t zero, std::int32_t qmin) {
+    const std::int32_t q = static_cast<std::int32_t>(std::nearbyint(v * inv_scale)) + zero;
+    return std::min(std::max(q, qmin), std::int32_t(127));
+}
+
+// Minimo y maximo de n valores con stride (finitos).
+template <typename T>
+static void range_of(const T* x, std::size_t n, std::size_t stride, T& lo, T& hi) {
+    typedef typename simd::vec_of<T>::type V;
+    const std::size_t W = V::width;
+    lo = std::numeric_limits<T>::max();
+    hi = std::numeric_limits<T>::lowest();
+    std::size_t i = 0;
+    if (stride == 1 && n >= W) {
+        V vlo = simd::load(x, V()), vhi = vlo;
+        for (i = W; i + W <= n; i += W) {
+            const V v = simd::load(x + i, V());
+            vlo = simd::vmin(vlo, v);
+            vhi = simd::vmax(vhi, v);
+        }
+        T l[W], h[W];
+        simd::store(l, vlo);
+        simd::store(h, vhi);
+        for (std::size_t w = 0; w < W; ++w) {
+            lo = std::min(lo, l[w]);
+            hi = std::max(hi, h[w]);
+        }
+    }
+    for (; i < n; ++i) {
+        lo = std::min(lo, x[i * stride]);
+        hi = std::max(hi, x[i * stride]);
+    }
+}
+
+//
+//QTENSOR
+//
+
+QTensor::QTensor(std::size_t rows, std::size_t cols, Axis axis)
+    : axis_(axis), rows_(rows), cols_(cols), data_(rows * cols, 0) {
+    const std::size_t groups = axis == Axis::Row ? rows : (axis == Axis::Column ? cols : 1);
+    scales_.assign(groups, 1.0f);
+    zero_points_.assign(groups, 0);
+}
+
+std::int8_t QTensor::at(std::size_t i, std::size_t j) const {
+    if (i >= rows_ || j >= cols_) throw std::out_of_range("QTensor::at: index out of range");
+    return data_[i * cols_ + j];
+}
+
+std::size_t QTensor::bytes() const {
+    return data_.size() + scales_.size() * sizeof(float) + zero_points_.size() * sizeof(std::int32_t);
+}
+
+template <typename T>
+QTensor quantize(const BasicTensor<T>& x, Axis axis, bool symmetric) {
+    if (x.dims() != 2) throw std::invalid_argument("quant::quantize: x debe ser 2D");
+    const std::size_t rows = x.shape()[0], cols = x.shape()[1];
+    const std::size_t rs = x.strides()[0], cs = x.strides()[1];
+    const T* src = x.data();
+    TENSOR_PROFILE_SCOPE("quant::quantize");
+    TENSOR_PROFILE_INPUT(x.shape());
+    TENSOR_PROFILE_OUTPUT(x.shape());
+
+    QTensor q(rows, cols, axis);
+    const std::size_t groups = q.scales().size();
+    std::vector<T> lo(groups, std::numeric_limits<T>::max()), hi(groups, std::numeric_limits<T>::lowest());
+    for (std::size_t i = 0; i < rows; ++i) {
+        if (axis == Axis::Column) {
+            for (std::size_t j = 0; j < cols; ++j) {
+                lo[j] = std::min(lo[j], src[i * rs + j * cs]);
+                hi[j] = std::max(hi[j], src[i * rs + j * cs]);
+            }
+            continue;
+        }
+        T l, h;
+        range_of(src + i * rs, cols, cs, l, h);
+        const std::size_t g = q.group(i, 0);
+        lo[g] = std::min(lo[g], l);
+        hi[g] = std::max(hi[g], h);
+    }
+    std::vector<T> inv(groups);
+    for (std::size_t g = 0; g < groups; ++g) {
+        choose_params(lo[g], hi[g], symmetric, q.scales()[g], q.zero_points()[g]);
+        inv[g] = T(1) / T(q.scales()[g]);
+    }
+
+    const std::int32_t qmin = symmetric ? -127 : -128;
+    std::int8_t* dst = q.data();
+    const std::int32_t* zp = q.zero_points().data();
+    for (std::size_t i = 0; i < rows; ++i) {
+        const T* row = src + i * rs;
+        std::int8_t* out = dst + i * cols;
+        if (axis == Axis::Column) {
+            for (std::size_t j = 0; j < cols; ++j) out[j] = static_cast<std::int8_t>(to_int8(row[j * cs], inv[j], zp[j], qmin));
+            continue;
+        }
+        const std::size_t g = q.group(i, 0);
+        for (std::size_t j = 0; j < cols; ++j) out[j] = static_cast<std::int8_t>(to_int8(row[j * cs], inv[g], zp[g], qmin));
+    }
+    return q;
+}
+
+template <typename T>
+BasicTensor<T> dequantize(const QTensor& q) {
+    TENSOR_PROFILE_SCOPE("quant::dequantize");
+    TENSOR_PROFILE_OUTPUT(q.shape());
+    BasicTensor<T> r = BasicTensor<T>::zeros(q.shape());
+    T* dst = r.data();
+    const std::int8_t* src = q.data();
+    for (std::size_t i = 0; i < q.rows(); ++i) {
+        for (std::size_t j = 0; j < q.cols(); ++j) {
+            const std::size_t g = q.group(i, j);
+            dst[i * q.cols() + j] = T(q.scales()[g]) * T(std::int32_t(src[i * q.cols() + j]) - q.zero_points()[g]);
+        }
+    }
+    return r;
+}
+
+//
+//EMPAQUETADO
+//
+// B (k x n) queda en paneles de 8 columnas; dentro de un panel, por cada par de filas
+// (2p, 2p + 1), 16 bytes b[2p][j], b[2p + 1][j] para j = 0..7 (ceros fuera de rango).
+// Las filas de A se amplian a int16 por bloque de MR filas (2 * pairs valores por fila, el
+// ultimo en cero si k es impar): cada par consecutivo es un int32 para _mm256_madd_epi16.
+//
+
+static void pack_b(std::size_t k, std::size_t n, const std::int8_t* b, std::size_t ldb, std::int8_t* dst) {
+    const std::size_t pairs = (k + 1) / 2, panels = (n + PANEL - 1) / PANEL;
+    for (std::size_t pn = 0; pn < panels; ++pn) {
+        for (std::size_t p = 0; p < pairs; ++p) {
+            std::int8_t* out = dst + (pn * pairs + p) * 2 * PANEL;
+            for (std::size_t c = 0; c < PANEL; ++c) {
+                const std::size_t j = pn * PANEL + c;
+                for (std::size_t t = 0; t < 2; ++t) {
+                    const std::size_t row = 2 * p + t;
+                    out[2 * c + t] = row < k && j < n ? b[row * ldb + j] : std::int8_t(0);
+                }
+            }
+        }
+    }
+}
+
+// Un bloque de MR filas de A listo para el kernel (las filas de relleno quedan en cero).
+struct RowBlock {
+    std::int16_t* a;             // MR x (2 * pairs)
+    float scale[MR];
+    std::int32_t zero[MR];
+    std::int32_t sum[MR];        // suma de la fila en int8 (correccion del zero point de B)
+};
+
+// Filas int8 ya cuantizadas; scale/zero nulos: escala 1 y zero point 0.
+struct Int8Rows {
+    const std::int8_t* a;
+    std::size_t lda, k;
+    const float* scale;
+    const std::int32_t* zero;
+    bool per_row;
+
+    void pack(std::size_t i0, std::size_t mr, std::size_t pairs, RowBlock& rb) const {
+        for (std::size_t r = 0; r < mr; ++r) {
+            const std::int8_t* row = a + (i0 + r) * lda;
+            const std::size_t g = per_row ? i0 + r : 0;
+            rb.scale[r] = scale != nullptr ? scale[g] : 1.0f;
+            rb.zero[r] = zero != nullptr ? zero[g] : 0;
+            std::int16_t* dst = rb.a + r * 2 * pairs;
+            std::int32_t s = 0;
+            for (std::size_t j = 0; j < k; ++j) {
+                dst[j] = row[j];
+                s += row[j];
+            }
+            if (k < 2 * pairs) dst[k] = 0;
+            rb.sum[r] = s;
+        }
+    }
+};
+
+// Filas en punto flotante (con strides): cada fila se cuantiza al vuelo, asimetrica, con los
+// mismos parametros que quantize(x, Axis::Row).
+template <typename T>
+struct FloatRows {
+    const T* x;
+    std::size_t rs, cs, k;
+
+    void pack(std::size_t i0, std::size_t mr, std::size_t pairs, RowBlock& rb) const {
+        for (std::size_t r = 0; r < mr; ++r) {
+            const T* row = x + (i0 + r) * rs;
+            T lo, hi;
+            range_of(row, k, cs, lo, hi);
+            choose_params(lo, hi, false, rb.scale[r], rb.zero[r]);
+            const T inv = T(1) / T(rb.scale[r]);
+            const std::int32_t z = rb.zero[r];
+            std::int16_t* dst = rb.a + r * 2 * pairs;
+            std::int32_t s = 0;
+            if (cs == 1) {
+                for (std::size_t j = 0; j < k; ++j) {
+                    const std::int32_t q = to_int8(row[j], inv, z, -128);
+                    dst[j] = static_cast<std::int16_t>(q);
+                    s += q;
+                }
+            } else {
+                for (std::size_t j = 0; j < k; ++j) {
+                    const std::int32_t q = to_int8(row[j * cs], inv, z, -128);
+                    dst[j] = static_cast<std::int16_t>(q);
+                    s += q;
+                }
+            }
+            if (k < 2 * pairs) dst[k] = 0;
+            rb.sum[r] = s;
+        }
+    }
+};
+
+//
+//MICRO-KERNEL: c (MR x NR, int32) = A (MR filas) * paneles b0, b1
+//
+
+#if defined(__AVX2__)
+// Los dos int16 (a[0], a[1]) repetidos en las 8 posiciones de 32 bits.
+static inline __m256i broadcast_pair(const std::int16_t* a) {
+    std::int32_t pair;
+    std::memcpy(&pair, a, sizeof(pair));
+    return _mm256_set1_epi32(pair);
+}
+
+// c += a[2j] * b[2j] + a[2j + 1] * b[2j + 1] por columna j (int16 x int16 -> int32).
+static inline __m256i madd_add(__m256i a, __m256i b, __m256i c) {
+    return _mm256_add_epi32(c, _mm256_madd_epi16(a, b));
+}
+#endif
+
+static void kernel(std::size_t pairs, const std::int16_t* a, const std::int8_t* b0, const std::int8_t* b1,
+                   std::int32_t* c) {
+#if defined(__AVX2__)
+    __m256i c00 = _mm256_setzero_si256(), c01 = _mm256_setzero_si256();
+    __m256i c10 = _mm256_setzero_si256(), c11 = _mm256_setzero_si256();
+    __m256i c20 = _mm256_setzero_si256(), c21 = _mm256_setzero_si256();
+    __m256i c30 = _mm256_setzero_si256(), c31 = _mm256_setzero_si256();
+    __m256i c40 = _mm256_setzero_si256(), c41 = _mm256_setzero_si256();
+    __m256i c50 = _mm256_setzero_si256(), c51 = _mm256_setzero_si256();
+    const std::size_t lda = 2 * pairs;
+    for (std::size_t p = 0; p < pairs; ++p) {
+        const __m256i b0v = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b0 + 16 * p)));
+        const __m256i b1v = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b1 + 16 * p)));
+        const std::int16_t* pa = a + 2 * p;
+        __m256i va;
+        va = broadcast_pair(pa + 0 * lda); c00 = madd_add(va, b0v, c00); c01 = madd_add(va, b1v, c01);
+        va = broadcast_pair(pa + 1 * lda); c10 = madd_add(va, b0v, c10); c11 = madd_add(va, b1v, c11);
+        va = broadcast_pair(pa + 2 * lda); c20 = madd_add(va, b0v, c20); c21 = madd_add(va, b1v, c21);
+        va = broadcast_pair(pa + 3 * lda); c30 = madd_add(va, b0v, c30); c31 = madd_add(va, b1v, c31);
+        va = broadcast_pair(pa + 4 * lda); c40 = madd_add(va, b0v, c40); c41 = madd_add(va, b1v, c41);
+        va = broadcast_pair(pa + 5 * lda); c50 = madd_add(va, b0v, c50); c51 = madd_add(va, b1v, c51);
+    }
+    __m256i* out = reinterpret_cast<__m256i*>(c);
+    _mm256_storeu_si256(out + 0, c00); _mm256_storeu_si256(out + 1, c01);
+    _mm256_storeu_si256(out + 2, c10); _mm256_storeu_si256(out + 3, c11);
+    _mm256_storeu_si256(out + 4, c20); _mm256_storeu_si256(out + 5, c21);
+    _mm256_storeu_si256(out + 6, c30); _mm256_storeu_si256(out + 7, c31);
+    _mm256_storeu_si256(out + 8, c40); _mm256_storeu_si256(out + 9, c41);
+    _mm256_storeu_si256(out + 10, c50); _mm256_storeu_si256(out + 11, c51);
+#else
+    for (std::size_t r = 0; r < MR; ++r) {
+        std::int32_t acc[NR] = {0};
+        for (std::size_t p = 0; p < pairs; ++p) {
+            const std::int32_t lo = a[2 * (r * pairs + p)], hi = a[2 * (r * pairs + p) + 1];
+            for (std::size_t j = 0; j < PANEL; ++j) {
+                acc[j] += lo * b0[16 * p + 2 * j] + hi * b0[16 * p + 2 * j + 1];
+                acc[PANEL + j] += lo * b1[16 * p + 2 * j] + hi * b1[16 * p + 2 * j + 1];
+            }
+        }
+        std::copy(acc, acc + NR, c + r * NR);
+    }
+#endif
+}
+
+//
+//RECORRIDO
+//
+// Cada bloque de MR filas se empaqueta una vez y recorre todos los paneles de B (pensado para
+// pesos que entran en L2: W1 de main.cpp son 40 KB). sink.tile() recibe cada tile MR x NR
+// y sink.rows() se llama al terminar las filas del bloque. El Sink se copia por hilo.
+//
+
+struct PackedB {
+    std::size_t k, n, pairs, panels;
+    const std::int8_t* data;
+};
+
+template <typename Source, typename Sink>
+static void drive(std::size_t m, const PackedB& b, const Source& src, const Sink& sink) {
+    if (m == 0 || b.n == 0) return;
+    const std::size_t blocks = (m + MR - 1) / MR;
+    const std::size_t panel_bytes = b.pairs * 2 * PANEL;
+
+    auto work = [&](std::size_t blk0, std::size_t blk1) {
+        std::vector<std::int16_t> a(MR * 2 * b.pairs, 0);
+        RowBlock rb;
+        rb.a = a.data();
+        std::int32_t tile[MR * NR];
+        Sink s = sink;
+        for (std::size_t blk = blk0; blk < blk1; ++blk) {
+            const std::size_t i0 = blk * MR, mr = std::min(MR, m - i0);
+            if (mr < MR) std::fill(a.begin() + mr * 2 * b.pairs, a.end(), std::int16_t(0));
+            src.pack(i0, mr, b.pairs, rb);
+            for (std::size_t pn = 0; pn < b.panels; pn += 2) {
+                const std::int8_t* p0 = b.data + pn * panel_bytes;
+                const std::int8_t* p1 = pn + 1 < b.panels ? p0 + panel_bytes : p0;
+                kernel(b.pairs, a.data(), p0, p1, tile);
+                const std::size_t j0 = pn * PANEL;
+                s.tile(rb, i0, mr, j0, std::min(NR, b.n - j0), tile);
+            }
+            s.rows(i0, mr);
+        }
+    };
+
+    const std::size_t threads = parallel::in_parallel_region() ? 1 : parallel::num_threads();
+    if (threads <= 1 || m * b.n * b.k < gemm::parallel_threshold()) {
+        work(0, blocks);
+        return;
+    }
+    parallel::parallel_for(0, blocks, 1, work);
+}
+
+//
+//EPILOGOS
+//
+
+// Parametros por columna de B: real(i, j) = sa_i * sb_j * (acc - za_i * sum_b_j - zb_j * sum_a_i + k * za_i * zb_j).
+template <typename T>
+struct Columns {
+    const T* scale;
+    const std::int32_t* zero;    // nulo: todos 0
+    const std::int32_t* sum;
+    const T* bias;               // nulo: sin bias
+    std::int64_t k;
+
+    // |acc| y |za * sum_b| son <= 2^30 con k <= 65536: la resta entra en int32.
+    void dequantize(const RowBlock& rb, std::size_t r, std::size_t j0, std::size_t nr,
+                    const std::int32_t* acc, T* y) const {
+        const std::int32_t za = rb.zero[r];
+        const T sa = T(rb.scale[r]);
+        const T* s = scale + j0;
+        const std::int32_t* sb = sum + j0;
+        for (std::size_t c = 0; c < nr; ++c) y[c] = T(acc[c] - za * sb[c]) * (sa * s[c]);
+        if (zero != nullptr) {
+            const std::int64_t corr = k * za - rb.sum[r];
+            for (std::size_t c = 0; c < nr; ++c) y[c] += T(zero[j0 + c] * corr) * (sa * s[c]);
+        }
+        if (bias != nullptr) {
+            for (std::size_t c = 0; c < nr; ++c) y[c] += bias[j0 + c];
+        }
+    }
+};
+
+struct Int32Sink {
+    std::int32_t* c;
+    std::size_t ldc;
+
+    void tile(const RowBlock&, std::size_t i0, std::size_t mr, std::size_t j0, std::size_t nr,
+              const std::int32_t* acc) const {
+        for (std::size_t r = 0; r < mr; ++r) std::copy(acc + r * NR, acc + r * NR + nr, c + (i0 + r) * ldc + j0);
+    }
+    void rows(std::size_t, std::size_t) const {}
+};
+
+// Salida en punto flotante (m x n contigua); la activacion se aplica por bloque de filas.
+template <typename T>
+struct FloatSink {
+    Columns<T> col;
+    T* out;
+    std::size_t n;
+    const TensorTransform* act;
+
+    void tile(const RowBlock& rb, std::size_t i0, std::size_t mr, std::size_t j0, std::size_t nr,
+              const std::int32_t* acc) const {
+        for (std::size_t r = 0; r < mr; ++r) col.dequantize(rb, r, j0, nr, acc + r * NR, out + (i0 + r) * n + j0);
+    }
+    void rows(std::size_t i0, std::size_t mr) const {
+        if (act != nullptr) act->apply(out + i0 * n, out + i0 * n, mr * n);
+    }
+};
+
+// Salida int8 con escala y zero point por tensor: el bloque pasa por un buffer en punto
+// flotante para aplicar la activacion antes de recuantizar.
+template <typename T>
+struct QuantSink {
+    Columns<T> col;
+    std::int8_t* out;
+    std::size_t n;
+    const TensorTransform* act;
+    T inv_scale;
+    std::int32_t zero;
+    std::vector<T> buf;
+
+    void tile(const RowBlock& rb, std::size_t, std::size_t mr, std::size_t j0, std::size_t nr,
+              const std::int32_t* acc) {
+        if (buf.size() < MR * n) buf.resize(MR * n);
+        for (std::size_t r = 0; r < mr; ++r) col.dequantize(rb, r, j0, nr, acc + r * NR, buf.data() + r * n + j0);
+    }
+    void rows(std::size_t i0, std::size_t mr) {
+        if (act != nullptr) act->apply(buf.data(), buf.data(), mr * n);
+        std::int8_t* dst = out + i0 * n;
+        for (std::size_t e = 0; e < mr * n; ++e) {
+            const T v = std::min(std::max(buf[e] * inv_scale, T(-256)), T(256));
+            dst[e] = static_cast<std::int8_t>(to_int8(v, T(1), zero, -128));
+        }
+    }
+};
+
+//
+//GEMM INT8 SIN PARAMETROS
+//
+
+void gemm_s8(std::size_t m, std::size_t n, std::size_t k,
+             const std::int8_t* a, std::size_t lda,
+             const std::int8_t* b, std::size_t ldb,
+             std::int32_t* c, std::size_t ldc) {
+    if (k > MAX_K) throw std::invalid_argument("quant::gemm_s8: k > 65536 desborda el acumulador int32");
+    TENSOR_PROFILE_SCOPE("quant::gemm_s8");
+    TENSOR_PROFILE_FLOPS(2.0 * m * n * k);
+    PackedB pb;
+    pb.k = k;
+    pb.n = n;
+    pb.pairs = (k + 1) / 2;
+    pb.panels = (n + PANEL - 1) / PANEL;
+    std::vector<std::int8_t> packed(pb.panels * pb.pairs * 2 * PANEL);
+    pack_b(k, n, b, ldb, packed.data());
+    pb.data = packed.data();
+
+    Int8Rows src = {a, lda, k, nullptr, nullptr, false};
+    Int32Sink sink = {c, ldc};
+    drive(m, pb, src, sink);
+}
+
+//
+//QLINEAR
+//
+
+template <typename T>
+QLinear<T>::QLinear(const BasicTensor<T>& w, const BasicTensor<T>& b, const TensorTransform* act) : act_(act) {
+    if (w.dims() != 2) throw std::invalid_argument("quant::QLinear: W debe ser 2D");
+    init(quantize(w, Axis::Column, true), &b);
+}
+
+template <typename T>
+QLinear<T>::QLinear(const QTensor& w, const TensorTransform* act) : act_(act) {
+    init(w, nullptr);
+}
+
+template <typename T>
+QLinear<T>::QLinear(const QTensor& w, const BasicTensor<T>& b, const TensorTransform* act) : act_(act) {
+    init(w, &b);
+}
+
+template <typename T>
+void QLinear<T>::init(const QTensor& w, const BasicTensor<T>* b) {
+    if (w.axis() == Axis::Row) {
+        throw std::invalid_argument("quant::QLinear: W tiene que estar cuantizado por columna o por tensor");
+    }
+    k_ = w.rows();
+    n_ = w.cols();
+    if (k_ > MAX_K) throw std::invalid_argument("quant::QLinear: k > 65536 desborda el acumulador int32");
+    pairs_ = (k_ + 1) / 2;
+    panels_ = (n_ + PANEL - 1) / PANEL;
+    packed_.assign(panels_ * pairs_ * 2 * PANEL, 0);
+    pack_b(k_, n_, w.data(), n_, packed_.data());
+
+    col_scale_.resize(n_);
+    col_sum_.assign(n_, 0);
+    col_zero_.clear();
+    bool any_zero = false;
+    for (std::size_t j = 0; j < n_; ++j) {
+        col_scale_[j] = T(w.scales()[w.group(0, j)]);
+        any_zero = any_zero || w.zero_points()[w.group(0, j)] != 0;
+    }
+    if (any_zero) {
+        col_zero_.resize(n_);
+        for (std::size_t j = 0; j < n_; ++j) col_zero_[j] = w.zero_points()[w.group(0, j)];
+    }
+    for (std::size_t i = 0; i < k_; ++i) {
+        for (std::size_t j = 0; j < n_; ++j) col_sum_[j] += w.data()[i * n_ + j];
+    }
+
+    bias_.clear();
+    if (b != nullptr) {
+        const bool bias_1d = b->dims() == 1 && b->shape()[0] == n_;
+        const bool bias_row = b->dims() == 2 && b->shape()[0] == 1 && b->shape()[1] == n_;
+        if (!bias_1d && !bias_row) {
+            throw std::invalid_argument("quant::QLinear: bias debe tener shape (n) o (1 x n)");
+        }
+        const std::size_t stride = bias_1d ? b->strides()[0] : b->strides()[1];
+        bias_.resize(n_);
+        for (std::size_t j = 0; j < n_; ++j) bias_[j] = b->data()[j * stride];
+    }
+}
+
+template <typename T>
+std::size_t QLinear<T>::weight_bytes() const {
+    return packed_.size() + col_scale_.size() * sizeof(T) + (col_zero_.size() + col_sum_.size()) * sizeof(std::int32_t) +
+           bias_.size() * sizeof(T);
+}
+
+template <typename T>
+BasicTensor<T> QLinear<T>::forward(const BasicTensor<T>& x) const {
+    BasicTensor<T> out;
+    forward(x, out);
+    return out;
+}
+
+template <typename T>
+BasicTensor<T>& QLinear<T>::forward(const BasicTensor<T>& x, BasicTensor<T>& out) const {
+    if (x.dims() != 2 || x.shape()[1] != k_) {
+        throw std::invalid_argument("quant::QLinear::forward: x debe ser (m x in_features)");
+    }
+    if (out.shares_storage(x)) throw std::invalid_argument("quant::QLinear::forward: out no puede ser x");
+    const std::size_t m = x.shape()[0];
+    const TensorShape out_shape{m, n_};
+    TENSOR_PROFILE_SCOPE("quant::linear");
+    TENSOR_PROFILE_INPUT(x.shape());
+    TENSOR_PROFILE_OUTPUT(out_shape);
+    TENSOR_PROFILE_FLOPS(2.0 * m * n_ * k_);
+    out.prepare_out_or_throw(out_shape, "quant::QLinear::forward");
+
+    const PackedB pb = {k_, n_, pairs_, panels_, packed_.data()};
+    const FloatRows<T> src = {x.data(), x.strides()[0], x.strides()[1], k_};
+    const Columns<T> col = {col_scale_.data(), col_zero_.empty() ? nullptr : col_zero_.data(), col_sum_.data(),
+                            bias_.empty() ? nullptr : bias_.data(), std::int64_t(k_)};
+    const FloatSink<T> sink = {col, out.data_, n_, act_};
+    drive(m, pb, src, sink);
+    return out;
+}
+
+template <typename T>
+BasicTensor<T>& QLinear<T>::forward(const QTensor& x, BasicTensor<T>& out) const {
+    if (x.cols() != k_) throw std::invalid_argument("quant::QLinear::forward: x debe ser (m x in_features)");
+    if (x.axis() == Axis::Column) {
+        throw std::invalid_argument("quant::QLinear::forward: x tiene que estar cuantizado por fila o por tensor");
+    }
+    const std::size_t m = x.rows();
+    const TensorShape out_shape{m, n_};
+    TENSOR_PROFILE_SCOPE("quant::linear");
+    TENSOR_PROFILE_INPUT(x.shape());
+    TENSOR_PROFILE_OUTPUT(out_shape);
+    TENSOR_PROFILE_FLOPS(2.0 * m * n_ * k_);
+    out.prepare_out_or_throw(out_shape, "quant::QLinear::forward");
+
+    const PackedB pb = {k_, n_, pairs_, panels_, packed_.data()};
+    const Int8Rows src = {x.data(), k_, k_, x.scales().data(), x.zero_points().data(), x.axis() == Axis::Row};
+    const Columns<T> col = {col_scale_.data(), col_zero_.empty() ? nullptr : col_zero_.data(), col_sum_.data(),
+                            bias_.empty() ? nullptr : bias_.data(), std::int64_t(k_)};
+    const FloatSink<T> sink = {col, out.data_, n_, act_};
+    drive(m, pb, src, sink);
+    return out;
+}
+
+template <typename T>
+QTensor QLinear<T>::forward_quantized(const QTensor& x, float out_scale, std::int32_t out_zero) const {
+    if (x.cols() != k_) throw std::invalid_argument("quant::QLinear::forward_quantized: x debe ser (m x in_features)");
+    if (x.axis() == Axis::Column) {
+        throw std::invalid_argument("quant::QLinear::forward_quantized: x tiene que estar cuantizado por fila o por tensor");
+    }
+    if (!(out_scale > 0.0f) || out_zero < -128 || out_zero > 127) {
+        throw std::invalid_argument("quant::QLinear::forward_quantized: escala o zero point de salida invalidos");
+    }
+    const std::size_t m = x.rows();
+    QTensor q(m, n_, Axis::Tensor);
+    q.scales()[0] = out_scale;
+    q.zero_points()[0] = out_zero;
+    TENSOR_PROFILE_SCOPE("quant::linear_quantized");
+    TENSOR_PROFILE_INPUT(x.shape());
+    TENSOR_PROFILE_OUTPUT(q.shape());
+    TENSOR_PROFILE_FLOPS(2.0 * m * n_ * k_);
+
+    const PackedB pb = {k_, n_, pairs_, panels_, packed_.data()};
+    const Int8Rows src = {x.data(), k_, k_, x.scales().data(), x.zero_points().data(), x.axis() == Axis::Row};
+    const Columns<T> col = {col_scale_.data(), col_zero_.empty() ? nullptr : col_zero_.data(), col_sum_.data(),
+                            bias_.empty() ? nullptr : bias_.data(), std::int64_t(k_)};
+    const QuantSink<T> sink = {col, q.data(), n_, act_, T(1) / T(out_scale), out_zero, std::vector<T>()};
+    drive(m, pb, src, sink);
+    return q;
+}
+
+template <typename T>
+BasicTensor<T> matmul(const QTensor& a, const QTensor& b) {
+    if (a.cols() != b.rows()) {
+        throw std::invalid_argument("quant::matmul: shapes incompatibles (a.cols debe ser = b.rows)");
+    }
+    if (b.axis() == Axis::Row) {
+        throw std::invalid_argument("quant::matmul: b tiene que estar cuantizado por columna o por tensor");
+    }
+    BasicTensor<T> out;
+    QLinear<T>(b).forward(a, out);
+    return out;
+}
+
+//
+//INSTANCIACIONES
+//
+
+template QTensor quantize<float>(const BasicTensor<float>& x, Axis axis, bool symmetric);
+template QTensor quantize<double>(const BasicTensor<double>& x, Axis axis, bool symmetric);
+template BasicTensor<float>  dequantize<float>(const QTensor& q);
+template BasicTensor<double> dequantize<double>(const QTensor& q);
+template class QLinear<float>;
+template class QLinear<double>;
+template BasicTensor<float>  matmul<float>(const QTensor& a, const QTensor& b);
+template BasicTensor<double> matmul<double>(const QTensor& a, const QTensor& b);
+
+}
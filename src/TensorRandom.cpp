@@ -0,0 +1,234 @@
+#include "../include/TensorRandom.h"
+#include "../include/TensorParallel.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+const std::uint32_t PHILOX_M0 = 0xD2511F53u;
+const std::uint32_t PHILOX_M1 = 0xCD9E8D57u;
+const std::uint32_t PHILOX_W0 = 0x9E3779B9u;
+const std::uint32_t PHILOX_W1 = 0xBB67AE85u;
+
+// Bloques que se generan juntos (una lane de 32 bits por bloque en AVX2).
+const std::size_t BATCH = 8;
+// Lotes por tarea del llenado en paralelo y tamaño minimo para usar hilos.
+const std::size_t FILL_BATCHES = 512;
+const std::size_t PARALLEL_MIN_ELEMS = std::size_t(1) << 16;
+
+inline void mulhilo(std::uint32_t a, std::uint32_t b, std::uint32_t& hi, std::uint32_t& lo) {
+    const std::uint64_t p = static_cast<std::uint64_t>(a) * b;
+    hi = static_cast<std::uint32_t>(p >> 32);
+    lo = static_cast<std::uint32_t>(p);
+}
+
+#if defined(__AVX2__) && defined(__FMA__)
+
+// mul_epu32 solo multiplica las lanes pares: las impares se desplazan y se vuelven a mezclar.
+inline void mulhilo8(__m256i a, __m256i m, __m256i& hi, __m256i& lo) {
+    const __m256i pe = _mm256_mul_epu32(a, m);
+    const __m256i po = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), m);
+    lo = _mm256_blend_epi32(pe, _mm256_slli_epi64(po, 32), 0xAA);
+    hi = _mm256_blend_epi32(_mm256_srli_epi64(pe, 32), po, 0xAA);
+}
+
+// w[k][l] = palabra k del bloque counter + l.
+void philox_batch(std::uint64_t key, std::uint64_t counter, std::uint64_t stream,
+                  std::uint32_t w[4][BATCH]) {
+    alignas(32) std::uint32_t lo[BATCH], hi[BATCH];
+    for (std::size_t l = 0; l < BATCH; ++l) {
+        lo[l] = static_cast<std::uint32_t>(counter + l);
+        hi[l] = static_cast<std::uint32_t>((counter + l) >> 32);
+    }
+    __m256i c0 = _mm256_load_si256(reinterpret_cast<const __m256i*>(lo));
+    __m256i c1 = _mm256_load_si256(reinterpret_cast<const __m256i*>(hi));
+    __m256i c2 = _mm256_set1_epi32(static_cast<int>(static_cast<std::uint32_t>(stream)));
+    __m256i c3 = _mm256_set1_epi32(static_cast<int>(static_cast<std::uint32_t>(stream >> 32)));
+    const __m256i m0 = _mm256_set1_epi32(static_cast<int>(PHILOX_M0));
+    const __m256i m1 = _mm256_set1_epi32(static_cast<int>(PHILOX_M1));
+    std::uint32_t k0 = static_cast<std::uint32_t>(key), k1 = static_cast<std::uint32_t>(key >> 32);
+    for (int r = 0; r < 10; ++r) {
+        __m256i hi0, lo0, hi1, lo1;
+        mulhilo8(c0, m0, hi0, lo0);
+        mulhilo8(c2, m1, hi1, lo1);
+        c0 = _mm256_xor_si256(_mm256_xor_si256(hi1, c1), _mm256_set1_epi32(static_cast<int>(k0)));
+        c1 = lo1;
+        c2 = _mm256_xor_si256(_mm256_xor_si256(hi0, c3), _mm256_set1_epi32(static_cast<int>(k1)));
+        c3 = lo0;
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(w[0]), c0);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(w[1]), c1);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(w[2]), c2);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(w[3]), c3);
+}
+
+#else
+
+void philox_batch(std::uint64_t key, std::uint64_t counter, std::uint64_t stream,
+                  std::uint32_t w[4][BATCH]) {
+    for (std::size_t l = 0; l < BATCH; ++l) {
+        std::uint32_t out[4];
+        rng::philox4x32(key, counter + l, stream, out);
+        for (int k = 0; k < 4; ++k) w[k][l] = out[k];
+    }
+}
+
+#endif
+
+// Uniformes en [0, 1) a partir de un lote: se arma el numero en [1, 2) con los bits altos
+// como mantisa y se le resta 1 (sin conversiones de entero a flotante).
+template <typename T> struct Bits;
+
+template <> struct Bits<double> {
+    // Un double por cada 2 palabras: 52 bits de mantisa.
+    static const std::size_t per_block = 2;
+    static void uniform(const std::uint32_t w[4][BATCH], double* u) {
+        for (std::size_t l = 0; l < BATCH; ++l) {
+            for (std::size_t h = 0; h < 2; ++h) {
+                const std::uint64_t v = (static_cast<std::uint64_t>(w[2 * h][l]) << 32) | w[2 * h + 1][l];
+                const std::uint64_t bits = (std::uint64_t(0x3FF) << 52) | (v >> 12);
+                double d;
+                std::memcpy(&d, &bits, sizeof(d));
+                u[2 * l + h] = d - 1.0;
+            }
+        }
+    }
+};
+
+template <> struct Bits<float> {
+    // Un float por palabra: 23 bits de mantisa.
+    static const std::size_t per_block = 4;
+    static void uniform(const std::uint32_t w[4][BATCH], float* u) {
+        for (std::size_t l = 0; l < BATCH; ++l) {
+            for (std::size_t k = 0; k < 4; ++k) {
+                const std::uint32_t bits = (std::uint32_t(0x7F) << 23) | (w[k][l] >> 9);
+                float f;
+                std::memcpy(&f, &bits, sizeof(f));
+                u[4 * l + k] = f - 1.0f;
+            }
+        }
+    }
+};
+
+// El elemento i usa el bloque first + i / per_block. fill(i, u, count) escribe count elementos
+// a partir de i con los uniformes u (count es par salvo en el ultimo lote).
+template <typename T, typename F>
+void fill_batches(std::uint64_t seed, std::uint64_t stream, std::uint64_t first,
+                  std::size_t n, F fill) {
+    const std::size_t per_batch = Bits<T>::per_block * BATCH;
+    const std::size_t batches = (n + per_batch - 1) / per_batch;
+    auto body = [&](std::size_t b0, std::size_t b1) {
+        std::uint32_t w[4][BATCH];
+        T u[Bits<T>::per_block * BATCH];
+        for (std::size_t b = b0; b < b1; ++b) {
+            philox_batch(seed, first + b * BATCH, stream, w);
+            Bits<T>::uniform(w, u);
+            fill(b * per_batch, u, std::min(per_batch, n - b * per_batch));
+        }
+    };
+    if (n >= PARALLEL_MIN_ELEMS && !parallel::in_parallel_region()) {
+        parallel::parallel_for(0, batches, FILL_BATCHES, body);
+    } else {
+        body(0, batches);
+    }
+}
+
+}
+
+namespace rng {
+
+void philox4x32(std::uint64_t key, std::uint64_t counter, std::uint64_t stream, std::uint32_t out[4]) {
+    std::uint32_t c0 = static_cast<std::uint32_t>(counter), c1 = static_cast<std::uint32_t>(counter >> 32);
+    std::uint32_t c2 = static_cast<std::uint32_t>(stream), c3 = static_cast<std::uint32_t>(stream >> 32);
+    std::uint32_t k0 = static_cast<std::uint32_t>(key), k1 = static_cast<std::uint32_t>(key >> 32);
+    for (int r = 0; r < 10; ++r) {
+        std::uint32_t hi0, lo0, hi1, lo1;
+        mulhilo(PHILOX_M0, c0, hi0, lo0);
+        mulhilo(PHILOX_M1, c2, hi1, lo1);
+        c0 = hi1 ^ c1 ^ k0;
+        c1 = lo1;
+        c2 = hi0 ^ c3 ^ k1;
+        c3 = lo0;
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+}
+
+Generator::Generator(std::uint64_t seed, std::uint64_t stream)
+    : seed_(seed), stream_(stream), offset_(0) {}
+
+Generator::Generator(const Generator& other)
+    : seed_(other.seed_), stream_(other.stream_), offset_(other.offset_.load()) {}
+
+Generator& Generator::operator=(const Generator& other) {
+    seed_ = other.seed_;
+    stream_ = other.stream_;
+    offset_.store(other.offset_.load());
+    return *this;
+}
+
+void Generator::manual_seed(std::uint64_t seed, std::uint64_t stream) {
+    seed_ = seed;
+    stream_ = stream;
+    offset_.store(0);
+}
+
+// Reserva los bloques de n elementos: el resto del ultimo lote no se consume.
+template <typename T>
+void Generator::uniform(T* out, std::size_t n, T lo, T hi) {
+    const std::size_t per = Bits<T>::per_block;
+    const std::uint64_t first = offset_.fetch_add((n + per - 1) / per);
+    const T range = hi - lo;
+    // u < 1, pero lo + range * u puede redondear a hi (p. ej. float en [1000, 1001)): se
+    // reemplaza por el mayor valor < hi para que el intervalo siga abierto.
+    const T top = std::nextafter(hi, lo);
+    fill_batches<T>(seed_, stream_, first, n, [=](std::size_t i, const T* u, std::size_t count) {
+        for (std::size_t j = 0; j < count; ++j) {
+            const T v = lo + range * u[j];
+            out[i + j] = v < hi ? v : top;
+        }
+    });
+}
+
+template <typename T>
+void Generator::normal(T* out, std::size_t n, T mean, T stddev) {
+    const std::size_t per = Bits<T>::per_block;
+    const std::uint64_t first = offset_.fetch_add((n + per - 1) / per);
+    const T two_pi = static_cast<T>(6.283185307179586476925);
+    fill_batches<T>(seed_, stream_, first, n, [=](std::size_t i, const T* u, std::size_t count) {
+        // Box-Muller: (u[j], u[j + 1]) -> dos normales independientes; 1 - u evita log(0).
+        for (std::size_t j = 0; j < count; j += 2) {
+            const T r = stddev * std::sqrt(T(-2) * std::log(T(1) - u[j]));
+            const T t = two_pi * u[j + 1];
+            out[i + j] = mean + r * std::cos(t);
+            if (j + 1 < count) out[i + j + 1] = mean + r * std::sin(t);
+        }
+    });
+}
+
+Generator& default_generator() {
+    static Generator gen;
+    return gen;
+}
+
+void manual_seed(std::uint64_t seed) {
+    default_generator().manual_seed(seed);
+}
+
+template void Generator::uniform(float* out, std::size_t n, float lo, float hi);
+template void Generator::uniform(double* out, std::size_t n, double lo, double hi);
+template void Generator::normal(float* out, std::size_t n, float mean, float stddev);
+template void Generator::normal(double* out, std::size_t n, double mean, double stddev);
+
+}
@@ -0,0 +1,373 @@
+#include "../include/Tensor.h"
+#include "../include/TensorParallel.h"
+#include "../include/TensorProfiler.h"
+#include "TensorSimd.h"
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+//
+//REDUCCIONES
+//
+// El tensor se ve como (outer, len, inner) respecto a la dimension reducida.
+// - inner == 1 (eje contiguo): cada fila se parte en trozos de CHUNK elementos que se reducen
+//   con SIMD; la suma de un trozo es pairwise (error O(log n) en vez de O(n)). Los parciales
+//   se combinan tambien en arbol y siempre en el mismo orden, asi que el resultado no depende
+//   de la cantidad de hilos.
+// - inner > 1: se reducen columnas contiguas de hasta COL_BLOCK elementos a la vez; la suma
+//   acumula bloques de BLOCK_ROWS filas por separado antes de sumarlos al total.
+// Las tareas (filas x trozos o filas x bloques de columnas) se reparten en el pool de hilos.
+//
+
+namespace {
+
+const std::size_t CHUNK = std::size_t(1) << 14;
+const std::size_t PAIRWISE_BASE = 256;
+const std::size_t COL_BLOCK = 256;
+const std::size_t BLOCK_ROWS = 128;
+const std::size_t PARALLEL_MIN_ELEMS = std::size_t(1) << 15;
+
+template <typename V>
+typename V::scalar lane_max(V v) {
+    typename V::scalar t[V::width];
+    simd::store(t, v);
+    return *std::max_element(t, t + V::width);
+}
+
+template <typename V>
+typename V::scalar lane_min(V v) {
+    typename V::scalar t[V::width];
+    simd::store(t, v);
+    return *std::min_element(t, t + V::width);
+}
+
+//
+//KERNELS SOBRE MEMORIA CONTIGUA
+//
+
+template <typename T>
+T sum_contiguous(const T* x, std::size_t n) {
+    typedef typename simd::vec_of<T>::type V;
+    const std::size_t W = V::width;
+    if (n > PAIRWISE_BASE) {
+        const std::size_t half = (n / 2 + W - 1) / W * W;
+        return sum_contiguous(x, half) + sum_contiguous(x + half, n - half);
+    }
+    V a0 = simd::set1(0.0, V()), a1 = a0, a2 = a0, a3 = a0;
+    std::size_t i = 0;
+    for (; i + 4 * W <= n; i += 4 * W) {
+        a0 = a0 + simd::load(x + i, V());
+        a1 = a1 + simd::load(x + i + W, V());
+        a2 = a2 + simd::load(x + i + 2 * W, V());
+        a3 = a3 + simd::load(x + i + 3 * W, V());
+    }
+    T r = simd::hsum((a0 + a1) + (a2 + a3));
+    for (; i < n; ++i) r += x[i];
+    return r;
+}
+
+template <typename T, bool IsMax>
+T extreme_contiguous(const T* x, std::size_t n) {
+    typedef typename simd::vec_of<T>::type V;
+    const std::size_t W = V::width;
+    std::size_t i = 0;
+    T r = x[0];
+    if (n >= 2 * W) {
+        V a0 = simd::load(x, V()), a1 = simd::load(x + W, V());
+        for (i = 2 * W; i + 2 * W <= n; i += 2 * W) {
+            if (IsMax) {
+                a0 = simd::vmax(a0, simd::load(x + i, V()));
+                a1 = simd::vmax(a1, simd::load(x + i + W, V()));
+            } else {
+                a0 = simd::vmin(a0, simd::load(x + i, V()));
+                a1 = simd::vmin(a1, simd::load(x + i + W, V()));
+            }
+        }
+        r = IsMax ? lane_max(simd::vmax(a0, a1)) : lane_min(simd::vmin(a0, a1));
+    }
+    for (; i < n; ++i) r = IsMax ? (x[i] > r ? x[i] : r) : (x[i] < r ? x[i] : r);
+    return r;
+}
+
+//
+//OPERACIONES
+//
+// acc: parcial de un trozo. segment(x, n, base) reduce x[0..n) (base = posicion del trozo en
+// la fila), combine une dos parciales consecutivos y finish produce el valor de salida.
+// columns(x, len, stride, ncols, out) reduce len filas de ncols columnas contiguas.
+//
+
+template <typename T>
+struct SumOp {
+    typedef T acc;
+    static acc segment(const T* x, std::size_t n, std::size_t) { return sum_contiguous(x, n); }
+    static acc combine(acc a, acc b) { return a + b; }
+    static T finish(acc a, std::size_t) { return a; }
+
+    static void columns(const T* x, std::size_t len, std::size_t stride, std::size_t ncols, T* out) {
+        T block[COL_BLOCK];
+        std::fill(out, out + ncols, T(0));
+        for (std::size_t k0 = 0; k0 < len; k0 += BLOCK_ROWS) {
+            const std::size_t k1 = std::min(len, k0 + BLOCK_ROWS);
+            std::fill(block, block + ncols, T(0));
+            for (std::size_t k = k0; k < k1; ++k) {
+                const T* row = x + k * stride;
+                for (std::size_t j = 0; j < ncols; ++j) block[j] += row[j];
+            }
+            for (std::size_t j = 0; j < ncols; ++j) out[j] += block[j];
+        }
+    }
+};
+
+template <typename T>
+struct MeanOp : SumOp<T> {
+    static T finish(T a, std::size_t len) { return a / static_cast<T>(len); }
+
+    static void columns(const T* x, std::size_t len, std::size_t stride, std::size_t ncols, T* out) {
+        SumOp<T>::columns(x, len, stride, ncols, out);
+        const T inv = T(1) / static_cast<T>(len);
+        for (std::size_t j = 0; j < ncols; ++j) out[j] *= inv;
+    }
+};
+
+template <typename T, bool IsMax>
+struct ExtremeOp {
+    typedef T acc;
+    static acc segment(const T* x, std::size_t n, std::size_t) { return extreme_contiguous<T, IsMax>(x, n); }
+    static acc combine(acc a, acc b) { return IsMax ? (b > a ? b : a) : (b < a ? b : a); }
+    static T finish(acc a, std::size_t) { return a; }
+
+    static void columns(const T* x, std::size_t len, std::size_t stride, std::size_t ncols, T* out) {
+        std::copy(x, x + ncols, out);
+        for (std::size_t k = 1; k < len; ++k) {
+            const T* row = x + k * stride;
+            for (std::size_t j = 0; j < ncols; ++j)
+                out[j] = IsMax ? (row[j] > out[j] ? row[j] : out[j]) : (row[j] < out[j] ? row[j] : out[j]);
+        }
+    }
+};
+
+// Primero el maximo (vectorizado) y despues la primera posicion que lo alcanza.
+template <typename T>
+struct ArgMaxOp {
+    typedef std::pair<T, std::size_t> acc;
+    static acc segment(const T* x, std::size_t n, std::size_t base) {
+        const T m = extreme_contiguous<T, true>(x, n);
+        std::size_t i = 0;
+        while (i + 1 < n && !(x[i] == m)) ++i;
+        return acc(m, base + i);
+    }
+    static acc combine(acc a, acc b) { return (b.first > a.first) ? b : a; }
+    static T finish(acc a, std::size_t) { return static_cast<T>(a.second); }
+
+    static void columns(const T* x, std::size_t len, std::size_t stride, std::size_t ncols, T* out) {
+        T best[COL_BLOCK];
+        std::copy(x, x + ncols, best);
+        std::fill(out, out + ncols, T(0));
+        for (std::size_t k = 1; k < len; ++k) {
+            const T* row = x + k * stride;
+            const T kk = static_cast<T>(k);
+            for (std::size_t j = 0; j < ncols; ++j) {
+                const bool better = row[j] > best[j];
+                best[j] = better ? row[j] : best[j];
+                out[j] = better ? kk : out[j];
+            }
+        }
+    }
+};
+
+void run_tasks(std::size_t tasks, std::size_t elems, const std::function<void(std::size_t, std::size_t)>& fn) {
+    if (elems >= PARALLEL_MIN_ELEMS && tasks > 1) {
+        const std::size_t per_task = std::max<std::size_t>(1, elems / tasks);
+        parallel::parallel_for(0, tasks, std::max<std::size_t>(1, PARALLEL_MIN_ELEMS / per_task), fn);
+    } else {
+        fn(0, tasks);
+    }
+}
+
+// Combina p[0..n) en arbol, manteniendo el orden (izquierda antes que derecha).
+template <typename Op>
+typename Op::acc combine_tree(const typename Op::acc* p, std::size_t n) {
+    if (n == 1) return p[0];
+    const std::size_t half = n / 2;
+    return Op::combine(combine_tree<Op>(p, half), combine_tree<Op>(p + half, n - half));
+}
+
+// out[o] = Op sobre x[o * len .. (o + 1) * len) para o en [0, outer).
+template <typename Op, typename T>
+void reduce_rows(const T* x, std::size_t outer, std::size_t len, typename Op::acc* out) {
+    const std::size_t chunks = (len + CHUNK - 1) / CHUNK;
+    std::vector<typename Op::acc> partial(outer * chunks);
+    run_tasks(outer * chunks, outer * len, [&](std::size_t t0, std::size_t t1) {
+        for (std::size_t t = t0; t < t1; ++t) {
+            const std::size_t o = t / chunks, c = t % chunks;
+            const std::size_t b = c * CHUNK, n = std::min(CHUNK, len - b);
+            partial[t] = Op::segment(x + o * len + b, n, b);
+        }
+    });
+    for (std::size_t o = 0; o < outer; ++o) out[o] = combine_tree<Op>(&partial[o * chunks], chunks);
+}
+
+template <typename Op, typename T>
+void reduce_dim_kernel(const T* x, std::size_t outer, std::size_t len, std::size_t inner, T* out) {
+    if (inner == 1) {
+        std::vector<typename Op::acc> acc(outer);
+        reduce_rows<Op>(x, outer, len, acc.data());
+        for (std::size_t o = 0; o < outer; ++o) out[o] = Op::finish(acc[o], len);
+        return;
+    }
+    const std::size_t blocks = (inner + COL_BLOCK - 1) / COL_BLOCK;
+    run_tasks(outer * blocks, outer * len * inner, [&](std::size_t t0, std::size_t t1) {
+        for (std::size_t t = t0; t < t1; ++t) {
+            const std::size_t o = t / blocks, c0 = (t % blocks) * COL_BLOCK;
+            const std::size_t ncols = std::min(COL_BLOCK, inner - c0);
+            Op::columns(x + o * len * inner + c0, len, inner, ncols, out + o * inner + c0);
+        }
+    });
+}
+
+template <typename Op, typename T>
+typename Op::acc reduce_all(const T* x, std::size_t n) {
+    typename Op::acc a;
+    reduce_rows<Op>(x, 1, n, &a);
+    return a;
+}
+
+}
+
+template <typename T>
+BasicTensor<T> BasicTensor<T>::reduce_dim(std::size_t dim, bool keepdim, ReduceKind kind, const char* fn) const {
+    if (size_ == 0) {
+        throw std::invalid_argument(std::string(fn) + ": tensor vacio");
+    }
+    if (dim >= dims()) {
+        throw std::invalid_argument(std::string(fn) + ": dim out of range");
+    }
+    TENSOR_PROFILE_SCOPE(fn);
+    TENSOR_PROFILE_INPUT(shape_);
+    TENSOR_PROFILE_FLOPS(size_);
+    const BasicTensor<T> src = contiguous();
+
+    std::size_t outer = 1, inner = 1;
+    for (std::size_t d = 0; d < dim; ++d) outer *= shape_[d];
+    for (std::size_t d = dim + 1; d < dims(); ++d) inner *= shape_[d];
+    const std::size_t len = shape_[dim];
+
+    std::vector<std::size_t> out_shape;
+    for (std::size_t d = 0; d < dims(); ++d) {
+        if (d != dim) out_shape.push_back(shape_[d]);
+        else if (keepdim) out_shape.push_back(1);
+    }
+    if (out_shape.empty()) out_shape.push_back(1);
+
+    TENSOR_PROFILE_OUTPUT(out_shape);
+    BasicTensor<T> out;
+    out.prepare_out_or_throw(out_shape, fn);
+
+    switch (kind) {
+    case ReduceKind::Sum:    reduce_dim_kernel<SumOp<T> >(src.data_, outer, len, inner, out.data_); break;
+    case ReduceKind::Mean:   reduce_dim_kernel<MeanOp<T> >(src.data_, outer, len, inner, out.data_); break;
+    case ReduceKind::Max:    reduce_dim_kernel<ExtremeOp<T, true> >(src.data_, outer, len, inner, out.data_); break;
+    case ReduceKind::Min:    reduce_dim_kernel<ExtremeOp<T, false> >(src.data_, outer, len, inner, out.data_); break;
+    case ReduceKind::ArgMax: reduce_dim_kernel<ArgMaxOp<T> >(src.data_, outer, len, inner, out.data_); break;
+    }
+    return out;
+}
+
+template <typename T>
+BasicTensor<T> BasicTensor<T>::sum(std::size_t dim, bool keepdim) const {
+    return reduce_dim(dim, keepdim, ReduceKind::Sum, "Tensor::sum");
+}
+
+template <typename T>
+BasicTensor<T> BasicTensor<T>::mean(std::size_t dim, bool keepdim) const {
+    return reduce_dim(dim, keepdim, ReduceKind::Mean, "Tensor::mean");
+}
+
+template <typename T>
+BasicTensor<T> BasicTensor<T>::max(std::size_t dim, bool keepdim) const {
+    return reduce_dim(dim, keepdim, ReduceKind::Max, "Tensor::max");
+}
+
+template <typename T>
+BasicTensor<T> BasicTensor<T>::min(std::size_t dim, bool keepdim) const {
+    return reduce_dim(dim, keepdim, ReduceKind::Min, "Tensor::min");
+}
+
+template <typename T>
+BasicTensor<T> BasicTensor<T>::argmax(std::size_t dim, bool keepdim) const {
+    return reduce_dim(dim, keepdim, ReduceKind::ArgMax, "Tensor::argmax");
+}
+
+//
+//REDUCCIONES TOTALES
+//
+
+template <typename T>
+T BasicTensor<T>::sum() const {
+    if (size_ == 0) return T(0);
+    TENSOR_PROFILE_SCOPE("Tensor::sum");
+    TENSOR_PROFILE_INPUT(shape_);
+    TENSOR_PROFILE_FLOPS(size_);
+    const BasicTensor<T> src = contiguous();
+    return reduce_all<SumOp<T> >(src.data_, size_);
+}
+
+template <typename T>
+T BasicTensor<T>::mean() const {
+    if (size_ == 0) throw std::invalid_argument("Tensor::mean: tensor vacio");
+    return sum() / static_cast<T>(size_);
+}
+
+template <typename T>
+T BasicTensor<T>::max() const {
+    if (size_ == 0) throw std::invalid_argument("Tensor::max: tensor vacio");
+    TENSOR_PROFILE_SCOPE("Tensor::max");
+    TENSOR_PROFILE_INPUT(shape_);
+    TENSOR_PROFILE_FLOPS(size_);
+    const BasicTensor<T> src = contiguous();
+    return reduce_all<ExtremeOp<T, true> >(src.data_, size_);
+}
+
+template <typename T>
+T BasicTensor<T>::min() const {
+    if (size_ == 0) throw std::invalid_argument("Tensor::min: tensor vacio");
+    TENSOR_PROFILE_SCOPE("Tensor::min");
+    TENSOR_PROFILE_INPUT(shape_);
+    TENSOR_PROFILE_FLOPS(size_);
+    const BasicTensor<T> src = contiguous();
+    return reduce_all<ExtremeOp<T, false> >(src.data_, size_);
+}
+
+template <typename T>
+std::size_t BasicTensor<T>::argmax() const {
+    if (size_ == 0) throw std::invalid_argument("Tensor::argmax: tensor vacio");
+    TENSOR_PROFILE_SCOPE("Tensor::argmax");
+    TENSOR_PROFILE_INPUT(shape_);
+    TENSOR_PROFILE_FLOPS(size_);
+    const BasicTensor<T> src = contiguous();
+    return reduce_all<ArgMaxOp<T> >(src.data_, size_).second;
+}
+
+//
+//INSTANCIACIONES
+//
+
+#define TENSOR_REDUCE_INSTANTIATE(T) \
+    template BasicTensor<T> BasicTensor<T>::reduce_dim(std::size_t, bool, ReduceKind, const char*) const; \
+    template BasicTensor<T> BasicTensor<T>::sum(std::size_t, bool) const; \
+    template BasicTensor<T> BasicTensor<T>::mean(std::size_t, bool) const; \
+    template BasicTensor<T> BasicTensor<T>::max(std::size_t, bool) const; \
+    template BasicTensor<T> BasicTensor<T>::min(std::size_t, bool) const; \
+    template BasicTensor<T> BasicTensor<T>::argmax(std::size_t, bool) const; \
+    template T BasicTensor<T>::sum() const; \
+    template T BasicTensor<T>::mean() const; \
+    template T BasicTensor<T>::max() const; \
+    template T BasicTensor<T>::min() const; \
+    template std::size_t BasicTensor<T>::argmax() const;
+
+TENSOR_REDUCE_INSTANTIATE(float)
+TENSOR_REDUCE_INSTANTIATE(double)
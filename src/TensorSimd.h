@@ -0,0 +1,271 @@
+#ifndef CS2013_TENSOR_LIBRARY_TENSORSIMD_H
+#define CS2013_TENSOR_LIBRARY_TENSORSIMD_H
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+//
+//ENVOLTORIOS SIMD (uso interno de src/)
+//
+// VecD / VecF son el vector de double / float mas ancho disponible (AVX2+FMA, SSE2 o escalar)
+// y ScalarD / ScalarF tienen la misma interfaz con un solo valor, para que las colas de los
+// bucles den el mismo resultado. set1 acepta double en todos los casos.
+//
+
+namespace simd {
+
+struct ScalarD {
+    typedef double scalar;
+    static const std::size_t width = 1;
+    double v;
+};
+
+inline ScalarD load(const double* p, ScalarD) { ScalarD r; r.v = *p; return r; }
+inline void store(double* p, ScalarD a) { *p = a.v; }
+inline ScalarD set1(double x, ScalarD) { ScalarD r; r.v = x; return r; }
+inline ScalarD operator+(ScalarD a, ScalarD b) { a.v += b.v; return a; }
+inline ScalarD operator-(ScalarD a, ScalarD b) { a.v -= b.v; return a; }
+inline ScalarD operator*(ScalarD a, ScalarD b) { a.v *= b.v; return a; }
+inline ScalarD operator/(ScalarD a, ScalarD b) { a.v /= b.v; return a; }
+inline ScalarD fmadd(ScalarD a, ScalarD b, ScalarD c) { a.v = a.v * b.v + c.v; return a; }
+inline ScalarD vmax(ScalarD a, ScalarD b) { a.v = (a.v > b.v) ? a.v : b.v; return a; }
+inline ScalarD vmin(ScalarD a, ScalarD b) { a.v = (a.v < b.v) ? a.v : b.v; return a; }
+
+// Si t = n + (1.5 * 2^52 + 1023) con n entero, los bits bajos de t valen n + 1023:
+// desplazarlos al campo exponente da 2^n sin conversiones a entero.
+inline ScalarD pow2_from_magic(ScalarD t) {
+    std::uint64_t bits;
+    std::memcpy(&bits, &t.v, sizeof(bits));
+    bits <<= 52;
+    ScalarD r;
+    std::memcpy(&r.v, &bits, sizeof(bits));
+    return r;
+}
+
+struct ScalarF {
+    typedef float scalar;
+    static const std::size_t width = 1;
+    float v;
+};
+
+inline ScalarF load(const float* p, ScalarF) { ScalarF r; r.v = *p; return r; }
+inline void store(float* p, ScalarF a) { *p = a.v; }
+inline ScalarF set1(double x, ScalarF) { ScalarF r; r.v = static_cast<float>(x); return r; }
+inline ScalarF operator+(ScalarF a, ScalarF b) { a.v += b.v; return a; }
+inline ScalarF operator-(ScalarF a, ScalarF b) { a.v -= b.v; return a; }
+inline ScalarF operator*(ScalarF a, ScalarF b) { a.v *= b.v; return a; }
+inline ScalarF operator/(ScalarF a, ScalarF b) { a.v /= b.v; return a; }
+inline ScalarF fmadd(ScalarF a, ScalarF b, ScalarF c) { a.v = a.v * b.v + c.v; return a; }
+inline ScalarF vmax(ScalarF a, ScalarF b) { a.v = (a.v > b.v) ? a.v : b.v; return a; }
+inline ScalarF vmin(ScalarF a, ScalarF b) { a.v = (a.v < b.v) ? a.v : b.v; return a; }
+
+// Igual que en double con magic = 1.5 * 2^23 + 127 y el campo exponente en el bit 23.
+inline ScalarF pow2_from_magic(ScalarF t) {
+    std::uint32_t bits;
+    std::memcpy(&bits, &t.v, sizeof(bits));
+    bits <<= 23;
+    ScalarF r;
+    std::memcpy(&r.v, &bits, sizeof(bits));
+    return r;
+}
+
+#if defined(__AVX2__) && defined(__FMA__)
+
+struct VecD {
+    typedef double scalar;
+    static const std::size_t width = 4;
+    __m256d v;
+};
+
+inline VecD mk(__m256d x) { VecD r; r.v = x; return r; }
+inline VecD load(const double* p, VecD) { return mk(_mm256_loadu_pd(p)); }
+inline void store(double* p, VecD a) { _mm256_storeu_pd(p, a.v); }
+inline VecD set1(double x, VecD) { return mk(_mm256_set1_pd(x)); }
+inline VecD operator+(VecD a, VecD b) { return mk(_mm256_add_pd(a.v, b.v)); }
+inline VecD operator-(VecD a, VecD b) { return mk(_mm256_sub_pd(a.v, b.v)); }
+inline VecD operator*(VecD a, VecD b) { return mk(_mm256_mul_pd(a.v, b.v)); }
+inline VecD operator/(VecD a, VecD b) { return mk(_mm256_div_pd(a.v, b.v)); }
+inline VecD fmadd(VecD a, VecD b, VecD c) { return mk(_mm256_fmadd_pd(a.v, b.v, c.v)); }
+inline VecD vmax(VecD a, VecD b) { return mk(_mm256_max_pd(a.v, b.v)); }
+inline VecD vmin(VecD a, VecD b) { return mk(_mm256_min_pd(a.v, b.v)); }
+inline VecD pow2_from_magic(VecD t) {
+    return mk(_mm256_castsi256_pd(_mm256_slli_epi64(_mm256_castpd_si256(t.v), 52)));
+}
+
+struct VecF {
+    typedef float scalar;
+    static const std::size_t width = 8;
+    __m256 v;
+};
+
+inline VecF mk(__m256 x) { VecF r; r.v = x; return r; }
+inline VecF load(const float* p, VecF) { return mk(_mm256_loadu_ps(p)); }
+inline void store(float* p, VecF a) { _mm256_storeu_ps(p, a.v); }
+inline VecF set1(double x, VecF) { return mk(_mm256_set1_ps(static_cast<float>(x))); }
+inline VecF operator+(VecF a, VecF b) { return mk(_mm256_add_ps(a.v, b.v)); }
+inline VecF operator-(VecF a, VecF b) { return mk(_mm256_sub_ps(a.v, b.v)); }
+inline VecF operator*(VecF a, VecF b) { return mk(_mm256_mul_ps(a.v, b.v)); }
+inline VecF operator/(VecF a, VecF b) { return mk(_mm256_div_ps(a.v, b.v)); }
+inline VecF fmadd(VecF a, VecF b, VecF c) { return mk(_mm256_fmadd_ps(a.v, b.v, c.v)); }
+inline VecF vmax(VecF a, VecF b) { return mk(_mm256_max_ps(a.v, b.v)); }
+inline VecF vmin(VecF a, VecF b) { return mk(_mm256_min_ps(a.v, b.v)); }
+inline VecF pow2_from_magic(VecF t) {
+    return mk(_mm256_castsi256_ps(_mm256_slli_epi32(_mm256_castps_si256(t.v), 23)));
+}
+
+#elif defined(__SSE2__) || defined(_M_X64)
+
+struct VecD {
+    typedef double scalar;
+    static const std::size_t width = 2;
+    __m128d v;
+};
+
+inline VecD mk(__m128d x) { VecD r; r.v = x; return r; }
+inline VecD load(const double* p, VecD) { return mk(_mm_loadu_pd(p)); }
+inline void store(double* p, VecD a) { _mm_storeu_pd(p, a.v); }
+inline VecD set1(double x, VecD) { return mk(_mm_set1_pd(x)); }
+inline VecD operator+(VecD a, VecD b) { return mk(_mm_add_pd(a.v, b.v)); }
+inline VecD operator-(VecD a, VecD b) { return mk(_mm_sub_pd(a.v, b.v)); }
+inline VecD operator*(VecD a, VecD b) { return mk(_mm_mul_pd(a.v, b.v)); }
+inline VecD operator/(VecD a, VecD b) { return mk(_mm_div_pd(a.v, b.v)); }
+inline VecD fmadd(VecD a, VecD b, VecD c) { return mk(_mm_add_pd(_mm_mul_pd(a.v, b.v), c.v)); }
+inline VecD vmax(VecD a, VecD b) { return mk(_mm_max_pd(a.v, b.v)); }
+inline VecD vmin(VecD a, VecD b) { return mk(_mm_min_pd(a.v, b.v)); }
+inline VecD pow2_from_magic(VecD t) {
+    return mk(_mm_castsi128_pd(_mm_slli_epi64(_mm_castpd_si128(t.v), 52)));
+}
+
+struct VecF {
+    typedef float scalar;
+    static const std::size_t width = 4;
+    __m128 v;
+};
+
+inline VecF mk(__m128 x) { VecF r; r.v = x; return r; }
+inline VecF load(const float* p, VecF) { return mk(_mm_loadu_ps(p)); }
+inline void store(float* p, VecF a) { _mm_storeu_ps(p, a.v); }
+inline VecF set1(double x, VecF) { return mk(_mm_set1_ps(static_cast<float>(x))); }
+inline VecF operator+(VecF a, VecF b) { return mk(_mm_add_ps(a.v, b.v)); }
+inline VecF operator-(VecF a, VecF b) { return mk(_mm_sub_ps(a.v, b.v)); }
+inline VecF operator*(VecF a, VecF b) { return mk(_mm_mul_ps(a.v, b.v)); }
+inline VecF operator/(VecF a, VecF b) { return mk(_mm_div_ps(a.v, b.v)); }
+inline VecF fmadd(VecF a, VecF b, VecF c) { return mk(_mm_add_ps(_mm_mul_ps(a.v, b.v), c.v)); }
+inline VecF vmax(VecF a, VecF b) { return mk(_mm_max_ps(a.v, b.v)); }
+inline VecF vmin(VecF a, VecF b) { return mk(_mm_min_ps(a.v, b.v)); }
+inline VecF pow2_from_magic(VecF t) {
+    return mk(_mm_castsi128_ps(_mm_slli_epi32(_mm_castps_si128(t.v), 23)));
+}
+
+#else
+
+typedef ScalarD VecD;
+typedef ScalarF VecF;
+
+#endif
+
+//
+//EXP VECTORIAL
+//
+// exp(x) = 2^n * e^r, n = round(x / ln2), |r| <= ln2/2 (reduccion de Cody-Waite).
+// double: e^r por Taylor de grado 13 en Horner. El truncamiento es < 1e-17 relativo; medido
+//         contra std::exp en [-708, 709] el error relativo maximo es 2.3e-16 (~1 ulp).
+// float:  Taylor de grado 7 (truncamiento < 6e-9); medido contra std::exp en [-87, 88]
+//         el error relativo maximo es 1e-7 (~1 ulp).
+// Fuera de ese rango la entrada se satura (exp(-800) devuelve ~3e-308 en vez de 0).
+// NaN pasa por el recorte (max/min devuelven el segundo operando si hay NaN) y sale NaN.
+//
+
+template <typename V>
+inline V vexp_impl(V x, double) {
+    const V magic = set1(6755399441055744.0 + 1023.0, V());   // 1.5 * 2^52 + 1023
+    x = vmin(set1(709.0, V()), vmax(set1(-708.0, V()), x));
+
+    // t = x / ln2 redondeado al entero mas cercano (+ magic); n = t - magic.
+    const V t = fmadd(x, set1(1.4426950408889634, V()), magic);
+    const V n = t - magic;
+    V r = fmadd(n, set1(-0.693145751953125, V()), x);
+    r = fmadd(n, set1(-1.42860682030941723212e-6, V()), r);
+
+    V p = set1(1.0 / 6227020800.0, V());
+    p = fmadd(p, r, set1(1.0 / 479001600.0, V()));
+    p = fmadd(p, r, set1(1.0 / 39916800.0, V()));
+    p = fmadd(p, r, set1(1.0 / 3628800.0, V()));
+    p = fmadd(p, r, set1(1.0 / 362880.0, V()));
+    p = fmadd(p, r, set1(1.0 / 40320.0, V()));
+    p = fmadd(p, r, set1(1.0 / 5040.0, V()));
+    p = fmadd(p, r, set1(1.0 / 720.0, V()));
+    p = fmadd(p, r, set1(1.0 / 120.0, V()));
+    p = fmadd(p, r, set1(1.0 / 24.0, V()));
+    p = fmadd(p, r, set1(1.0 / 6.0, V()));
+    p = fmadd(p, r, set1(0.5, V()));
+    p = fmadd(p, r, set1(1.0, V()));
+    p = fmadd(p, r, set1(1.0, V()));
+
+    return p * pow2_from_magic(t);
+}
+
+template <typename V>
+inline V vexp_impl(V x, float) {
+    const V magic = set1(12582912.0 + 127.0, V());   // 1.5 * 2^23 + 127
+    x = vmin(set1(88.0, V()), vmax(set1(-87.0, V()), x));
+
+    const V t = fmadd(x, set1(1.4426950408889634, V()), magic);
+    const V n = t - magic;
+    V r = fmadd(n, set1(-0.693359375, V()), x);
+    r = fmadd(n, set1(2.12194440e-4, V()), r);
+
+    V p = set1(1.0 / 5040.0, V());
+    p = fmadd(p, r, set1(1.0 / 720.0, V()));
+    p = fmadd(p, r, set1(1.0 / 120.0, V()));
+    p = fmadd(p, r, set1(1.0 / 24.0, V()));
+    p = fmadd(p, r, set1(1.0 / 6.0, V()));
+    p = fmadd(p, r, set1(0.5, V()));
+    p = fmadd(p, r, set1(1.0, V()));
+    p = fmadd(p, r, set1(1.0, V()));
+
+    return p * pow2_from_magic(t);
+}
+
+template <typename V>
+inline V vexp(V x) { return vexp_impl(x, typename V::scalar()); }
+
+// Suma horizontal de las lanes (de la 0 a la ultima, en orden).
+template <typename V>
+inline typename V::scalar hsum(V v) {
+    typename V::scalar t[V::width];
+    store(t, v);
+    typename V::scalar r = t[0];
+    for (std::size_t i = 1; i < V::width; ++i) r += t[i];
+    return r;
+}
+
+// |x| sin ramas: max(x, -x).
+template <typename V>
+inline V vabs(V x) { return vmax(x, set1(0.0, V()) - x); }
+
+template <typename T> struct vec_of;
+template <> struct vec_of<double> { typedef VecD type; typedef ScalarD scalar; };
+template <> struct vec_of<float>  { typedef VecF type; typedef ScalarF scalar; };
+
+// out[i] = f(in[i]) con el vector mas ancho y cola escalar.
+template <typename T, typename F>
+inline void map(const T* in, T* out, std::size_t n, F f) {
+    typedef typename vec_of<T>::type V;
+    typedef typename vec_of<T>::scalar S;
+    std::size_t i = 0;
+    for (; i + V::width <= n; i += V::width)
+        store(out + i, f(load(in + i, V())));
+    for (; i < n; ++i)
+        store(out + i, f(load(in + i, S())));
+}
+
+}
+
+#endif //CS2013_TENSOR_LIBRARY_TENSORSIMD_H
@@ -0,0 +1,315 @@
+#include "../include/TensorStream.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace stream {
+
+//
+//FUENTES
+//
+
+template <typename T>
+GeneratorSource<T>::GeneratorSource(std::size_t rows, std::size_t cols, Fn fn)
+    : rows_(rows), cols_(cols), fn_(fn) {
+    if (cols == 0) {
+        throw std::invalid_argument("stream::GeneratorSource: cols tiene que ser > 0");
+    }
+}
+
+template <typename T>
+std::size_t GeneratorSource<T>::read(T* dst, std::size_t max_rows) {
+    const std::size_t n = std::min(max_rows, rows_ - next_);
+    if (n > 0) fn_(next_, n, dst);
+    next_ += n;
+    return n;
+}
+
+template <typename T>
+TensorFileSource<T>::TensorFileSource(const std::string& path)
+    : data_(BasicTensor<T>::mmap_load(path)) {
+    if (!data_.is_contiguous()) data_ = data_.contiguous();
+    rows_ = data_.shape()[0];
+    cols_ = data_.numel() / rows_;
+}
+
+template <typename T>
+std::size_t TensorFileSource<T>::read(T* dst, std::size_t max_rows) {
+    const std::size_t n = std::min(max_rows, rows_ - next_);
+    if (n == 0) return 0;
+    std::memcpy(dst, data_.data() + next_ * cols_, n * cols_ * sizeof(T));
+    next_ += n;
+    return n;
+}
+
+//
+//DESTINOS
+//
+
+template <typename T>
+void CallbackSink<T>::write(const BasicTensor<T>& rows) {
+    fn_(next_, rows);
+    next_ += rows.shape()[0];
+}
+
+// La cabecera ocupa siempre lo mismo para rank 2, asi que se escribe una provisional y
+// finish() la reescribe con las filas y el checksum definitivos.
+template <typename T>
+TensorFileSink<T>::TensorFileSink(const std::string& path, std::size_t cols)
+    : path_(path), f_(nullptr), cols_(cols) {
+    if (cols == 0) {
+        throw std::invalid_argument("stream::TensorFileSink: cols tiene que ser > 0");
+    }
+    f_ = std::fopen(path.c_str(), "wb");
+    if (f_ == nullptr) {
+        throw std::runtime_error("stream::TensorFileSink: no se pudo abrir " + path);
+    }
+    const std::vector<std::size_t> shape = {0, cols_}, strides = {cols_, 1};
+    const std::vector<unsigned char> header = io::encode_header(io::dtype_of<T>::value, shape, strides, 0, 0);
+    if (std::fwrite(header.data(), 1, header.size(), f_) != header.size()) {
+        std::fclose(f_);
+        f_ = nullptr;
+        throw std::runtime_error("stream::TensorFileSink: error al escribir " + path);
+    }
+}
+
+template <typename T>
+TensorFileSink<T>::~TensorFileSink() {
+    if (f_ != nullptr) {
+        try { finish(); } catch (...) {}
+    }
+}
+
+template <typename T>
+void TensorFileSink<T>::write(const BasicTensor<T>& rows) {
+    if (f_ == nullptr) {
+        throw std::runtime_error("stream::TensorFileSink::write: el archivo ya se cerro");
+    }
+    if (rows.numel() != rows.shape()[0] * cols_) {
+        throw std::invalid_argument("stream::TensorFileSink::write: cantidad de columnas distinta");
+    }
+    const BasicTensor<T> src = rows.contiguous();
+    const std::size_t bytes = src.numel() * sizeof(T);
+    const void* p = src.data();
+    if (std::fwrite(p, 1, bytes, f_) != bytes) {
+        throw std::runtime_error("stream::TensorFileSink: error al escribir " + path_);
+    }
+    checksum_.update(p, bytes);
+    rows_ += src.shape()[0];
+}
+
+template <typename T>
+void TensorFileSink<T>::finish() {
+    if (f_ == nullptr) return;
+    std::FILE* f = f_;
+    f_ = nullptr;
+    const std::vector<std::size_t> shape = {rows_, cols_}, strides = {cols_, 1};
+    const std::vector<unsigned char> header =
+        io::encode_header(io::dtype_of<T>::value, shape, strides, rows_ * cols_ * sizeof(T), checksum_.value());
+    bool ok = std::fseek(f, 0, SEEK_SET) == 0;
+    ok = ok && std::fwrite(header.data(), 1, header.size(), f) == header.size();
+    ok = (std::fclose(f) == 0) && ok;
+    if (!ok) {
+        throw std::runtime_error("stream::TensorFileSink: error al escribir " + path_);
+    }
+}
+
+//
+//PIPELINE
+//
+
+template <typename T>
+StreamingPipeline<T>::StreamingPipeline(std::size_t chunk_rows, bool read_ahead)
+    : chunk_rows_(chunk_rows), read_ahead_(read_ahead) {
+    if (chunk_rows == 0) {
+        throw std::invalid_argument("stream::StreamingPipeline: chunk_rows tiene que ser > 0");
+    }
+}
+
+template <typename T>
+std::size_t StreamingPipeline<T>::in_cols() const {
+    return in_cols_;
+}
+
+template <typename T>
+std::size_t StreamingPipeline<T>::out_cols() const {
+    std::size_t cols = in_cols_;
+    for (std::size_t i = 0; i < stages_.size(); ++i) {
+        if (stages_[i].out_cols != 0) cols = stages_[i].out_cols;
+    }
+    return cols;
+}
+
+template <typename T>
+StreamingPipeline<T>& StreamingPipeline<T>::linear(const BasicTensor<T>& w, const BasicTensor<T>& b,
+                                                   const TensorTransform* act) {
+    if (w.dims() != 2) {
+        throw std::invalid_argument("stream::StreamingPipeline::linear: w tiene que ser 2D");
+    }
+    const std::size_t prev = out_cols();
+    if (prev != 0 && w.shape()[0] != prev) {
+        throw std::invalid_argument("stream::StreamingPipeline::linear: filas de w distintas a las columnas de la etapa anterior");
+    }
+    // Antes solo hay etapas que conservan las columnas: w fija las de la entrada.
+    if (prev == 0) in_cols_ = w.shape()[0];
+    const BasicTensor<T>* pw = &w;
+    const BasicTensor<T>* pb = &b;
+    return stage(w.shape()[1], [pw, pb, act](const BasicTensor<T>& in, BasicTensor<T>& out) {
+        ::linear(in, *pw, *pb, act, out);
+    });
+}
+
+// Conserva las columnas; como primera etapa se conocen recien en run().
+template <typename T>
+StreamingPipeline<T>& StreamingPipeline<T>::apply(const TensorTransform& op) {
+    const TensorTransform* pop = &op;
+    Stage s;
+    s.out_cols = out_cols();
+    s.fn = [pop](const BasicTensor<T>& in, BasicTensor<T>& out) { in.apply(*pop, out); };
+    stages_.push_back(s);
+    buffers_.push_back(BasicTensor<T>());
+    return *this;
+}
+
+template <typename T>
+StreamingPipeline<T>& StreamingPipeline<T>::stage(std::size_t out_cols, StageFn fn) {
+    if (out_cols == 0) {
+        throw std::invalid_argument("stream::StreamingPipeline::stage: out_cols tiene que ser > 0");
+    }
+    Stage s;
+    s.out_cols = out_cols;
+    s.fn = fn;
+    stages_.push_back(s);
+    buffers_.push_back(BasicTensor<T>());
+    return *this;
+}
+
+// Los buffers se reservan en el primer run(), cuando ya se conocen las columnas de la fuente.
+template <typename T>
+void StreamingPipeline<T>::prepare_buffers(std::size_t cols) {
+    for (std::size_t i = 0; i < stages_.size(); ++i) {
+        if (stages_[i].out_cols != 0) cols = stages_[i].out_cols;
+        if (buffers_[i].numel() != chunk_rows_ * cols) {
+            buffers_[i] = BasicTensor<T>::zeros({chunk_rows_, cols});
+        }
+    }
+}
+
+// Cada etapa escribe en las primeras `rows` filas de su buffer (vista contigua, sin reservar).
+template <typename T>
+void StreamingPipeline<T>::process(const BasicTensor<T>& in, std::size_t rows, RowSink<T>& sink) {
+    BasicTensor<T> cur = in.slice(0, 0, rows);
+    for (std::size_t i = 0; i < stages_.size(); ++i) {
+        BasicTensor<T> out = buffers_[i].slice(0, 0, rows);
+        stages_[i].fn(cur, out);
+        cur = std::move(out);
+    }
+    sink.write(cur);
+}
+
+template <typename T>
+std::size_t StreamingPipeline<T>::run(RowSource<T>& source, RowSink<T>& sink) {
+    const std::size_t cols = source.cols();
+    if (in_cols_ != 0 && cols != in_cols_) {
+        throw std::invalid_argument("stream::StreamingPipeline::run: la fuente tiene " + std::to_string(cols)
+                                    + " columnas y el pipeline espera " + std::to_string(in_cols_));
+    }
+    prepare_buffers(cols);
+    BasicTensor<T> inputs[2] = {BasicTensor<T>::zeros({chunk_rows_, cols}),
+                                BasicTensor<T>::zeros({chunk_rows_, cols})};
+    T* in_data[2] = {&inputs[0].at(0, 0), &inputs[1].at(0, 0)};
+    std::size_t total = 0;
+
+    if (!read_ahead_) {
+        for (;;) {
+            const std::size_t rows = source.read(in_data[0], chunk_rows_);
+            if (rows == 0) break;
+            process(inputs[0], rows, sink);
+            total += rows;
+        }
+        sink.finish();
+        return total;
+    }
+
+    // Lector: llena los buffers alternadamente; filled[i] = filas listas (0 = fin) o -1 si libre.
+    std::mutex m;
+    std::condition_variable cv;
+    long long filled[2] = {-1, -1};
+    bool stop = false;
+    std::exception_ptr reader_error;
+
+    std::thread reader([&] {
+        for (std::size_t i = 0;; i ^= 1) {
+            {
+                std::unique_lock<std::mutex> lk(m);
+                cv.wait(lk, [&] { return stop || filled[i] < 0; });
+                if (stop) return;
+            }
+            std::size_t rows = 0;
+            try {
+                rows = source.read(in_data[i], chunk_rows_);
+            } catch (...) {
+                std::lock_guard<std::mutex> lk(m);
+                reader_error = std::current_exception();
+            }
+            {
+                std::lock_guard<std::mutex> lk(m);
+                filled[i] = static_cast<long long>(rows);
+            }
+            cv.notify_all();
+            if (rows == 0) return;
+        }
+    });
+
+    try {
+        for (std::size_t i = 0;; i ^= 1) {
+            std::size_t rows;
+            {
+                std::unique_lock<std::mutex> lk(m);
+                cv.wait(lk, [&] { return filled[i] >= 0; });
+                if (reader_error) std::rethrow_exception(reader_error);
+                rows = static_cast<std::size_t>(filled[i]);
+            }
+            if (rows == 0) break;
+            process(inputs[i], rows, sink);
+            total += rows;
+            {
+                std::lock_guard<std::mutex> lk(m);
+                filled[i] = -1;
+            }
+            cv.notify_all();
+        }
+    } catch (...) {
+        {
+            std::lock_guard<std::mutex> lk(m);
+            stop = true;
+        }
+        cv.notify_all();
+        reader.join();
+        throw;
+    }
+    reader.join();
+    sink.finish();
+    return total;
+}
+
+//
+//INSTANCIACIONES
+//
+
+template class GeneratorSource<float>;
+template class GeneratorSource<double>;
+template class TensorFileSource<float>;
+template class TensorFileSource<double>;
+template class CallbackSink<float>;
+template class CallbackSink<double>;
+template class TensorFileSink<float>;
+template class TensorFileSink<double>;
+template class StreamingPipeline<float>;
+template class StreamingPipeline<double>;
+
+}
@@ -0,0 +1,186 @@
+//
+// Comprueba los gradientes de autograd::Tape (TensorAutograd.h) contra diferencias finitas
+// centrales, en una red pequeña con matmul, bias con broadcast ((1 x h) y (n)), Tanh,
+// concat, Sigmoid, view, unsqueeze y mean:
+//   - f64: cada elemento de cada hoja contra (L(p + h) - L(p - h)) / 2h;
+//   - con checkpoint sobre la primera capa y el concat: mismos gradientes y menos
+//     activaciones retenidas que sin checkpoint;
+//   - f32: los gradientes coinciden con los de f64 salvo redondeo.
+//
+// Uso: CS2013_Tensor_AutogradCheck (sale con 1 si alguna comprobacion falla).
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "include/Tensor.h"
+#include "include/TensorAutograd.h"
+#include "include/TensorTransform.h"
+
+namespace {
+
+std::size_t checks = 0;
+std::size_t failures = 0;
+
+const std::size_t M = 5, K = 4, H = 7, N = 3;
+
+// Hojas de la red: x (M x K), W1 (K x H), b1 (1 x H), W2 (H + K x N), b2 (N).
+template <typename T>
+struct Params {
+    std::vector<BasicTensor<T> > leaves;
+    BasicTensor<T> target;                      // constante (M x N)
+};
+
+const char* const leaf_names[] = {"x", "W1", "b1", "W2", "b2"};
+
+Params<double> make_params() {
+    Params<double> p;
+    p.leaves.push_back(Tensor::random({M, K}, -1.0, 1.0));
+    p.leaves.push_back(Tensor::random({K, H}, -0.8, 0.8));
+    p.leaves.push_back(Tensor::random({1, H}, -0.3, 0.3));
+    p.leaves.push_back(Tensor::random({H + K, N}, -0.6, 0.6));
+    p.leaves.push_back(Tensor::random({N}, -0.3, 0.3));
+    p.target = Tensor::random({M, N}, 0.0, 1.0);
+    return p;
+}
+
+template <typename T>
+Params<T> cast(const Params<double>& p) {
+    Params<T> q;
+    for (const Tensor& t : p.leaves) q.leaves.push_back(BasicTensor<T>(t.shape(), std::vector<T>(t.data(), t.data() + t.numel())));
+    q.target = BasicTensor<T>(p.target.shape(), std::vector<T>(p.target.data(), p.target.data() + p.target.numel()));
+    return q;
+}
+
+// concat(tanh(x W1 + b1), x * 0.5) por columnas.
+template <typename T>
+autograd::Var<T> first_layer(autograd::Tape<T>&, const std::vector<autograd::Var<T> >& in) {
+    static Tanh tanh_op;
+    const autograd::Var<T> h = autograd::apply(autograd::matmul(in[0], in[1]) + in[2], tanh_op);
+    return autograd::concat(std::vector<autograd::Var<T> >{h, in[0] * 0.5}, 1);
+}
+
+// mean((sigmoid(u W2 + b2) - target)^2) con el resultado pasado por view y unsqueeze.
+template <typename T>
+autograd::Var<T> loss(autograd::Tape<T>& tape, const std::vector<autograd::Var<T> >& v,
+                      const BasicTensor<T>& target, bool checkpoint) {
+    const std::vector<autograd::Var<T> > in = {v[0], v[1], v[2]};
+    const autograd::Var<T> u = checkpoint ? tape.checkpoint(in, &first_layer<T>) : first_layer(tape, in);
+    const autograd::Var<T> s = autograd::sigmoid(autograd::matmul(u, v[3]) + v[4]);
+    const autograd::Var<T> d = autograd::unsqueeze(s - tape.constant(target), 0);
+    return autograd::mean(autograd::view(d * d, {M * N}));
+}
+
+template <typename T>
+struct Result {
+    T value;
+    std::vector<BasicTensor<T> > grads;
+    std::size_t activation_bytes;
+};
+
+template <typename T>
+Result<T> forward_backward(const Params<T>& p, bool checkpoint) {
+    autograd::Tape<T> tape;
+    std::vector<autograd::Var<T> > v;
+    for (const BasicTensor<T>& t : p.leaves) v.push_back(tape.leaf(t));
+    const autograd::Var<T> l = loss(tape, v, p.target, checkpoint);
+    Result<T> r;
+    r.value = l.value().data()[0];
+    r.activation_bytes = tape.activation_bytes();
+    tape.backward(l);
+    for (const autograd::Var<T>& x : v) r.grads.push_back(x.grad());
+    return r;
+}
+
+double loss_value(const Params<double>& p) {
+    autograd::Tape<double> tape;
+    std::vector<autograd::Var<double> > v;
+    for (const Tensor& t : p.leaves) v.push_back(tape.leaf(t, false));
+    return loss(tape, v, p.target, false).value().data()[0];
+}
+
+void expect(bool ok, const std::string& what) {
+    ++checks;
+    if (!ok) {
+        ++failures;
+        std::printf("FALLO %s\n", what.c_str());
+    }
+}
+
+// |got - ref| <= tol * (1 + |ref|) en cada elemento.
+template <typename T>
+void expect_grad(const std::string& what, const BasicTensor<T>& got, const Tensor& ref, double tol) {
+    ++checks;
+    if (got.shape() != ref.shape()) {
+        ++failures;
+        std::printf("FALLO %s: shape distinta\n", what.c_str());
+        return;
+    }
+    for (std::size_t i = 0; i < ref.numel(); ++i) {
+        const double g = got.data()[i], r = ref.data()[i];
+        if (!(std::abs(g - r) <= tol * (1.0 + std::abs(r)))) {
+            ++failures;
+            std::printf("FALLO %s [%zu]: %.9g vs %.9g\n", what.c_str(), i, g, r);
+            return;
+        }
+    }
+}
+
+void check_finite_differences(const Params<double>& p) {
+    const double h = 1e-5;
+    std::vector<Tensor> numeric;
+    Params<double> q = p;                                // copia profunda para perturbar
+    for (std::size_t l = 0; l < p.leaves.size(); ++l) {
+        Tensor g(p.leaves[l].shape(), std::vector<double>(p.leaves[l].numel()));
+        for (std::size_t i = 0; i < g.numel(); ++i) {
+            double* e = q.leaves[l].data() + i;
+            const double orig = *e;
+            *e = orig + h;
+            const double up = loss_value(q);
+            *e = orig - h;
+            const double down = loss_value(q);
+            *e = orig;
+            g.data()[i] = (up - down) / (2 * h);
+        }
+        numeric.push_back(g);
+    }
+
+    for (int cp = 0; cp < 2; ++cp) {
+        const Result<double> r = forward_backward(p, cp == 1);
+        const std::string tag = std::string("f64") + (cp == 1 ? " checkpoint " : " ");
+        expect(std::abs(r.value - loss_value(p)) <= 1e-14, tag + "valor de la perdida");
+        for (std::size_t l = 0; l < numeric.size(); ++l)
+            expect_grad(tag + "dL/d" + leaf_names[l], r.grads[l], numeric[l], 1e-7);
+    }
+
+    const Result<double> plain = forward_backward(p, false), cp = forward_backward(p, true);
+    for (std::size_t l = 0; l < plain.grads.size(); ++l)
+        expect_grad(std::string("f64 checkpoint == sin checkpoint dL/d") + leaf_names[l], cp.grads[l], plain.grads[l], 1e-13);
+    expect(cp.activation_bytes < plain.activation_bytes, "checkpoint retiene menos activaciones");
+}
+
+void check_float(const Params<double>& p) {
+    const Params<float> pf = cast<float>(p);
+    const Result<double> ref = forward_backward(p, false);
+    for (int cp = 0; cp < 2; ++cp) {
+        const Result<float> r = forward_backward(pf, cp == 1);
+        const std::string tag = std::string("f32") + (cp == 1 ? " checkpoint " : " ");
+        for (std::size_t l = 0; l < ref.grads.size(); ++l)
+            expect_grad(tag + "dL/d" + leaf_names[l], r.grads[l], ref.grads[l], 1e-5);
+    }
+}
+
+}
+
+int main() {
+    rng::manual_seed(2013);
+    for (int rep = 0; rep < 3; ++rep) {
+        const Params<double> p = make_params();
+        check_finite_differences(p);
+        check_float(p);
+    }
+    std::printf("autograd_check: %zu comprobaciones, %zu fallos\n", checks, failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,155 @@
+//
+// Comprueba gemm::gemm (TensorGemm.h) contra un producto ingenuo en double:
+//   - m, n no multiplos de MR / NR (colas del micro-kernel), k impar, y tamaños que cruzan
+//     los bloques mc, kc y nc de block_sizes();
+//   - A y B normales o transpuestas (strides de fila y columna), C dentro de un buffer con
+//     ldc > n (el relleno no se toca) y el epilogo bias + ReLU;
+//   - matmul y linear sobre vistas transpuestas;
+//   - 1, 2 y 3 hilos, con el umbral de paralelismo en 0 para que todos los tamaños se partan.
+// Cota por elemento: |c - ref| <= (k + 2) eps_T sum_p |a_ip| |b_pj| (+ |bias| y ReLU no la agranda).
+//
+// Uso: CS2013_Tensor_GemmCheck (sale con 1 si alguna comprobacion falla).
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <string>
+#include <vector>
+#include "include/Tensor.h"
+#include "include/TensorGemm.h"
+#include "include/TensorParallel.h"
+#include "include/TensorTransform.h"
+
+namespace {
+
+std::size_t checks = 0;
+std::size_t failures = 0;
+
+// C = act(A * B + bias) en double; bound = cota del error de redondeo en T.
+template <typename T>
+void reference(std::size_t m, std::size_t n, std::size_t k,
+               const T* a, std::size_t rsa, std::size_t csa,
+               const T* b, std::size_t rsb, std::size_t csb,
+               const T* bias, bool relu, std::vector<double>& ref, std::vector<double>& bound) {
+    const double eps = std::numeric_limits<T>::epsilon();
+    ref.assign(m * n, 0.0);
+    bound.assign(m * n, 0.0);
+    for (std::size_t i = 0; i < m; ++i) {
+        for (std::size_t j = 0; j < n; ++j) {
+            double s = 0.0, mag = 0.0;
+            for (std::size_t p = 0; p < k; ++p) {
+                const double x = double(a[i * rsa + p * csa]) * double(b[p * rsb + j * csb]);
+                s += x;
+                mag += std::abs(x);
+            }
+            if (bias != nullptr) {
+                s += bias[j];
+                mag += std::abs(double(bias[j]));
+            }
+            ref[i * n + j] = relu ? std::max(0.0, s) : s;
+            bound[i * n + j] = double(k + 2) * eps * mag + std::numeric_limits<T>::min();
+        }
+    }
+}
+
+template <typename T>
+void expect_close(const std::string& what, std::size_t m, std::size_t n, const T* c, std::size_t ldc,
+                  const std::vector<double>& ref, const std::vector<double>& bound) {
+    ++checks;
+    for (std::size_t i = 0; i < m; ++i) {
+        for (std::size_t j = 0; j < n; ++j) {
+            const double g = c[i * ldc + j], r = ref[i * n + j];
+            if (!(std::abs(g - r) <= bound[i * n + j])) {
+                ++failures;
+                std::printf("FALLO %s (%zu, %zu): %.9g vs %.9g, tol %.3g\n", what.c_str(), i, j, g, r, bound[i * n + j]);
+                return;
+            }
+        }
+    }
+}
+
+template <typename T>
+void check_gemm(const std::string& tag, std::size_t m, std::size_t n, std::size_t k) {
+    typedef BasicTensor<T> Tn;
+    const Tn A = Tn::random({m, k}, T(-1), T(1)), At = Tn::random({k, m}, T(-1), T(1));
+    const Tn B = Tn::random({k, n}, T(-1), T(1)), Bt = Tn::random({n, k}, T(-1), T(1));
+    const Tn bias = Tn::random({n}, T(-1), T(1));
+    ReLU relu;
+    gemm::Epilogue<T> ep;
+    ep.bias = bias.data();
+    ep.act = &relu;
+
+    const T pad = T(12345);
+    const std::size_t ldc = n + 3;
+    std::vector<double> ref, bound;
+    for (int ta = 0; ta < 2; ++ta) {
+        for (int tb = 0; tb < 2; ++tb) {
+            // Transpuesta: se lee la matriz guardada (k x m) / (n x k) con los strides cambiados.
+            const T* a = ta ? At.data() : A.data();
+            const std::size_t rsa = ta ? 1 : k, csa = ta ? m : 1;
+            const T* b = tb ? Bt.data() : B.data();
+            const std::size_t rsb = tb ? 1 : n, csb = tb ? k : 1;
+            const std::string layout = tag + (ta ? " A^T" : " A") + (tb ? " B^T" : " B");
+
+            for (int with_ep = 0; with_ep < 2; ++with_ep) {
+                std::vector<T> c(m * ldc, pad);
+                gemm::gemm<T>(m, n, k, a, rsa, csa, b, rsb, csb, c.data(), ldc, with_ep ? &ep : nullptr);
+                reference(m, n, k, a, rsa, csa, b, rsb, csb, with_ep ? bias.data() : nullptr, with_ep == 1, ref, bound);
+                const std::string what = layout + (with_ep ? " bias+relu" : "");
+                expect_close(what, m, n, c.data(), ldc, ref, bound);
+                bool untouched = true;
+                for (std::size_t i = 0; i < m; ++i)
+                    for (std::size_t j = n; j < ldc; ++j) untouched = untouched && c[i * ldc + j] == pad;
+                ++checks;
+                if (!untouched) {
+                    ++failures;
+                    std::printf("FALLO %s: escribio fuera de las n columnas (ldc %zu)\n", what.c_str(), ldc);
+                }
+            }
+        }
+    }
+
+    // Nivel Tensor: matmul y linear con vistas transpuestas.
+    const Tn av = At.transpose(), bv = Bt.transpose();
+    reference(m, n, k, At.data(), std::size_t(1), m, Bt.data(), std::size_t(1), k, static_cast<const T*>(nullptr), false, ref, bound);
+    const Tn mm = matmul(av, bv);
+    expect_close(tag + " matmul(vista^T, vista^T)", m, n, mm.data(), n, ref, bound);
+    reference(m, n, k, At.data(), std::size_t(1), m, B.data(), n, std::size_t(1), bias.data(), true, ref, bound);
+    const Tn lin = linear(av, B, bias, &relu);
+    expect_close(tag + " linear(vista^T, B, b, relu)", m, n, lin.data(), n, ref, bound);
+}
+
+template <typename T>
+void check_all(const char* type, std::size_t threads) {
+    const gemm::BlockSizes& bs = gemm::block_sizes<T>();
+    // (m, n, k): colas de MR (6) y NR (8 / 16), k impar, y cruces de mc, kc y nc.
+    const std::size_t sizes[][3] = {
+        {1, 1, 1}, {5, 7, 3}, {7, 17, 33}, {13, 9, 64}, {6, 16, 32}, {31, 45, 97},
+        {61, 67, 129}, {bs.mc + 7, 23, 41}, {19, 29, bs.kc + 5}, {7, bs.nc + 5, 11}
+    };
+    for (const auto& s : sizes) {
+        char buf[96];
+        std::snprintf(buf, sizeof(buf), "%s %zu hilos m=%zu n=%zu k=%zu", type, threads, s[0], s[1], s[2]);
+        check_gemm<T>(buf, s[0], s[1], s[2]);
+    }
+}
+
+}
+
+int main() {
+    rng::manual_seed(2013);
+    const std::size_t threshold = gemm::parallel_threshold();
+    gemm::set_parallel_threshold(0);
+    const std::size_t threads[] = {1, 2, 3};
+    for (std::size_t t : threads) {
+        parallel::set_num_threads(t);
+        check_all<double>("f64", t);
+        check_all<float>("f32", t);
+    }
+    parallel::set_num_threads(0);
+    gemm::set_parallel_threshold(threshold);
+    std::printf("gemm_check: %zu comprobaciones, %zu fallos\n", checks, failures);
+    return failures == 0 ? 0 : 1;
+}
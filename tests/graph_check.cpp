@@ -0,0 +1,207 @@
+//
+// Comprueba graph::Graph (TensorGraph.h) contra la ejecucion inmediata de las mismas
+// operaciones sobre Tensor, con y sin fusion, con 1 y 3 hilos:
+//   - las salidas coinciden con la version eager (mismas operaciones, salvo redondeo);
+//   - la arena no ocupa mas que un buffer por intermedio y la fusion reduce los kernels;
+//   - run() no pide memoria: se cuentan los operator new y los allocate del allocator de los
+//     tensores durante varias ejecuciones tras la primera.
+//
+// Uso: CS2013_Tensor_GraphCheck (sale con 1 si alguna comprobacion falla).
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <new>
+#include <string>
+#include <vector>
+#include "include/Tensor.h"
+#include "include/TensorAllocator.h"
+#include "include/TensorGraph.h"
+#include "include/TensorParallel.h"
+#include "include/TensorTransform.h"
+
+namespace {
+
+std::size_t checks = 0;
+std::size_t failures = 0;
+long heap_allocs = 0;
+
+// Cuenta los buffers de tensores y los delega al pool por defecto.
+class CountingAllocator : public TensorAllocator {
+public:
+    void* allocate(std::size_t bytes) override {
+        ++count;
+        return default_pool().allocate(bytes);
+    }
+    void deallocate(void* p, std::size_t bytes) override { default_pool().deallocate(p, bytes); }
+    long count = 0;
+};
+
+void expect(bool ok, const std::string& what) {
+    ++checks;
+    if (!ok) {
+        ++failures;
+        std::printf("FALLO %s\n", what.c_str());
+    }
+}
+
+template <typename T>
+void expect_close(const std::string& what, const BasicTensor<T>& got, const BasicTensor<T>& ref) {
+    ++checks;
+    if (got.shape() != ref.shape()) {
+        ++failures;
+        std::printf("FALLO %s: shape distinta\n", what.c_str());
+        return;
+    }
+    // Mismas operaciones en otro orden de bloques: solo difiere el redondeo (FMA, vectorizacion).
+    const double eps = 64 * std::numeric_limits<T>::epsilon();
+    const BasicTensor<T> g = got.contiguous(), r = ref.contiguous();
+    for (std::size_t i = 0; i < r.numel(); ++i) {
+        const double a = g.data()[i], b = r.data()[i];
+        if (!(std::abs(a - b) <= eps * (1.0 + std::abs(b)))) {
+            ++failures;
+            std::printf("FALLO %s [%zu]: %.9g vs %.9g\n", what.c_str(), i, a, b);
+            return;
+        }
+    }
+}
+
+// Cuenta operator new y allocate del allocator durante reps llamadas a fn. Con el profiler
+// (TENSOR_PROFILE) cada operacion guarda un evento en el heap: solo se cuenta el allocator.
+template <typename F>
+void expect_no_allocs(const std::string& what, int reps, F fn) {
+    CountingAllocator counting;
+    set_default_allocator(&counting);
+    const long before = heap_allocs;
+    for (int r = 0; r < reps; ++r) fn();
+#ifdef TENSOR_PROFILE
+    const long news = 0;
+    (void)before;
+#else
+    const long news = heap_allocs - before;
+#endif
+    set_default_allocator(nullptr);
+    ++checks;
+    if (news != 0 || counting.count != 0) {
+        ++failures;
+        std::printf("FALLO %s: %ld operator new y %ld allocate en %d run()\n", what.c_str(), news, counting.count, reps);
+    }
+}
+
+// Red de main.cpp: view -> matmul + bias -> ReLU -> linear con Sigmoid.
+template <typename T>
+void check_mlp(const char* type, bool fusion) {
+    typedef BasicTensor<T> Tn;
+    const std::string tag = std::string(type) + (fusion ? " mlp fusion" : " mlp sin fusion");
+    ReLU relu;
+    Sigmoid sigmoid;
+    const std::size_t m = 150;                  // 150 x 400 x 100: gemm en paralelo con 3 hilos
+    const Tn W1 = Tn::random({400, 100}, T(-0.5), T(0.5)), b1 = Tn::random({1, 100}, T(-0.1), T(0.1));
+    const Tn W2 = Tn::random({100, 10}, T(-0.5), T(0.5)), b2 = Tn::random({10}, T(-0.1), T(0.1));
+
+    graph::Graph<T> g;
+    g.set_fusion(fusion);
+    graph::Value<T> x = g.input({m, 20, 20});
+    graph::Value<T> w1 = g.constant(W1), B1 = g.constant(b1), w2 = g.constant(W2), B2 = g.constant(b2);
+    graph::Value<T> h = (graph::matmul(x.view({m, 400}), w1) + B1).apply(relu);
+    g.output(graph::linear(h, w2, B2, &sigmoid));
+    g.compile();
+    expect(g.arena_bytes() <= g.naive_bytes(), tag + ": arena_bytes <= naive_bytes");
+
+    for (int rep = 0; rep < 2; ++rep) {
+        const Tn X = Tn::random({m, 20, 20}, T(0), T(1));
+        const Tn ref = linear(Tn((matmul(X.view({m, 400}), W1) + b1)).apply(relu), W2, b2, &sigmoid);
+        expect_close(tag + " run " + std::to_string(rep), g.run(X), ref);
+    }
+    const Tn X = Tn::random({m, 20, 20}, T(0), T(1));
+    expect_no_allocs(tag + " sin memoria", 3, [&] { g.run(X); });
+}
+
+// Cadena elemento a elemento con broadcast (normalizacion), un intermedio con dos usos,
+// unsqueeze, concat y dos salidas.
+template <typename T>
+void check_chain(const char* type, bool fusion) {
+    typedef BasicTensor<T> Tn;
+    const std::string tag = std::string(type) + (fusion ? " cadena fusion" : " cadena sin fusion");
+    Tanh tanh_op;
+    const std::size_t m = 1000, n = 33;         // concat de 66000 elementos: en paralelo
+    const Tn Mu = Tn::random({1, n}, T(-1), T(1)), Inv = Tn::random({1, n}, T(0.5), T(2));
+    const Tn Gamma = Tn::random({n}, T(0.5), T(1.5)), Beta = Tn::random({n}, T(-0.2), T(0.2));
+
+    graph::Graph<T> g;
+    g.set_fusion(fusion);
+    graph::Value<T> x = g.input({m, n}), r = g.input({m, n});
+    graph::Value<T> mu = g.constant(Mu), inv = g.constant(Inv), gamma = g.constant(Gamma), beta = g.constant(Beta);
+    graph::Value<T> y = ((((x - mu) * inv) * gamma + beta) * 0.5).apply(tanh_op);
+    graph::Value<T> z = y * r;                               // dos usos: no se absorbe
+    graph::Value<T> w = z + z * 2.0 - r;
+    g.output(graph::concat(std::vector<graph::Value<T> >{w.unsqueeze(0), y.unsqueeze(0)}, 0));
+    g.output(z);
+    g.compile();
+    expect(g.arena_bytes() <= g.naive_bytes(), tag + ": arena_bytes <= naive_bytes");
+
+    const Tn X = Tn::random({m, n}, T(-2), T(2)), R = Tn::random({m, n}, T(-1), T(1));
+    const Tn Y = Tn(((((X - Mu) * Inv) * Gamma + Beta) * 0.5)).apply(tanh_op);
+    const Tn Z = Y * R;
+    const Tn W = Z + Z * 2.0 - R;
+    const Tn ref0 = Tn::concat({W.unsqueeze(0), Y.unsqueeze(0)}, 0);
+    const std::vector<Tn> inputs = {X, R};
+    g.run(inputs);
+    expect_close(tag + " salida 0", g.output(0), ref0);
+    expect_close(tag + " salida 1", g.output(1), Z);
+    expect_no_allocs(tag + " sin memoria", 3, [&] { g.run(inputs); });
+}
+
+template <typename T>
+void check_fusion_kernels(const char* type) {
+    typedef BasicTensor<T> Tn;
+    const Tn B = Tn::random({1, 8}, T(-1), T(1));
+    std::size_t kernels[2];
+    for (int f = 0; f < 2; ++f) {
+        graph::Graph<T> g;
+        g.set_fusion(f == 1);
+        graph::Value<T> x = g.input({4, 8});
+        graph::Value<T> b = g.constant(B);
+        g.output(((x + b) * x - b) * 3.0);
+        g.compile();
+        kernels[f] = g.num_kernels();
+    }
+    expect(kernels[0] == 4 && kernels[1] == 1, std::string(type) + " num_kernels: 4 sin fusion, 1 con fusion");
+}
+
+template <typename T>
+void check_all(const char* type) {
+    for (int fusion = 0; fusion < 2; ++fusion) {
+        check_mlp<T>(type, fusion == 1);
+        check_chain<T>(type, fusion == 1);
+    }
+    check_fusion_kernels<T>(type);
+}
+
+}
+
+void* operator new(std::size_t bytes) {
+    ++heap_allocs;
+    void* p = std::malloc(bytes > 0 ? bytes : 1);
+    if (p == nullptr) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+int main() {
+    rng::manual_seed(2013);
+    const std::size_t threads[] = {1, 3};
+    for (std::size_t t : threads) {
+        parallel::set_num_threads(t);
+        check_all<double>("f64");
+        check_all<float>("f32");
+    }
+    parallel::set_num_threads(0);
+    std::printf("graph_check: %zu comprobaciones, %zu fallos\n", checks, failures);
+    return failures == 0 ? 0 : 1;
+}
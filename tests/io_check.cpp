@@ -0,0 +1,147 @@
+//
+// Comprueba los archivos .tensor (TensorIO.cpp): save -> load / mmap_load devuelve los mismos
+// valores (shapes de distinto rank, vistas no contiguas, f64 y f32), y un archivo dañado
+// lanza std::runtime_error en vez de devolver datos:
+//   - un byte de datos cambiado: load y mmap_load(path, true) fallan por checksum;
+//   - el archivo cortado en cualquier punto (cabecera, dims, datos) falla en load y mmap_load;
+//   - otro dtype falla.
+// Ademas, escribir en un tensor de mmap_load no modifica el archivo.
+//
+// Uso: CS2013_Tensor_IOCheck (sale con 1 si alguna comprobacion falla). Escribe y borra
+// io_check.tensor en el directorio actual.
+//
+
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "include/Tensor.h"
+#include "include/TensorIO.h"
+
+namespace {
+
+std::size_t checks = 0;
+std::size_t failures = 0;
+
+const char* const PATH = "io_check.tensor";
+
+void expect(bool ok, const std::string& what) {
+    ++checks;
+    if (!ok) {
+        ++failures;
+        std::printf("FALLO %s\n", what.c_str());
+    }
+}
+
+template <typename T>
+bool same(const BasicTensor<T>& a, const BasicTensor<T>& b) {
+    if (a.shape() != b.shape()) return false;
+    const BasicTensor<T> x = a.contiguous(), y = b.contiguous();
+    for (std::size_t i = 0; i < x.numel(); ++i)
+        if (x.data()[i] != y.data()[i]) return false;
+    return true;
+}
+
+std::vector<unsigned char> read_file() {
+    std::vector<unsigned char> bytes;
+    std::FILE* f = std::fopen(PATH, "rb");
+    if (f == nullptr) return bytes;
+    unsigned char buf[4096];
+    std::size_t n;
+    while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0) bytes.insert(bytes.end(), buf, buf + n);
+    std::fclose(f);
+    return bytes;
+}
+
+void write_file(const std::vector<unsigned char>& bytes, std::size_t n) {
+    std::FILE* f = std::fopen(PATH, "wb");
+    if (f == nullptr) throw std::runtime_error("io_check: no se pudo escribir " + std::string(PATH));
+    std::fwrite(bytes.data(), 1, n, f);
+    std::fclose(f);
+}
+
+// fn tiene que lanzar std::runtime_error.
+template <typename F>
+void expect_throw(const std::string& what, F fn) {
+    bool thrown = false;
+    try {
+        fn();
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    expect(thrown, what + ": lanza runtime_error");
+}
+
+template <typename T>
+void check_roundtrip(const std::string& tag, const BasicTensor<T>& t) {
+    t.save(PATH);
+    expect(same(BasicTensor<T>::load(PATH), t), tag + " load");
+    expect(same(BasicTensor<T>::mmap_load(PATH), t), tag + " mmap_load");
+    expect(same(BasicTensor<T>::mmap_load(PATH, true), t), tag + " mmap_load con checksum");
+}
+
+template <typename T>
+void check_damaged(const char* type) {
+    typedef BasicTensor<T> Tn;
+    const std::string tag = type;
+    const Tn t = Tn::random({7, 5, 3}, T(-1), T(1));
+    t.save(PATH);
+    const std::vector<unsigned char> good = read_file();
+    const std::size_t data_offset = good.size() - t.numel() * sizeof(T);
+
+    // Escribir en el tensor mapeado (MAP_PRIVATE) no toca el archivo.
+    {
+        Tn m = Tn::mmap_load(PATH);
+        m *= 2.0;
+        expect(read_file() == good, tag + " escribir en mmap_load no modifica el archivo");
+        expect(same(Tn::load(PATH), t), tag + " el archivo sigue igual tras escribir en mmap_load");
+    }
+
+    std::vector<unsigned char> bad = good;
+    bad[data_offset + 13] ^= 0x40;
+    write_file(bad, bad.size());
+    expect_throw(tag + " checksum: load", [] { Tn::load(PATH); });
+    expect_throw(tag + " checksum: mmap_load(path, true)", [] { Tn::mmap_load(PATH, true); });
+
+    const std::size_t cuts[] = {0, 7, io::HEADER_FIXED_BYTES - 1, io::HEADER_FIXED_BYTES + 8,
+                                data_offset - 1, data_offset, data_offset + 1, good.size() - 1};
+    for (std::size_t n : cuts) {
+        write_file(good, n);
+        const std::string what = tag + " truncado a " + std::to_string(n) + " bytes";
+        expect_throw(what + ": load", [] { Tn::load(PATH); });
+        expect_throw(what + ": mmap_load", [] { Tn::mmap_load(PATH); });
+    }
+
+    write_file(good, good.size());
+    if (sizeof(T) == sizeof(double)) {
+        expect_throw(tag + " dtype distinto: load", [] { FloatTensor::load(PATH); });
+        expect_throw(tag + " dtype distinto: mmap_load", [] { FloatTensor::mmap_load(PATH); });
+    } else {
+        expect_throw(tag + " dtype distinto: load", [] { Tensor::load(PATH); });
+        expect_throw(tag + " dtype distinto: mmap_load", [] { Tensor::mmap_load(PATH); });
+    }
+}
+
+template <typename T>
+void check_all(const char* type) {
+    typedef BasicTensor<T> Tn;
+    const std::string tag = type;
+    check_roundtrip(tag + " (1)", Tn::random({1}, T(-1), T(1)));
+    check_roundtrip(tag + " (13)", Tn::random({13}, T(-1), T(1)));
+    check_roundtrip(tag + " (37 x 11)", Tn::random({37, 11}, T(-1), T(1)));
+    check_roundtrip(tag + " (2 x 3 x 5 x 7)", Tn::random({2, 3, 5, 7}, T(-1), T(1)));
+    check_roundtrip(tag + " transpuesta", Tn::random({9, 16}, T(-1), T(1)).transpose());
+    check_roundtrip(tag + " slice", Tn::random({10, 12}, T(-1), T(1)).slice(1, 3, 9));
+    check_damaged<T>(type);
+}
+
+}
+
+int main() {
+    rng::manual_seed(2013);
+    check_all<double>("f64");
+    check_all<float>("f32");
+    std::remove(PATH);
+    std::printf("io_check: %zu comprobaciones, %zu fallos\n", checks, failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,201 @@
+//
+// Comprueba la ruta int8 (TensorQuant.h) contra linear/matmul en punto flotante.
+//
+// quantize garantiza |x - dequantize(x)| <= scale / 2 en cada grupo, asi que para cada
+// elemento de la salida (i, j), con hx = sx_i / 2 y hw = sw_j / 2:
+//   |y - y_q| <= sum_k (hx |w_kj| + |x_ik| hw + hx hw) + (k + 8) eps_T sum_k |x_ik| |w_kj|
+// (el ultimo termino cubre el redondeo de linear y del epilogo; ReLU no lo agranda).
+// forward_quantized suma la media escala de salida. Los tamaños cubren k impar, n que no es
+// multiplo de 16 (NR) y m que no es multiplo de 6 (MR).
+//
+// Uso: CS2013_Tensor_QuantCheck (sale con 1 si alguna comprobacion falla).
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <string>
+#include <vector>
+#include "include/Tensor.h"
+#include "include/TensorQuant.h"
+#include "include/TensorTransform.h"
+
+namespace {
+
+using quant::Axis;
+using quant::QTensor;
+
+// Holgura relativa sobre scale / 2: la escala se guarda como float.
+const double SCALE_SLACK = 1.0 + 1e-5;
+
+std::size_t checks = 0;
+std::size_t failures = 0;
+
+const char* axis_name(Axis a) {
+    return a == Axis::Row ? "row" : (a == Axis::Column ? "column" : "tensor");
+}
+
+void fail(const std::string& what, std::size_t i, std::size_t j, double got, double ref, double tol) {
+    if (++failures <= 20) {
+        std::printf("FALLO %s (%zu, %zu): %.9g vs %.9g, |dif| %.3g > tol %.3g\n",
+                    what.c_str(), i, j, got, ref, std::abs(got - ref), tol);
+    }
+}
+
+double half_scale(const QTensor& q, std::size_t i, std::size_t j) {
+    return 0.5 * q.scales()[q.group(i, j)] * SCALE_SLACK;
+}
+
+// Cota por elemento de |x * W - x_q * W_q| (mas |b| por el redondeo del bias).
+template <typename T>
+std::vector<double> error_bound(const BasicTensor<T>& x, const QTensor& xq,
+                                const BasicTensor<T>& w, const QTensor& wq, const BasicTensor<T>* b) {
+    const std::size_t m = x.shape()[0], k = x.shape()[1], n = w.shape()[1];
+    const double rel = double(k + 8) * std::numeric_limits<T>::epsilon();
+    std::vector<double> bound(m * n);
+    for (std::size_t i = 0; i < m; ++i) {
+        for (std::size_t j = 0; j < n; ++j) {
+            const double hx = half_scale(xq, i, 0), hw = half_scale(wq, 0, j);
+            double quant_err = 0.0, mag = b == nullptr ? 0.0 : std::abs(double(b->data()[j]));
+            for (std::size_t kk = 0; kk < k; ++kk) {
+                const double ax = std::abs(double(x(i, kk))), aw = std::abs(double(w(kk, j)));
+                quant_err += hx * aw + ax * hw + hx * hw;
+                mag += ax * aw;
+            }
+            bound[i * n + j] = quant_err + rel * (mag + quant_err);
+        }
+    }
+    return bound;
+}
+
+template <typename T>
+void expect_close(const std::string& what, const BasicTensor<T>& got, const BasicTensor<T>& ref,
+                  const std::vector<double>& bound, double extra) {
+    ++checks;
+    if (got.dims() != 2 || got.shape()[0] != ref.shape()[0] || got.shape()[1] != ref.shape()[1]) {
+        ++failures;
+        std::printf("FALLO %s: shape distinta\n", what.c_str());
+        return;
+    }
+    const std::size_t n = ref.shape()[1];
+    for (std::size_t i = 0; i < ref.shape()[0]; ++i) {
+        for (std::size_t j = 0; j < n; ++j) {
+            const double g = got(i, j), r = ref(i, j), tol = bound[i * n + j] + extra;
+            if (!(std::abs(g - r) <= tol)) {
+                fail(what, i, j, g, r, tol);
+                return;
+            }
+        }
+    }
+}
+
+template <typename T>
+void check_roundtrip(const std::string& tag, const BasicTensor<T>& x) {
+    for (Axis axis : {Axis::Tensor, Axis::Row, Axis::Column}) {
+        for (bool sym : {false, true}) {
+            const QTensor q = quant::quantize(x, axis, sym);
+            const BasicTensor<T> d = quant::dequantize<T>(q);
+            const std::string what = tag + " roundtrip " + axis_name(axis) + (sym ? " sim" : " asim");
+            ++checks;
+            for (std::size_t i = 0; i < q.rows(); ++i) {
+                for (std::size_t j = 0; j < q.cols(); ++j) {
+                    const double tol = half_scale(q, i, j) + 4 * std::numeric_limits<T>::epsilon() * std::abs(double(x(i, j)));
+                    if (!(std::abs(double(d(i, j)) - double(x(i, j))) <= tol)) {
+                        fail(what, i, j, d(i, j), x(i, j), tol);
+                        i = q.rows();
+                        break;
+                    }
+                }
+            }
+        }
+    }
+}
+
+template <typename T>
+void check_case(const char* type, std::size_t m, std::size_t k, std::size_t n) {
+    char buf[64];
+    std::snprintf(buf, sizeof(buf), "%s m=%zu k=%zu n=%zu", type, m, k, n);
+    const std::string tag = buf;
+    typedef BasicTensor<T> Tn;
+
+    const Tn x = Tn::random({m, k}, T(-1), T(3));
+    const Tn w = Tn::random({k, n}, T(-0.5), T(0.5));
+    const Tn wa = Tn::random({k, n}, T(-0.2), T(0.8));      // zero points distintos de 0
+    const Tn b = Tn::random({n}, T(-0.1), T(0.1));
+    check_roundtrip(tag + " x", x);
+    check_roundtrip(tag + " W", wa);
+
+    // QLinear(W, b, act): W simetrico por columna, x asimetrico por fila al vuelo.
+    ReLU relu;
+    const quant::QLinear<T> layer(w, b, &relu);
+    const QTensor w_col = quant::quantize(w, Axis::Column, true);
+    const QTensor x_row = quant::quantize(x, Axis::Row);
+    const QTensor x_ten = quant::quantize(x, Axis::Tensor);
+    const Tn ref = linear(x, w, b, &relu);
+    const std::vector<double> bound_row = error_bound(x, x_row, w, w_col, &b);
+
+    const Tn out = layer.forward(x);
+    expect_close(tag + " QLinear::forward(x)", out, ref, bound_row, 0.0);
+    Tn out_q;
+    layer.forward(x_row, out_q);
+    expect_close(tag + " QLinear::forward(x fila)", out_q, ref, bound_row, 0.0);
+    layer.forward(x_ten, out_q);
+    expect_close(tag + " QLinear::forward(x tensor)", out_q, ref, error_bound(x, x_ten, w, w_col, &b), 0.0);
+
+    // Vista transpuesta como entrada.
+    const Tn xt = Tn::random({k, m}, T(-1), T(3)).transpose();
+    expect_close(tag + " QLinear::forward(vista)", layer.forward(xt), linear(xt, w, b, &relu),
+                 error_bound(xt, quant::quantize(xt, Axis::Row), w, w_col, &b), 0.0);
+
+    // forward_quantized: escala de salida que cubre la referencia mas la cota.
+    double lo = 0.0, hi = 0.0, max_bound = 0.0;
+    for (std::size_t i = 0; i < m * n; ++i) max_bound = std::max(max_bound, bound_row[i]);
+    for (std::size_t i = 0; i < m; ++i) {
+        for (std::size_t j = 0; j < n; ++j) {
+            lo = std::min(lo, double(ref(i, j)) - max_bound);
+            hi = std::max(hi, double(ref(i, j)) + max_bound);
+        }
+    }
+    const float out_scale = float((hi - lo) / 255.0);
+    const int out_zero = int(std::min(127.0, std::max(-128.0, std::nearbyint(-128.0 - lo / out_scale))));
+    const QTensor y_q = layer.forward_quantized(x_row, out_scale, out_zero);
+    expect_close(tag + " QLinear::forward_quantized", quant::dequantize<T>(y_q), ref, bound_row,
+                 0.5 * out_scale * SCALE_SLACK);
+
+    // W ya cuantizado (por columna / por tensor, simetrico / asimetrico) y quant::matmul.
+    const Tn ref_mm = matmul(x, wa);
+    const Tn ref_lin = linear(x, wa, b, static_cast<const TensorTransform*>(nullptr));
+    for (Axis axis : {Axis::Column, Axis::Tensor}) {
+        for (bool sym : {false, true}) {
+            const QTensor wq = quant::quantize(wa, axis, sym);
+            const std::string mode = std::string(" W ") + axis_name(axis) + (sym ? " sim" : " asim");
+            const quant::QLinear<T> qlayer(wq, b);
+            qlayer.forward(x_row, out_q);
+            expect_close(tag + " QLinear(QTensor, b)" + mode, out_q, ref_lin, error_bound(x, x_row, wa, wq, &b), 0.0);
+            expect_close(tag + " quant::matmul x fila" + mode, quant::matmul<T>(x_row, wq), ref_mm,
+                         error_bound(x, x_row, wa, wq, static_cast<const Tn*>(nullptr)), 0.0);
+            expect_close(tag + " quant::matmul x tensor" + mode, quant::matmul<T>(x_ten, wq), ref_mm,
+                         error_bound(x, x_ten, wa, wq, static_cast<const Tn*>(nullptr)), 0.0);
+        }
+    }
+}
+
+template <typename T>
+void check_all(const char* type) {
+    // (m, k, n): k impar, n no multiplo de 16, m no multiplo de 6.
+    const std::size_t sizes[][3] = {
+        {1, 1, 1}, {7, 3, 17}, {13, 31, 33}, {5, 65, 1}, {50, 97, 45}, {1, 129, 100}, {23, 257, 9}
+    };
+    for (const auto& s : sizes) check_case<T>(type, s[0], s[1], s[2]);
+}
+
+}
+
+int main() {
+    rng::manual_seed(2013);
+    check_all<double>("f64");
+    check_all<float>("f32");
+    std::printf("quant_check: %zu comprobaciones, %zu fallos\n", checks, failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,79 @@
+//
+// Comprueba Tensor::random (TensorRandom.cpp):
+//   - todos los valores quedan en [min, max), tambien en rangos estrechos donde
+//     min + (max - min) * u redondea a max (float en [1000, 1001));
+//   - la media de U[-1, 1) esta cerca de 0;
+//   - con la misma semilla el resultado no depende del numero de hilos.
+//
+// Uso: CS2013_Tensor_RandomCheck (sale con 1 si alguna comprobacion falla).
+//
+
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <string>
+#include "include/Tensor.h"
+#include "include/TensorParallel.h"
+
+namespace {
+
+std::size_t checks = 0;
+std::size_t failures = 0;
+
+void expect(bool ok, const std::string& what) {
+    ++checks;
+    if (!ok) {
+        ++failures;
+        std::printf("FALLO %s\n", what.c_str());
+    }
+}
+
+template <typename T>
+void check_range(const char* type, T lo, T hi) {
+    const std::size_t n = 1 << 20;
+    const BasicTensor<T> t = BasicTensor<T>::random({n}, lo, hi);
+    std::size_t outside = 0;
+    for (std::size_t i = 0; i < n; ++i) outside += !(t.data()[i] >= lo && t.data()[i] < hi);
+    char buf[128];
+    std::snprintf(buf, sizeof(buf), "%s random en [%.17g, %.17g): %zu valores fuera", type, double(lo), double(hi), outside);
+    expect(outside == 0, buf);
+}
+
+template <typename T>
+void check_all(const char* type) {
+    check_range<T>(type, T(1000), T(1001));
+    check_range<T>(type, T(-1), T(1));
+    check_range<T>(type, T(0), std::nextafter(T(0), T(1)));
+    check_range<T>(type, T(1), T(1) + 4 * std::numeric_limits<T>::epsilon());
+    check_range<T>(type, T(-1e6) * (1 + 8 * std::numeric_limits<T>::epsilon()), T(-1e6));
+
+    const std::size_t n = 1 << 20;
+    const BasicTensor<T> u = BasicTensor<T>::random({n}, T(-1), T(1));
+    double mean = 0.0;
+    for (std::size_t i = 0; i < n; ++i) mean += u.data()[i];
+    mean /= double(n);
+    // Desvio de la media de n U[-1, 1): 1 / sqrt(3 n); 6 desvios.
+    expect(std::abs(mean) < 6.0 / std::sqrt(3.0 * double(n)), std::string(type) + " media de U[-1, 1) cerca de 0");
+
+    BasicTensor<T> by_threads[2];
+    const std::size_t threads[] = {1, 3};
+    for (int k = 0; k < 2; ++k) {
+        parallel::set_num_threads(threads[k]);
+        rng::manual_seed(7);
+        by_threads[k] = BasicTensor<T>::random({333, 1001}, T(-2), T(3));
+    }
+    parallel::set_num_threads(0);
+    bool same = true;
+    for (std::size_t i = 0; i < by_threads[0].numel(); ++i) same = same && by_threads[0].data()[i] == by_threads[1].data()[i];
+    expect(same, std::string(type) + " misma semilla con 1 y 3 hilos da el mismo tensor");
+}
+
+}
+
+int main() {
+    rng::manual_seed(2013);
+    check_all<double>("f64");
+    check_all<float>("f32");
+    std::printf("random_check: %zu comprobaciones, %zu fallos\n", checks, failures);
+    return failures == 0 ? 0 : 1;
+}